@@ -24,7 +24,59 @@
 #include"hostconstants.h"
 #include"thrust/reduce.h"
 #include"thrust/count.h"
+#include"thrust/gather.h"
+#include"thrust/sort.h"
+#include"thrust/binary_search.h"
+#include"thrust/iterator/zip_iterator.h"
 #include"fstream"
+#include"numeric"
+#include"algorithm"
+#include"cmath"
+
+// Neighbors of a new community come out in the order in which threads won
+// the hash table slots; sort each neighborhood by id so the next level
+// always gets the same CSR (deterministic mode)
+
+static void sortNeighborhoods(GraphGPU& g) {
+
+	if (!g.nb_links)
+		return;
+
+	// owner[i] = 1 + vertex whose neighborhood holds position i
+	thrust::device_vector<int> owner(g.nb_links);
+	thrust::upper_bound(thrust::device, g.indices.begin(), g.indices.end(),
+			thrust::counting_iterator<int>(0), thrust::counting_iterator<int>(g.nb_links),
+			owner.begin());
+
+	// Two stable sorts: by neighbor, then by owner
+	thrust::stable_sort_by_key(thrust::device, g.links.begin(), g.links.end(),
+			thrust::make_zip_iterator(thrust::make_tuple(g.weights.begin(), owner.begin())));
+	thrust::stable_sort_by_key(thrust::device, owner.begin(), owner.end(),
+			thrust::make_zip_iterator(thrust::make_tuple(g.links.begin(), g.weights.begin())));
+}
+
+// Deterministic mode: a table slot of new community c sums links of its
+// members, at most tot(c), so the largest tot bounds every slot
+
+static double largestCommunityWeight(thrust::device_vector<int>& n2c, thrust::device_vector<int>& n2c_new,
+		thrust::device_vector<float>& wDegs, int nrNewComm, double totalWeight) {
+
+	float scale = fixedPointScale(totalWeight);
+
+	thrust::device_vector<int> commOf(n2c.size());
+	thrust::gather(thrust::device, n2c.begin(), n2c.end(), n2c_new.begin(), commOf.begin());
+
+	thrust::device_vector<unsigned long long> sums(nrNewComm, 0);
+	int nr_of_block = (n2c.size() + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+	accumulateFixedPoint << <nr_of_block, NR_THREAD_PER_BLOCK>>>(n2c.size(),
+			thrust::raw_pointer_cast(commOf.data()),
+			thrust::raw_pointer_cast(wDegs.data()), scale,
+			thrust::raw_pointer_cast(sums.data()));
+
+	unsigned long long largest = thrust::reduce(sums.begin(), sums.end(), (unsigned long long) 0,
+			thrust::maximum<unsigned long long>());
+	return (double) largest / scale;
+}
 
 void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 		cudaEvent_t &start, cudaEvent_t &stop) {
@@ -33,10 +85,8 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 
 	int new_nb_comm = g_next.nb_nodes;
 
-	bool hostPrint = false;
-	int sc;
-	sc = 0; //std::cin>>sc;
-	hostPrint = (sc > 1);
+	memory.beginPhase(level, "contract");
+
 
 
 	//cudaEvent_t start, stop;
@@ -45,32 +95,13 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 
 
 
-	//Save a copy of "pos_ptr_of_new_comm"
-
-	thrust::device_vector<int> super_node_ptrs(pos_ptr_of_new_comm);
-	/*
-	   if (hostPrint) {
-	   print_vector(super_node_ptrs, "Super Node Ptrs: ");
-	   print_vector(n2c_new, " n2c_new; before group_nodes_based_on_new_CID");
-	   }
-	 */
-	//Place nodes of same community together
-
-	comm_nodes.resize(g.nb_nodes);
-	cudaEventRecord(start, 0);
-	int load_per_blk = CHUNK_PER_WARP * (NR_THREAD_PER_BLOCK / PHY_WRP_SZ);
-	int nr_of_block = (community_size + load_per_blk - 1) / load_per_blk;
-
-	group_nodes_based_on_new_CID << < nr_of_block, NR_THREAD_PER_BLOCK>>>
-		(thrust::raw_pointer_cast(comm_nodes.data()),
-		 thrust::raw_pointer_cast(pos_ptr_of_new_comm.data()),
-		 thrust::raw_pointer_cast(n2c_new.data()),
-		 thrust::raw_pointer_cast(n2c.data()), g.nb_nodes);
-
+	// gatherStatistics has already grouped the nodes of each new community
+	// into comm_nodes; take over its pointers
 
-	report_time(start, stop, "group_nodes_based_on_new_CID");
+	thrust::device_vector<int> super_node_ptrs;
+	super_node_ptrs.swap(pos_ptr_of_new_comm);
 
-	this->pos_ptr_of_new_comm.clear();
+	int nr_of_block = 0;
 
 	//////////////////////////////////////////////////////////////////////////////
 
@@ -272,7 +303,6 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 	 */
 
 
-	sc = 0; //std::cin>>sc;
 	//Sort according to size of neighborhood ; only first nrCforBlkGbMem
 	if ((nrCforBlkGbMem + nrCforBlkShMem) > 0) {
 
@@ -297,7 +327,6 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 	   }
 	 */
 
-	sc = 0; //std::cin>>sc;
 	int nrBlockForLargeNhoods = 150;
 
 	nrBlockForLargeNhoods = thrust::min(thrust::max(nrCforBlkGbMem, nrCforBlkShMem), nrBlockForLargeNhoods);
@@ -386,14 +415,12 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 	   esSizes.clear();
 	   }
 	 */
-	thrust::device_vector<HashItem> globalHashTable(hashTablePtrs.back());
-	/*********************/
-	// thrust::device_vector<HashItem> globalHashTable(3 * hashTablePtrs.back());
-
-	int szHTmem = thrust::reduce(g_next.links.begin(),
-			g_next.links.begin() + nrBlockForLargeNhoods, (int) 0);
-
-	//std::cout << globalHashTable.size() << ":" << 2 * szHTmem << std::endl;
+	// Dense accumulators for the largest new communities, one table of
+	// new_nb_comm slots for each of the first nrDenseTables blocks
+	int nrDenseTables = 0;
+	if (nrCforBlkGbMem > 0 && new_nb_comm > 1)
+		nrDenseTables = (int) thrust::min((size_t) nrBlockForLargeNhoods,
+				denseTableBudget / (tableItemSize(deterministic) * new_nb_comm));
 
 	//-------Prefix sum on estimate the size of neighborhoods to determine global positions for new communities-----//
 
@@ -414,15 +441,92 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 	   std::cout << "Before big allocation; UpperBoundOnTotalSize = " << upperBoundonTotalSize << std::endl;
 	 */
 
+	//--------------Fit tables and neighbor lists into the memory budget-------------//
+
+	std::vector<int> tablePrefix(nrBlockForLargeNhoods + 1);
+	thrust::copy(hashTablePtrs.begin(), hashTablePtrs.end(), tablePrefix.begin());
+
+	int memoryStrategy = MEM_DEFAULT;
+	size_t listItems = upperBoundonTotalSize;
+	size_t predictedPeak = predictContractPeak(g.nb_nodes, new_nb_comm, tablePrefix[nrBlockForLargeNhoods],
+			nrDenseTables, listItems, upperBoundonTotalSize, false, keepDendrogram, deterministic);
+
+	if (!memory.fits(predictedPeak) && nrDenseTables > 0) {
+		memoryStrategy = MEM_FEWER_BLOCKS;
+		nrDenseTables = 0;
+		predictedPeak = predictContractPeak(g.nb_nodes, new_nb_comm, tablePrefix[nrBlockForLargeNhoods],
+				nrDenseTables, listItems, upperBoundonTotalSize, false, keepDendrogram, deterministic);
+	}
+
+	// Upper-bound sized lists don't fit: count exact neighborhoods chunk by
+	// chunk first, then write each chunk again straight to its final place
+	std::vector<int> hostStarts;
+	int largestEstimate = 0;
+	if (!memory.fits(predictedPeak) && new_nb_comm > 1) {
+		memoryStrategy = MEM_CHUNKED;
+		hostStarts.resize(new_nb_comm + 1);
+		thrust::copy(estimatedSizeOfNeighborhoods.begin(), estimatedSizeOfNeighborhoods.end(), hostStarts.begin());
+		for (int c = 0; c < new_nb_comm; c++)
+			largestEstimate = std::max(largestEstimate, hostStarts[c + 1] - hostStarts[c]);
+	}
+
+	while (memoryStrategy == MEM_CHUNKED) {
+		size_t fixedPart = predictContractPeak(g.nb_nodes, new_nb_comm, tablePrefix[nrBlockForLargeNhoods],
+				nrDenseTables, 0, upperBoundonTotalSize, true, keepDendrogram, deterministic);
+		listItems = (memory.available() > fixedPart) ? (memory.available() - fixedPart) / (sizeof (unsigned int) + sizeof (float)) : 0;
+		listItems = std::min((size_t) upperBoundonTotalSize, std::max((size_t) largestEstimate, listItems));
+		predictedPeak = predictContractPeak(g.nb_nodes, new_nb_comm, tablePrefix[nrBlockForLargeNhoods],
+				nrDenseTables, listItems, upperBoundonTotalSize, true, keepDendrogram, deterministic);
+
+		if (memory.fits(predictedPeak) || nrBlockForLargeNhoods <= 1)
+			break;
+		nrBlockForLargeNhoods = (nrBlockForLargeNhoods + 1) / 2;
+	}
+	if (!memory.fits(predictedPeak))
+		LOG(LOG_WARN, "Level " << level << ": contraction needs " << (predictedPeak >> 20)
+				<< " MB, over the memory budget (" << (memory.available() >> 20) << " MB left)");
+
+	// Chunk k covers new communities [chunkBounds[k], chunkBounds[k+1])
+	std::vector<int> chunkBounds(1, 0);
+	if (memoryStrategy == MEM_CHUNKED) {
+		while (chunkBounds.back() < new_nb_comm) {
+			int c0 = chunkBounds.back();
+			int c1 = std::upper_bound(hostStarts.begin() + c0 + 1, hostStarts.begin() + new_nb_comm + 1,
+					hostStarts[c0] + (int) listItems) - hostStarts.begin() - 1;
+			chunkBounds.push_back(std::max(c1, c0 + 1));
+		}
+	} else {
+		chunkBounds.push_back(new_nb_comm);
+	}
+	int nrChunks = chunkBounds.size() - 1;
+
+	if (deterministic) {
+		bool haveDegrees = (bundle.level == level && bundle.wDegs.size() == (size_t) g.nb_nodes);
+		double largestSlot = haveDegrees ?
+				largestCommunityWeight(n2c, n2c_new, bundle.wDegs, new_nb_comm, g.total_weight) : g.total_weight;
+		setTableGravityScale(fixedPointScale(largestSlot));
+	}
+
+	thrust::device_vector<long long> globalHashTable(tableWords(tablePrefix[nrBlockForLargeNhoods], deterministic), 0);
+	thrust::device_vector<long long> denseTables(tableWords((size_t) nrDenseTables * new_nb_comm, deterministic), 0);
 
 	//--------------Allocate memory for new links and weights-------------//
 
 
 	thrust::device_vector<unsigned int> member_count_per_new_comm(new_nb_comm + 1, 0); // exact count
 
-	thrust::device_vector<unsigned int> new_nighbor_lists(upperBoundonTotalSize);
-	thrust::device_vector<float> new_weight_lists(upperBoundonTotalSize);
+	thrust::device_vector<unsigned int> new_nighbor_lists(listItems);
+	thrust::device_vector<float> new_weight_lists(listItems);
 
+	// Candidates and list positions of the current chunk
+	thrust::device_vector<int> chunkCandidates;
+	thrust::device_vector<int> chunkStarts;
+	if (nrChunks > 1) {
+		chunkCandidates.resize(nrCforBlkGbMem + nrCforBlkShMem + nrCforWrp);
+		chunkStarts.resize(new_nb_comm + 1);
+	}
+
+	memory.sample();
 
 	//std::cout << "nrBlockForLargeNhoods: " << nrBlockForLargeNhoods << std::endl;
 	/*
@@ -431,109 +535,201 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 	   }
 
 	 */
-	wrpSz = PHY_WRP_SZ;
-	cudaEventRecord(start, 0);
-	if (nrCforBlkGbMem > 0)
-		findNewNeighodByBlock << < nrBlockForLargeNhoods, NR_THREAD_PER_BLOCK/*, 0, streams[0]*/>>>
-			(thrust::raw_pointer_cast(super_node_ptrs.data()),
-			 thrust::raw_pointer_cast(new_weight_lists.data()),
-			 thrust::raw_pointer_cast(new_nighbor_lists.data()),
-			 thrust::raw_pointer_cast(member_count_per_new_comm.data()), // puts zero in position zero for prefix sum
-			 thrust::raw_pointer_cast(g.indices.data()),
-			 thrust::raw_pointer_cast(g.weights.data()),
-			 thrust::raw_pointer_cast(g.links.data()),
-			 thrust::raw_pointer_cast(comm_nodes.data()), new_nb_comm,
-			 thrust::raw_pointer_cast(n2c.data()),
-			 thrust::raw_pointer_cast(n2c_new.data()),
-			 thrust::raw_pointer_cast(estimatedSizeOfNeighborhoods.data()),
-			 g.type, bucketSizePerWarp,
-			 thrust::raw_pointer_cast(g_next.indices.data()), //int* candidateComms
-			 nrCforBlkGbMem, //int nrCandidateComms
-			 thrust::raw_pointer_cast(globalHashTable.data()),
-			 thrust::raw_pointer_cast(hashTablePtrs.data()),
-			 thrust::raw_pointer_cast(devPrimes.data()), nb_prime, wrpSz);
-
-	report_time(start, stop, "findNewNeighodByBlock(GlobalMemory)");
-
-	/*
-	   int sum_MC = thrust::reduce(member_count_per_new_comm.begin(), member_count_per_new_comm.end(), (int) 0);
-	   std::cout << "sum_MC(blkGlb): " << sum_MC << std::endl;
-	 */
-
-	sc = 0; //std::cin>>sc;
-	cudaEventRecord(start, 0);
-	if (nrCforBlkShMem > 0)
-		findNewNeighodByBlock << < nrBlockForLargeNhoods, NR_THREAD_PER_BLOCK/*, 0, streams[1]*/>>>
-			(thrust::raw_pointer_cast(super_node_ptrs.data()),
-			 thrust::raw_pointer_cast(new_weight_lists.data()),
-			 thrust::raw_pointer_cast(new_nighbor_lists.data()),
-			 thrust::raw_pointer_cast(member_count_per_new_comm.data()), // puts zero in position zero for prefix sum
-			 thrust::raw_pointer_cast(g.indices.data()),
-			 thrust::raw_pointer_cast(g.weights.data()),
-			 thrust::raw_pointer_cast(g.links.data()),
-			 thrust::raw_pointer_cast(comm_nodes.data()), new_nb_comm,
-			 thrust::raw_pointer_cast(n2c.data()),
-			 thrust::raw_pointer_cast(n2c_new.data()),
-			 thrust::raw_pointer_cast(estimatedSizeOfNeighborhoods.data()),
-			 g.type, bucketSizePerWarp,
-			 thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGbMem, //int* candidateComms
-			 nrCforBlkShMem, //int nrCandidateComms
-			 thrust::raw_pointer_cast(globalHashTable.data()),
-			 thrust::raw_pointer_cast(hashTablePtrs.data()),
-			 thrust::raw_pointer_cast(devPrimes.data()), nb_prime, wrpSz);
-
-	report_time(start, stop, "findNewNeighodByBlock(SharedMemory)");
-	/*
-	   sum_MC = thrust::reduce(member_count_per_new_comm.begin(), member_count_per_new_comm.end(), (int) 0);
-
-	   std::cout << "sum_MC(blkShrd): " << sum_MC << std::endl;
-	 */
-
-
-
-
+	BlockContractKernel contractBlk = selectFindNewNeighodByBlock(g.type, genericKernels, deterministic);
+	WarpContractKernel contractWrp = selectDetermineNewNeighborhood(PHY_WRP_SZ, WARP_TABLE_SIZE_1, g.type, genericKernels, deterministic);
+
+	std::vector<int> exactStarts;
+	int nrPasses = (nrChunks > 1) ? 2 : 1;
+
+	for (int pass = 0; pass < nrPasses; pass++) {
+
+		if (pass == 1) {
+			// Exact sizes are known; lay out the next graph and fill it chunk by chunk
+			std::vector<unsigned int> counts(new_nb_comm + 1);
+			thrust::copy(member_count_per_new_comm.begin(), member_count_per_new_comm.end(), counts.begin());
+			exactStarts.resize(new_nb_comm + 1);
+			std::partial_sum(counts.begin(), counts.end(), exactStarts.begin());
+
+			g_next.links.resize(exactStarts[new_nb_comm]);
+			g_next.weights.resize(exactStarts[new_nb_comm]);
+			memory.sample();
+		}
+
+		for (int chunk = 0; chunk < nrChunks; chunk++) {
+
+			int c0 = chunkBounds[chunk], c1 = chunkBounds[chunk + 1];
+
+			int* candidates = thrust::raw_pointer_cast(g_next.indices.data());
+			int* starts = thrust::raw_pointer_cast(estimatedSizeOfNeighborhoods.data());
+			int nrGbMem = nrCforBlkGbMem, nrShMem = nrCforBlkShMem, nrWrp = nrCforWrp;
+
+			if (nrChunks > 1) {
+				// Keep each bin's candidates of this chunk in their (size) order
+				IsInRange<int, int> inChunk(c0, c1 - 1);
+				thrust::device_vector<int>::iterator tail = chunkCandidates.begin();
+				tail = thrust::copy_if(thrust::device, g_next.indices.begin(),
+						g_next.indices.begin() + nrCforBlkGbMem, tail, inChunk);
+				nrGbMem = tail - chunkCandidates.begin();
+				tail = thrust::copy_if(thrust::device, g_next.indices.begin() + nrCforBlkGbMem,
+						g_next.indices.begin() + nrCforBlkGbMem + nrCforBlkShMem, tail, inChunk);
+				nrShMem = (tail - chunkCandidates.begin()) - nrGbMem;
+				tail = thrust::copy_if(thrust::device, g_next.indices.begin() + nrCforBlkGbMem + nrCforBlkShMem,
+						g_next.indices.begin() + nrCforBlkGbMem + nrCforBlkShMem + nrCforWrp, tail, inChunk);
+				nrWrp = (tail - chunkCandidates.begin()) - nrGbMem - nrShMem;
+
+				thrust::transform(thrust::device, estimatedSizeOfNeighborhoods.begin(),
+						estimatedSizeOfNeighborhoods.end(), chunkStarts.begin(),
+						subtract_constant_functor<int>(hostStarts[c0]));
+
+				candidates = thrust::raw_pointer_cast(chunkCandidates.data());
+				starts = thrust::raw_pointer_cast(chunkStarts.data());
+			}
+
+			wrpSz = PHY_WRP_SZ;
+			cudaEventRecord(start, 0);
+			if (nrGbMem > 0)
+				contractBlk << < nrBlockForLargeNhoods, NR_THREAD_PER_BLOCK/*, 0, streams[0]*/>>>
+					(thrust::raw_pointer_cast(super_node_ptrs.data()),
+					 thrust::raw_pointer_cast(new_weight_lists.data()),
+					 thrust::raw_pointer_cast(new_nighbor_lists.data()),
+					 thrust::raw_pointer_cast(member_count_per_new_comm.data()), // puts zero in position zero for prefix sum
+					 thrust::raw_pointer_cast(g.indices.data()),
+					 thrust::raw_pointer_cast(g.weights.data()),
+					 thrust::raw_pointer_cast(g.links.data()),
+					 thrust::raw_pointer_cast(comm_nodes.data()), new_nb_comm,
+					 thrust::raw_pointer_cast(n2c.data()),
+					 thrust::raw_pointer_cast(n2c_new.data()),
+					 starts,
+					 g.type, bucketSizePerWarp,
+					 candidates, //int* candidateComms
+					 nrGbMem, //int nrCandidateComms
+					 thrust::raw_pointer_cast(globalHashTable.data()),
+					 thrust::raw_pointer_cast(hashTablePtrs.data()),
+					 thrust::raw_pointer_cast(devPrimes.data()), nb_prime, wrpSz,
+					 thrust::raw_pointer_cast(denseTables.data()), nrDenseTables);
+
+			report_time(start, stop, "findNewNeighodByBlock(GlobalMemory)");
+
+			/*
+			   int sum_MC = thrust::reduce(member_count_per_new_comm.begin(), member_count_per_new_comm.end(), (int) 0);
+			   std::cout << "sum_MC(blkGlb): " << sum_MC << std::endl;
+			 */
+
+			cudaEventRecord(start, 0);
+			if (nrShMem > 0)
+				contractBlk << < nrBlockForLargeNhoods, NR_THREAD_PER_BLOCK/*, 0, streams[1]*/>>>
+					(thrust::raw_pointer_cast(super_node_ptrs.data()),
+					 thrust::raw_pointer_cast(new_weight_lists.data()),
+					 thrust::raw_pointer_cast(new_nighbor_lists.data()),
+					 thrust::raw_pointer_cast(member_count_per_new_comm.data()), // puts zero in position zero for prefix sum
+					 thrust::raw_pointer_cast(g.indices.data()),
+					 thrust::raw_pointer_cast(g.weights.data()),
+					 thrust::raw_pointer_cast(g.links.data()),
+					 thrust::raw_pointer_cast(comm_nodes.data()), new_nb_comm,
+					 thrust::raw_pointer_cast(n2c.data()),
+					 thrust::raw_pointer_cast(n2c_new.data()),
+					 starts,
+					 g.type, bucketSizePerWarp,
+					 candidates + nrGbMem, //int* candidateComms
+					 nrShMem, //int nrCandidateComms
+					 thrust::raw_pointer_cast(globalHashTable.data()),
+					 thrust::raw_pointer_cast(hashTablePtrs.data()),
+					 thrust::raw_pointer_cast(devPrimes.data()), nb_prime, wrpSz,
+					 thrust::raw_pointer_cast(denseTables.data()), nrDenseTables);
+
+			report_time(start, stop, "findNewNeighodByBlock(SharedMemory)");
+
+			//------------Compute neighborhood of new communities-----------------//
+
+			wrpSz = PHY_WRP_SZ;
+			nr_block_needed = (nrWrp + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
+			//std::cout << "Post: nr_block_needed:" << nr_block_needed << std::endl;
+
+			nr_block_needed = thrust::min(nr_block_needed, 1920);
+
+			unsigned int sharedMemSzPerBlock = WARP_TABLE_SIZE_1 * tableItemSize(deterministic) * NR_THREAD_PER_BLOCK / wrpSz;
+
+			cudaEventRecord(start, 0);
+			if (nrWrp)
+				contractWrp << < nr_block_needed, NR_THREAD_PER_BLOCK, sharedMemSzPerBlock/*, streams[2]*/>>>
+					(thrust::raw_pointer_cast(super_node_ptrs.data()),
+					 thrust::raw_pointer_cast(new_weight_lists.data()),
+					 thrust::raw_pointer_cast(new_nighbor_lists.data()),
+					 thrust::raw_pointer_cast(member_count_per_new_comm.data()), // puts zero in position zero for prefix sum
+					 thrust::raw_pointer_cast(g.indices.data()),
+					 thrust::raw_pointer_cast(g.weights.data()),
+					 thrust::raw_pointer_cast(g.links.data()),
+					 thrust::raw_pointer_cast(comm_nodes.data()), new_nb_comm,
+					 thrust::raw_pointer_cast(n2c.data()),
+					 thrust::raw_pointer_cast(n2c_new.data()),
+					 starts,
+					 g.type, WARP_TABLE_SIZE_1,
+					 candidates + nrGbMem + nrShMem,
+					 nrWrp, wrpSz);
+
+			report_time(start, stop, "determine_neighbors_of_new_comms");
+
+			if (pass == 1) {
+				// Unused slots of the chunk carry out-of-range links and negative weights
+				int chunkLen = hostStarts[c1] - hostStarts[c0];
+				thrust::copy_if(thrust::device, new_nighbor_lists.begin(),
+						new_nighbor_lists.begin() + chunkLen, g_next.links.begin() + exactStarts[c0],
+						IsLessLimit<unsigned int, unsigned int>((unsigned int) new_nb_comm));
+				thrust::copy_if(thrust::device, new_weight_lists.begin(),
+						new_weight_lists.begin() + chunkLen, g_next.weights.begin() + exactStarts[c0],
+						Is_Non_Negative<float, float>());
+			}
+		}
+	}
 
-	//------------Compute neighborhood of new communities-----------------//
+	// Chunked lists are already in g_next; the compaction below has nothing left to copy
+	if (nrChunks > 1) {
+		new_nighbor_lists.clear();
+		new_weight_lists.clear();
+		chunkCandidates.clear();
+		chunkStarts.clear();
+	}
 
-	sc = 0; //std::cin>>sc;
+	//print_vector(member_count_per_new_comm, "Neighbor Counts( per new community): ", "MC");
 
-	//if( new_nb_comm!=12525 ){
+	hashTablePtrs.clear();
+	globalHashTable.clear();
 
-	sc = 0; //std::cin>>sc;
+	// node -> new community id of its community
+	thrust::device_vector<int> levelMap(g.nb_nodes);
+	thrust::gather(thrust::device, n2c.begin(), n2c.end(), n2c_new.begin(), levelMap.begin());
 
-	//std::cout << "Pre: nr_block_needed:" << nr_block_needed << std::endl;
-	wrpSz = PHY_WRP_SZ;
-	nr_block_needed = (nrCforWrp + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
-	//std::cout << "Post: nr_block_needed:" << nr_block_needed << std::endl;
+	if (keepDendrogram) {
+		std::vector<int> hostLevelMap(g.nb_nodes);
+		thrust::copy(levelMap.begin(), levelMap.end(), hostLevelMap.begin());
+		dendrogram.addLevel(hostLevelMap);
+	}
 
-	nr_block_needed = thrust::min(nr_block_needed, 1920);
+	// Weighted degree of a new community is the sum over its members; summed
+	// in fixed point (order independent), scaled to keep the total below 2^62
+	bool nextBundle = (bundle.level == level && bundle.wDegs.size() == (size_t) g.nb_nodes);
+	thrust::device_vector<float> nextWDegs;
 
-	unsigned int sharedMemSzPerBlock = WARP_TABLE_SIZE_1 * sizeof (HashItem) * NR_THREAD_PER_BLOCK / wrpSz;
+	if (nextBundle) {
+		float degreeScale = fixedPointScale(g.total_weight);
 
-	cudaEventRecord(start, 0);
-	if (nrCforWrp)
-		determineNewNeighborhood << < nr_block_needed, NR_THREAD_PER_BLOCK, sharedMemSzPerBlock/*, streams[2]*/>>>
-			(thrust::raw_pointer_cast(super_node_ptrs.data()),
-			 thrust::raw_pointer_cast(new_weight_lists.data()),
-			 thrust::raw_pointer_cast(new_nighbor_lists.data()),
-			 thrust::raw_pointer_cast(member_count_per_new_comm.data()), // puts zero in position zero for prefix sum
-			 thrust::raw_pointer_cast(g.indices.data()),
-			 thrust::raw_pointer_cast(g.weights.data()),
-			 thrust::raw_pointer_cast(g.links.data()),
-			 thrust::raw_pointer_cast(comm_nodes.data()), new_nb_comm,
-			 thrust::raw_pointer_cast(n2c.data()),
-			 thrust::raw_pointer_cast(n2c_new.data()),
-			 thrust::raw_pointer_cast(estimatedSizeOfNeighborhoods.data()),
-			 g.type, WARP_TABLE_SIZE_1,
-			 thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGbMem + nrCforBlkShMem,
-			 nrCforWrp, wrpSz);
-
-	report_time(start, stop, "determine_neighbors_of_new_comms");
+		thrust::device_vector<unsigned long long> wDegSums(new_nb_comm, 0);
+		nextWDegs.resize(new_nb_comm);
 
-	//print_vector(member_count_per_new_comm, "Neighbor Counts( per new community): ", "MC");
+		nr_of_block = (g.nb_nodes + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+		accumulateFixedPoint << <nr_of_block, NR_THREAD_PER_BLOCK>>>(g.nb_nodes,
+				thrust::raw_pointer_cast(levelMap.data()),
+				thrust::raw_pointer_cast(bundle.wDegs.data()), degreeScale,
+				thrust::raw_pointer_cast(wDegSums.data()));
 
-	hashTablePtrs.clear();
-	globalHashTable.clear();
+		nr_of_block = (new_nb_comm + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+		fixedPointToFloat << <nr_of_block, NR_THREAD_PER_BLOCK>>>(new_nb_comm,
+				thrust::raw_pointer_cast(wDegSums.data()), degreeScale,
+				thrust::raw_pointer_cast(nextWDegs.data()));
+	}
+	levelMap.clear();
+	bundle.wDegs.clear();
+	bundle.level = -1;
 
 	estimatedSizeOfNeighborhoods.clear();
 	n2c.clear();
@@ -545,7 +741,7 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 	g.weights.clear();
 	/********************************/
 
-	std::cout << "#New Community: " << new_nb_comm << std::endl;
+	LOG(LOG_DEBUG, "#New Community: " << new_nb_comm);
 	/*
 	   sum_MC = thrust::reduce(member_count_per_new_comm.begin(), member_count_per_new_comm.end(), (int) 0);
 
@@ -558,6 +754,19 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 	   print_vector(super_node_ptrs, "Super Node Ptrs: ");
 	   }
 	 */
+	// Bins of the next level from the exact neighbor counts (behind the
+	// leading zero)
+	thrust::device_vector<int> nextBinSizes(NR_BINS, 0);
+	if (nextBundle) {
+		unsigned int warpLimit = (WARP_TABLE_SIZE_1 * CAPACITY_FACTOR_NUMERATOR / CAPACITY_FACTOR_DENOMINATOR) - 1;
+		unsigned int blkSMemLimit = (SHARED_TABLE_SIZE * CAPACITY_FACTOR_NUMERATOR / CAPACITY_FACTOR_DENOMINATOR) - 1;
+
+		nr_of_block = (new_nb_comm + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+		degreeHistogram << <nr_of_block, NR_THREAD_PER_BLOCK>>>(new_nb_comm,
+				thrust::raw_pointer_cast(member_count_per_new_comm.data()) + 1,
+				warpLimit, blkSMemLimit, thrust::raw_pointer_cast(nextBinSizes.data()));
+	}
+
 	//---------Put data accordingly to new graph-------------------//
 	g_next.type = WEIGHTED;
 	g_next.indices.resize(member_count_per_new_comm.size(), 0);
@@ -584,8 +793,8 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 	//Filter out unused spaces from global memory and copy to g_next
 	g_next.links.resize(g_next.nb_links);
 	g_next.weights.resize(g_next.nb_links);
+	memory.sample();
 
-	sc = 0; //std::cin>>sc;
 
 	int nrElmntToCpy = thrust::count_if(thrust::device, new_nighbor_lists.begin(), new_nighbor_lists.end(),
 			IsLessLimit<unsigned int, unsigned int>((unsigned int) new_nb_comm));
@@ -613,6 +822,9 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 			Is_Non_Negative<float, float>());
 
 	new_weight_lists.clear();
+
+	if (deterministic)
+		sortNeighborhoods(g_next);
 	/*
 	   std::cin>>sc;
 
@@ -659,4 +871,13 @@ void Community::compute_next_graph(cudaStream_t *streams, int nrStreams,
 	//cudaEventDestroy(start);
 	//cudaEventDestroy(stop);
 
+	// The contraction keeps the total weight
+	if (nextBundle) {
+		bundle.wDegs.swap(nextWDegs);
+		thrust::copy(nextBinSizes.begin(), nextBinSizes.end(), bundle.binSizes);
+		bundle.totalWeight = g.total_weight;
+		bundle.level = level + 1;
+	}
+
+	memory.endPhase(memoryStrategy, nrBlockForLargeNhoods, nrChunks, predictedPeak);
 }
@@ -57,15 +57,14 @@ void Community::set_new_graph_as_current() {
 
     //std::cout << "...............Set New Graph as Current.................................." << std::endl;
 
-    int sc;
-    sc = 0; //std::cin>>sc;
-    if (sc > 0) {
+    if (LOG_ENABLED(LOG_TRACE)) {
         print_vector(g.indices, "g.indices( after exchanging): ");
         print_vector(g.weights, "g.weights( after exchanging): ");
         print_vector(g.links, "g.links( after exchanging): ");
     }
 
     community_size = g.nb_nodes;
+    level++;
 
 }
 
@@ -81,7 +80,7 @@ void Community::readPrimes(std::string filename) {
 
         assert(nrPrimes > 0);
 
-        std::cout << "Reading " << nrPrimes << " prime numbers." << std::endl;
+        LOG(LOG_DEBUG, "Reading " << nrPrimes << " prime numbers.");
 
         //Read primes in host memory
         hostPrimes = new int [nrPrimes];
@@ -94,8 +93,6 @@ void Community::readPrimes(std::string filename) {
             //std::cout << aPrimeNum << " ";
         }
 
-        std::cout << std::endl;
-
         assert(nrPrimes == index);
         nb_prime = nrPrimes;
 
@@ -104,7 +101,7 @@ void Community::readPrimes(std::string filename) {
         thrust::copy(hostPrimes, hostPrimes + nb_prime, devPrimes.begin());
 
     } else {
-        std::cout << "Can't open file containing prime numbers." << std::endl;
+        LOG(LOG_ERROR, "Can't open file containing prime numbers.");
     }
     return;
 }
@@ -26,31 +26,175 @@
 #include"hostconstants.h"
 #include"fstream"
 
-double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
-		int minSize, double easyThreshold, bool isGauss, cudaStream_t *streams,
-		int nrStreams, cudaEvent_t &start, cudaEvent_t &stop) {
+// Copy the sampled entries of one bin segment to the same segment of "to";
+// returns how many were chosen
 
-	//NOTE: cudaStream_t *streams was never used 
+static int sampleBin(thrust::device_vector<int>& from, thrust::device_vector<int>& to,
+		int binStart, int binSize, IsSampled pick) {
 
-	std::cout << std::endl << " Inside method for modularity optimization ";
+	if (!binSize)
+		return 0;
 
-	if (g.type == WEIGHTED) {
-		std::cout << "WEIGHTED Graph" << std::endl;
-	} else {
-		std::cout << "UnWeighted Graph" << std::endl;
+	return thrust::copy_if(thrust::device, from.begin() + binStart, from.begin() + binStart + binSize,
+			to.begin() + binStart, pick) - (to.begin() + binStart);
+}
+
+// Kernel time and number of moves of one bin; start was recorded just
+// before the kernel launch
+
+static void recordBin(Telemetry* telemetry, int level, int sweep, int bin, int nrVertices,
+		thrust::device_vector<int>& moveRecord, int nrRecord, cudaEvent_t start, cudaEvent_t stop) {
+
+	cudaEventRecord(stop, 0);
+	cudaEventSynchronize(stop);
+
+	BinRecord record;
+	record.level = level;
+	record.sweep = sweep;
+	record.bin = bin;
+	record.nrVertices = nrVertices;
+	record.milliseconds = 0;
+	cudaEventElapsedTime(&record.milliseconds, start, stop);
+	record.nrMoved = thrust::reduce(moveRecord.begin(), moveRecord.begin() + nrRecord, (int) 0);
+
+	telemetry->bins.push_back(record);
+}
+
+// Deterministic mode: recompute tot_new as fixed-point sums of the weighted
+// degrees of the members instead of keeping the float atomics of the moves;
+// done once per sweep, the batches in between go through settleMoves
+
+static void settleTot(thrust::device_vector<int>& n2c_new, thrust::device_vector<float>& wDegs,
+		thrust::device_vector<unsigned long long>& totFixed, thrust::device_vector<float>& tot_new,
+		float scale) {
+
+	thrust::fill(totFixed.begin(), totFixed.end(), 0);
+
+	int nr_of_block = (n2c_new.size() + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+
+	accumulateFixedPoint << <nr_of_block, NR_THREAD_PER_BLOCK>>>(n2c_new.size(),
+			thrust::raw_pointer_cast(n2c_new.data()),
+			thrust::raw_pointer_cast(wDegs.data()), scale,
+			thrust::raw_pointer_cast(totFixed.data()));
+
+	fixedPointToFloat << <nr_of_block, NR_THREAD_PER_BLOCK>>>(tot_new.size(),
+			thrust::raw_pointer_cast(totFixed.data()), scale,
+			thrust::raw_pointer_cast(tot_new.data()));
+}
+
+// Deterministic mode: applies the moves of a batch to totFixed and refreshes
+// tot_new of the communities they touched, overwriting the float atomics of
+// the move kernels there; n2c still holds the communities before the batch
+
+static void settleMoves(int* candidates, int nrCandidates, thrust::device_vector<int>& n2c,
+		thrust::device_vector<int>& n2c_new, thrust::device_vector<float>& wDegs,
+		thrust::device_vector<unsigned long long>& totFixed, thrust::device_vector<float>& tot_new,
+		float scale) {
+
+	if (nrCandidates <= 0)
+		return;
+
+	int nr_of_block = (nrCandidates + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+
+	moveFixedPoint << <nr_of_block, NR_THREAD_PER_BLOCK>>>(nrCandidates, candidates,
+			thrust::raw_pointer_cast(n2c.data()), thrust::raw_pointer_cast(n2c_new.data()),
+			thrust::raw_pointer_cast(wDegs.data()), scale,
+			thrust::raw_pointer_cast(totFixed.data()));
+
+	refreshMovedTot << <nr_of_block, NR_THREAD_PER_BLOCK>>>(nrCandidates, candidates,
+			thrust::raw_pointer_cast(n2c.data()), thrust::raw_pointer_cast(n2c_new.data()),
+			thrust::raw_pointer_cast(totFixed.data()), scale,
+			thrust::raw_pointer_cast(tot_new.data()));
+}
+
+// First vertex of mini-batch "batch" when a bin is split in nrBatches;
+// batch sizes differ by at most one vertex
+
+static int batchBound(int binSize, int nrBatches, int batch) {
+
+	return (int) (((long long) binSize * batch) / nrBatches);
+}
+
+// Kernel time, moves and conflicting moves of the bins in the first sweep
+// of an autotuned level
+
+struct BinCost {
+	float milliseconds;
+	int nrMoved;
+	int nrConflicts;
+
+	BinCost() : milliseconds(0), nrMoved(0), nrConflicts(0) {
 	}
+};
+
+// Called right after the launch of a bin, before its commit; start was
+// recorded just before the launch
+
+static void measureBin(BinCost& cost, int* binCandidates, int nrCandidates, GraphGPU& g,
+		thrust::device_vector<int>& n2c, thrust::device_vector<int>& n2c_new,
+		thrust::device_vector<int>& conflictCounts, cudaEvent_t start, cudaEvent_t stop) {
+
+	cudaEventRecord(stop, 0);
+	cudaEventSynchronize(stop);
+
+	float milliseconds = 0;
+	cudaEventElapsedTime(&milliseconds, start, stop);
+	cost.milliseconds += milliseconds;
+
+	thrust::fill(conflictCounts.begin(), conflictCounts.end(), 0);
+
+	int nr_of_block = (nrCandidates + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+	countMoveConflicts << <nr_of_block, NR_THREAD_PER_BLOCK>>>(binCandidates, nrCandidates,
+			thrust::raw_pointer_cast(g.indices.data()),
+			thrust::raw_pointer_cast(g.links.data()),
+			thrust::raw_pointer_cast(n2c.data()),
+			thrust::raw_pointer_cast(n2c_new.data()),
+			thrust::raw_pointer_cast(conflictCounts.data()));
+
+	thrust::host_vector<int> counts = conflictCounts;
+	cost.nrMoved += counts[0];
+	cost.nrConflicts += counts[1];
+}
+
+// Mini-batches of a bin for the rest of the level. A conflicting move sees
+// the stale n2c/tot of its neighbor only if both land in the same batch,
+// so with K batches about conflictRate/K of the moves are stale. Sweeps to
+// converge are taken to grow as 1/(1 - stale fraction); each batch costs a
+// commit (copies of n2c, tot and cardinalities) next to the kernel time
+// that does not shrink with K.
+
+static int chooseBatches(const BinCost& cost, int binSize, float commitMs) {
+
+	if (!cost.nrMoved || !cost.nrConflicts)
+		return 1;
 
-	bool hostPrint = false;
-	bool verbose = false;
+	double conflictRate = (double) cost.nrConflicts / cost.nrMoved;
+
+	int best = 1;
+	double bestCost = 0;
+	for (int k = 1; k <= MINI_BATCH_MAX; k *= 2) {
+		if (k > 1 && binSize / k < MINI_BATCH_MIN_SIZE)
+			break;
+
+		double stale = conflictRate / k;
+		double perSweep = cost.milliseconds + k * commitMs;
+		double expected = perSweep / std::max(1.0 - stale, 0.05);
+
+		if (k == 1 || expected < bestCost) {
+			best = k;
+			bestCost = expected;
+		}
+	}
+	return best;
+}
 
-	int sc;
-	sc = 0; //std::cin>>sc;
+double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
+		int minSize, double easyThreshold, bool isGauss, cudaStream_t *streams,
+		int nrStreams, cudaEvent_t &start, cudaEvent_t &stop) {
 
-	if (sc > 1)
-		hostPrint = true;
+	//NOTE: cudaStream_t *streams was never used 
 
-	if (sc > 0)
-		verbose = true;
+	LOG(LOG_DEBUG, " Inside method for modularity optimization " << ((g.type == WEIGHTED) ? "WEIGHTED Graph" : "UnWeighted Graph"));
 
 	/*
 	   if (hostPrint) {
@@ -59,6 +203,8 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 	   }
 	 */
 
+	memory.beginPhase(level, "move");
+
 	bool improvement = false;
 	int nb_moves;
 	double cur_mod = -1.0, new_mod = -1.0;
@@ -105,16 +251,22 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 
 	IsInRange<int, int> filterForNone(0, 0); // node with no neighbors
 
+	// The input graph's bins and weighted degrees may come from the graph
+	// cache, those of a contracted graph from its contraction
+	bool fromCache = (level == 0 && levelZero && levelZero->nbNodes == (unsigned int) community_size);
+	bool fromBundle = (bundle.level == level && bundle.wDegs.size() == (size_t) community_size);
+	const int* cachedBins = fromCache ? levelZero->binSizes : (fromBundle ? bundle.binSizes : NULL);
+
 	//count #work for each bin
-	int nrCforBlkGMem = thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filterBlkGMem);
-	int nrCforBlkSMem = thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filterBlkSMem);
-	int nrCforWrp = thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filterForWrp);
-	int nrC_N_leq32 = thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filter_N_leq32);
-	int nrC_N_leq16 = thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filter_N_leq16);
-	int nrC_N_leq8 = thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filter_N_leq8);
-	int nrC_N_leq4 = thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filter_N_leq4);
-
-	int nrCforNone = thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filterForNone);
+	int nrCforBlkGMem = cachedBins ? cachedBins[0] : thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filterBlkGMem);
+	int nrCforBlkSMem = cachedBins ? cachedBins[1] : thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filterBlkSMem);
+	int nrCforWrp = cachedBins ? cachedBins[2] : thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filterForWrp);
+	int nrC_N_leq32 = cachedBins ? cachedBins[3] : thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filter_N_leq32);
+	int nrC_N_leq16 = cachedBins ? cachedBins[4] : thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filter_N_leq16);
+	int nrC_N_leq8 = cachedBins ? cachedBins[5] : thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filter_N_leq8);
+	int nrC_N_leq4 = cachedBins ? cachedBins[6] : thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filter_N_leq4);
+
+	int nrCforNone = cachedBins ? cachedBins[7] : thrust::count_if(thrust::device, sizesOfNhoods.begin(), sizesOfNhoods.end(), filterForNone);
 	/*    
 	      std::cout << "distribution: "<< nrC_N_leq4 <<" : "<< nrC_N_leq8<<" : "<< nrC_N_leq16<<" : "<< 
 	      nrC_N_leq32<<" : "<<nrCforWrp<<" : "<<nrCforBlkSMem<<" : "<<nrCforBlkGMem<<std::endl;
@@ -157,41 +309,44 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 
 	thrust::device_vector<int> movement_counters(maxNrWrp, 0);
 
-	//Lets copy Identities of all communities  in g_next.links
-
-	g_next.links.resize(community_size, 0);
-	thrust::sequence(g_next.links.begin(), g_next.links.end(), 0);
-
-
 	//Use g_next.indices to copy community ids with decreasing sizes of neighborhood
 
 	g_next.indices.resize(community_size, -1);
 
-	//First community ids with larger neighborhoods
-	thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(),
-			sizesOfNhoods.begin(), g_next.indices.begin(), filterBlkGMem);
+	if (fromCache) {
+		thrust::copy(levelZero->binOrder, levelZero->binOrder + levelZero->nbNodes, g_next.indices.begin());
+	} else {
+		//Lets copy Identities of all communities  in g_next.links
+
+		g_next.links.resize(community_size, 0);
+		thrust::sequence(g_next.links.begin(), g_next.links.end(), 0);
+
+		//First community ids with larger neighborhoods
+		thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(),
+				sizesOfNhoods.begin(), g_next.indices.begin(), filterBlkGMem);
 
-	// Then community ids with medium sized neighborhoods
+		// Then community ids with medium sized neighborhoods
 
-	thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
-			g_next.indices.begin() + nrCforBlkGMem, filterBlkSMem);
+		thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
+				g_next.indices.begin() + nrCforBlkGMem, filterBlkSMem);
 
-	// Community ids with smaller neighborhoods
-	thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
-			g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem, filterForWrp);
+		// Community ids with smaller neighborhoods
+		thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
+				g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem, filterForWrp);
 
-	thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
-			g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp, filter_N_leq32);
+		thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
+				g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp, filter_N_leq32);
 
-	thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
-			g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32, filter_N_leq16);
+		thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
+				g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32, filter_N_leq16);
 
 
-	thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
-			g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16, filter_N_leq8);
+		thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
+				g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16, filter_N_leq8);
 
-	thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
-			g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + nrC_N_leq8, filter_N_leq4);
+		thrust::copy_if(thrust::device, g_next.links.begin(), g_next.links.end(), sizesOfNhoods.begin(),
+				g_next.indices.begin() + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + nrC_N_leq8, filter_N_leq4);
+	}
 	///////////////////////////////////////////////////
 
 	// Now, use g_next.links to copy sizes of neighborhood according to order given by g_next.indices
@@ -200,10 +355,11 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 
 	thrust::gather(thrust::device, g_next.indices.begin(), g_next.indices.end(), sizesOfNhoods.begin(), g_next.links.begin());
 
-	//Sort according to size of neighborhood ; only first nrCforBlkGbMem
+	//Sort according to size of neighborhood ; only first nrCforBlkGbMem; cached bins come sorted
 
-	thrust::sort_by_key(g_next.links.begin(), g_next.links.begin() + nrCforBlkGMem,
-			g_next.indices.begin(), thrust::greater<unsigned int>());
+	if (!fromCache)
+		thrust::sort_by_key(g_next.links.begin(), g_next.links.begin() + nrCforBlkGMem,
+				g_next.indices.begin(), thrust::greater<unsigned int>());
 
 	//////////Just to debug /////////////////
 	/*
@@ -231,14 +387,43 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 			hashTablePtrs.begin() + 1, thrust::plus<int>());
 
 
-	thrust::device_vector<HashItem> globalHashTable(2 * hashTablePtrs.back());
+	// Dense accumulators for the heaviest rows: one table of community_size
+	// slots for each of the first nrDenseTables blocks, within the budget
+	int nrDenseTables = 0;
+	if (nrCforBlkGMem > 0 && community_size > 1)
+		nrDenseTables = (int) thrust::min((size_t) nrBlockForLargeNhoods,
+				denseTableBudget / (tableItemSize(deterministic) * community_size));
+
+	// Block b of the block bins owns slots [2*ptrs[b], 2*ptrs[b+1]); with
+	// fewer blocks the tables of the largest neighborhoods are kept
+	std::vector<int> tablePrefix(nrBlockForLargeNhoods + 1);
+	thrust::copy(hashTablePtrs.begin(), hashTablePtrs.end(), tablePrefix.begin());
+
+	int memoryStrategy = MEM_DEFAULT;
+	size_t predictedPeak = predictMovePeak(community_size, tablePrefix[nrBlockForLargeNhoods],
+			nrDenseTables, deterministic, sampleFraction < 1.0 && level < sampleLevels);
+
+	while (!memory.fits(predictedPeak) && (nrDenseTables > 0 || nrBlockForLargeNhoods > 1)) {
+		memoryStrategy = MEM_FEWER_BLOCKS;
+		if (nrDenseTables > 0)
+			nrDenseTables = 0;
+		else
+			nrBlockForLargeNhoods = (nrBlockForLargeNhoods + 1) / 2;
+		predictedPeak = predictMovePeak(community_size, tablePrefix[nrBlockForLargeNhoods],
+				nrDenseTables, deterministic, sampleFraction < 1.0 && level < sampleLevels);
+	}
+	if (!memory.fits(predictedPeak))
+		LOG(LOG_WARN, "Level " << level << ": move phase needs " << (predictedPeak >> 20)
+				<< " MB, over the memory budget (" << (memory.available() >> 20) << " MB left)");
 
-	int szHTmem = thrust::reduce(g_next.links.begin(), g_next.links.begin() + nrBlockForLargeNhoods, (int) 0);
+	thrust::device_vector<long long> globalHashTable(tableWords(2 * tablePrefix[nrBlockForLargeNhoods], deterministic), 0);
 
 	//std::cout << globalHashTable.size() << ":" << 2 * szHTmem << std::endl;
 
 	thrust::device_vector<int> moveCounters(nrBlockForLargeNhoods, 0);
 
+	thrust::device_vector<long long> denseTables(tableWords((size_t) nrDenseTables * community_size, deterministic), 0);
+
 
 
 
@@ -267,11 +452,15 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 
 	g.total_weight = 0.0;
 
-	if (g.type == WEIGHTED) {
+	if (fromBundle) {
+		g.total_weight = bundle.totalWeight;
+	} else if (g.type == WEIGHTED) {
 		g.total_weight = thrust::reduce(thrust::device, g.weights.begin(), g.weights.end(), (double) 0, thrust::plus<double>());
 	} else {
 		g.total_weight = (double) g.nb_links;
 	}
+	if (globalTotalWeight > 0)
+		g.total_weight = globalTotalWeight;
 
 	report_time(start, stop, "FilterCopy&M");
 	//std::cout << " g.weight(computed in device): " << g.total_weight << std::endl;
@@ -298,15 +487,33 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 	int load_per_blk = CHUNK_PER_WARP * (NR_THREAD_PER_BLOCK / wrpSz);
 	nr_of_block = (community_size + load_per_blk - 1) / load_per_blk;
 
-	thrust::device_vector<float> wDegs(community_size, 0.0);
+	// Kept in the bundle; the contraction sums them up for the next level
+	thrust::device_vector<float>& wDegs = bundle.wDegs;
+	if (!fromBundle) {
+		wDegs.clear();
+		wDegs.resize(community_size, 0.0);
+		bundle.level = level;
+	}
 
 	cudaEventRecord(start, 0);
-	preComputeWdegs << <nr_of_block, NR_THREAD_PER_BLOCK>>>(thrust::raw_pointer_cast(g.indices.data()),
-			thrust::raw_pointer_cast(g.weights.data()),
-			thrust::raw_pointer_cast(wDegs.data()),
-			g.type, community_size, wrpSz);
+	if (fromCache)
+		thrust::copy(levelZero->wDegs, levelZero->wDegs + levelZero->nbNodes, wDegs.begin());
+	else if (!fromBundle)
+		preComputeWdegs << <nr_of_block, NR_THREAD_PER_BLOCK>>>(thrust::raw_pointer_cast(g.indices.data()),
+				thrust::raw_pointer_cast(g.weights.data()),
+				thrust::raw_pointer_cast(wDegs.data()),
+				g.type, community_size, wrpSz);
 
 	report_time(start, stop, "preComputeWdegs");
+
+	// Deterministic mode: a table slot sums links of one vertex, at most its
+	// weighted degree
+	thrust::device_vector<unsigned long long> totFixed;
+	if (deterministic) {
+		totFixed.resize(community_size);
+		float maxWDeg = thrust::reduce(wDegs.begin(), wDegs.end(), 0.0f, thrust::maximum<float>());
+		setTableGravityScale(fixedPointScale(maxWDeg));
+	}
 	//////////////////////////////////////////////////////////////	
 
 	wrpSz = PHY_WRP_SZ;
@@ -317,14 +524,36 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 
 	cudaEventRecord(start, 0);
 
-	initialize_in_tot << < nr_of_block, NR_THREAD_PER_BLOCK, size_of_shared_memory >>>(community_size,
-			thrust::raw_pointer_cast(g.indices.data()), thrust::raw_pointer_cast(g.links.data()),
-			thrust::raw_pointer_cast(g.weights.data()), thrust::raw_pointer_cast(tot.data()),
-			NULL, thrust::raw_pointer_cast(n2c.data()), g.type, NULL, wrpSz,
-			thrust::raw_pointer_cast(wDegs.data()));
+	// Singletons: tot is the weighted degree
+	if (fromBundle)
+		thrust::copy(wDegs.begin(), wDegs.end(), tot.begin());
+	else
+		initialize_in_tot << < nr_of_block, NR_THREAD_PER_BLOCK, size_of_shared_memory >>>(community_size,
+				thrust::raw_pointer_cast(g.indices.data()), thrust::raw_pointer_cast(g.links.data()),
+				thrust::raw_pointer_cast(g.weights.data()), thrust::raw_pointer_cast(tot.data()),
+				NULL, thrust::raw_pointer_cast(n2c.data()), g.type, NULL, wrpSz,
+				thrust::raw_pointer_cast(wDegs.data()));
 
 	report_time(start, stop, "initialize_in_tot");
 
+	if (level == 0 && warmStartRounds > 0) {
+		cur_mod = warmStart(wDegs, tot, cardinalityOfComms);
+		n2c_old = n2c;
+
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		modularityTrace.push_back(std::make_pair((now.tv_sec - runStart.tv_sec) + (now.tv_nsec - runStart.tv_nsec) / 1.0e9, cur_mod));
+
+		// Contract the propagated partition as it is
+		if (warmStartContract) {
+			g_next.indices.clear();
+			g_next.links.clear();
+			n2c_new.clear();
+			memory.endPhase(memoryStrategy, nrBlockForLargeNhoods, 1, predictedPeak);
+			return cur_mod;
+		}
+	}
+
 	//////////////////////////////////////
 
 	int loopCnt = 0;
@@ -334,26 +563,129 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 	if (community_size > minSize && isLastRound == false)
 		threshold = easyThreshold;
 
-	std::cout<<"Status::  community size - "<<community_size<<" threshold - "<<threshold<<std::endl;
+	LOG(LOG_INFO, "Status::  community size - "<<community_size<<" threshold - "<<threshold);
+
+	bool isEasyThreshold = (community_size > minSize && isLastRound == false);
+
+	if (telemetry) {
+		LevelRecord record;
+		record.level = level;
+		record.nrNodes = community_size;
+		record.nrLinks = g.nb_links;
+		record.threshold = threshold;
+		record.easyThreshold = isEasyThreshold;
+
+		int binSizes[NR_BINS] = {nrCforBlkGMem, nrCforBlkSMem, nrCforWrp, nrC_N_leq32,
+			nrC_N_leq16, nrC_N_leq8, nrC_N_leq4, nrCforNone};
+		std::copy(binSizes, binSizes + NR_BINS, record.binSizes);
+
+		telemetry->levels.push_back(record);
+	}
 	//  std::cout << "minSize: " << minSize << std::endl;
 
 
 	//NEVER set it to TRUE; it doesn't work!!!!!!!!!!!
 	bool isToUpdate = false; // true;
 
+	// Kernel instance of each bin, fixed for the level
+	NeighCommKernel moveLeq4 = selectNeighComm(QUARTER_WARP / 2, LEQ4_TABLE_SIZE, g.type, genericKernels, deterministic);
+	NeighCommKernel moveLeq8 = selectNeighComm(QUARTER_WARP, LEQ8_TABLE_SIZE, g.type, genericKernels, deterministic);
+	NeighCommKernel moveLeq16 = selectNeighComm(HALF_WARP, LEQ16_TABLE_SIZE, g.type, genericKernels, deterministic);
+	NeighCommKernel moveLeq32 = selectNeighComm(PHY_WRP_SZ, LEQ32_TABLE_SIZE, g.type, genericKernels, deterministic);
+	NeighCommKernel moveWrp = selectNeighComm(PHY_WRP_SZ, WARP_TABLE_SIZE_1, g.type, genericKernels, deterministic);
+	BlockMoveKernel moveBlk = selectLookAtNeigboringComms(g.type, genericKernels, deterministic);
+
+	// Smallest bins fit in the registers of their group
+	if (registerKernels && !genericKernels) {
+		moveLeq4 = selectNeighCommInRegisters(QUARTER_WARP / 2, g.type);
+		moveLeq8 = selectNeighCommInRegisters(QUARTER_WARP, g.type);
+	}
+
+	// Sampled sweeps keep the bin layout of g_next.indices: the chosen
+	// vertices of a bin are compacted to the front of its segment
+	double fraction = (level < sampleLevels) ? thrust::min(sampleFraction, 1.0) : 1.0;
+	double prevGain = -1.0;
+	float avgDegree = (float) g.nb_links / thrust::max(community_size, 1);
+
+	// state after the last accepted sweep, to undo a bad sampled sweep
+	thrust::device_vector<int> sampledCandidates;
+	thrust::device_vector<int> n2c_saved;
+	thrust::device_vector<float> tot_saved;
+	thrust::device_vector<int> cardinalityOfComms_saved;
+
+	if (fraction < 1.0) {
+		sampledCandidates.resize(community_size);
+		n2c_saved = n2c;
+		tot_saved = tot;
+		cardinalityOfComms_saved = cardinalityOfComms;
+	}
+
+	memory.sample();
+
+	// Mini-batches per bin; an autotuned level runs its first sweep with
+	// whole bins and measures them
+	bool autoBatches = isGauss && (miniBatches == 0);
+	int binBatches[NR_BINS];
+	std::fill(binBatches, binBatches + NR_BINS, (isGauss && miniBatches > 1) ? miniBatches : 1);
+	BinCost binCosts[NR_BINS];
+	float commitMs = 0;
+	thrust::device_vector<int> conflictCounts(autoBatches ? 2 : 0);
+
 	clock_t t1, t2;
 	do {
+		// Anytime mode: end the level with the last accepted sweep if one
+		// more sweep and the contraction would miss the deadline
+		if (loopCnt > 0 && !deadline.fits(secondsSinceStart(),
+					deadline.predictSweep(g.nb_links) + deadline.predictContraction(g.nb_links))) {
+			deadline.hit = true;
+			n2c_old = n2c;
+			LOG(LOG_INFO, "Deadline: level " << level << " stops after " << loopCnt << " sweeps");
+			break;
+		}
+
 		t1 = clock();
 
+		struct timespec sweepStart;
+		clock_gettime(CLOCK_MONOTONIC, &sweepStart);
+
 		loopCnt++;
+		nrSweeps++;
 		//   std::cout << " ---------------------------- do-while ---------------------" << loopCnt << std::endl;
 
+		bool measuring = autoBatches && (loopCnt == 1);
+
+		if (autoBatches && loopCnt == 2) {
+			int binSizes[NR_BINS] = {nrCforBlkGMem, nrCforBlkSMem, nrCforWrp, nrC_N_leq32,
+				nrC_N_leq16, nrC_N_leq8, nrC_N_leq4, nrCforNone};
+			for (int bin = 0; bin < NR_BINS; bin++)
+				binBatches[bin] = chooseBatches(binCosts[bin], binSizes[bin], commitMs);
+
+			LOG(LOG_DEBUG, "Mini-batches (level " << level << ", commit " << commitMs << " ms): "
+				<< binBatches[0] << " " << binBatches[1] << " " << binBatches[2] << " " << binBatches[3]
+				<< " " << binBatches[4] << " " << binBatches[5] << " " << binBatches[6]);
+		}
 
 		thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
+
+		// The same copies as a commit; timed once for the batch cost model
+		if (measuring)
+			cudaEventRecord(start, 0);
+
 		n2c_new = n2c; // MUST NEEDED Assignment
 		tot_new = tot;
 		cardinalityOfComms_new = cardinalityOfComms;
 
+		if (measuring) {
+			cudaEventRecord(stop, 0);
+			cudaEventSynchronize(stop);
+			cudaEventElapsedTime(&commitMs, start, stop);
+		}
+
+		if (deterministic) {
+			settleTot(n2c_new, wDegs, totFixed, tot_new, gravityScale);
+			tot = tot_new;
+		}
+
 
 
 		//thrust::fill_n(thrust::device, tot_new.begin(), tot_new.size(),0.0);
@@ -369,64 +701,114 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 
 		moveCounters.clear();
 		moveCounters.resize(nrBlockForLargeNhoods, 0);
-		if (nrCforBlkGMem > 0) {
 
-			if (isGauss) {
-				//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
-				//tot_new = tot;
-				//cardinalityOfComms_new = cardinalityOfComms;
-			}
+		// Kernels count moves only if they get somewhere to store them
+		int* moveRecord = telemetry ? thrust::raw_pointer_cast(movement_counters.data()) : NULL;
+		int* blkMoveRecord = telemetry ? thrust::raw_pointer_cast(moveCounters.data()) : NULL;
 
-			wrpSz = PHY_WRP_SZ;
+		int* candidates = thrust::raw_pointer_cast(g_next.indices.data());
 
-			cudaEventRecord(start, 0);
+		int nrSCforBlkGMem = nrCforBlkGMem, nrSCforBlkSMem = nrCforBlkSMem, nrSCforWrp = nrCforWrp;
+		int nrSC_N_leq32 = nrC_N_leq32, nrSC_N_leq16 = nrC_N_leq16, nrSC_N_leq8 = nrC_N_leq8, nrSC_N_leq4 = nrC_N_leq4;
 
-			//std::cout<<" nrBlockForLargeNhoods: "<<nrBlockForLargeNhoods<<" nrCforBlkGMem:  "<<  nrCforBlkGMem<<std::endl;
-			lookAtNeigboringComms << <nrBlockForLargeNhoods, (NR_THREAD_PER_BLOCK * 2)>>>(
-					thrust::raw_pointer_cast(g.indices.data()),
-					thrust::raw_pointer_cast(g.links.data()),
-					thrust::raw_pointer_cast(g.weights.data()),
-					thrust::raw_pointer_cast(n2c.data()),
-					thrust::raw_pointer_cast(in.data()),
-					thrust::raw_pointer_cast(tot.data()), g.type,
-					thrust::raw_pointer_cast(n2c_new.data()),
-					NULL,
-					thrust::raw_pointer_cast(tot_new.data()),
-					thrust::raw_pointer_cast(moveCounters.data()), g.total_weight,
-					thrust::raw_pointer_cast(g_next.indices.data()), nrCforBlkGMem,
-					thrust::raw_pointer_cast(globalHashTable.data()),
-					thrust::raw_pointer_cast(hashTablePtrs.data()),
-					thrust::raw_pointer_cast(devPrimes.data()), nb_prime, wrpSz,
-					thrust::raw_pointer_cast(cardinalityOfComms.data()),
-					thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
-					thrust::raw_pointer_cast(wDegs.data()));
+		bool isSampledSweep = (fraction < 1.0);
 
-			report_time(start, stop, "lookAtNeigboringComms");
-			//nb_moves = nb_moves + thrust::reduce(moveCounters.begin(), moveCounters.begin() + nrBlockForLargeNhoods, (int) 0);
+		if (isSampledSweep) {
 
-			/*
-			   if (0) {
-			   changeAssignment << < nr_of_block, NR_THREAD_PER_BLOCK>>>(
-			   thrust::raw_pointer_cast(n2c.data()), // change from
-			   thrust::raw_pointer_cast(n2c_new.data()), // change to
-			   thrust::raw_pointer_cast(g_next.indices.data()), nrCforBlkGMem);
-			   }
-			 */
+			IsSampled pick(sampleSeed, level, loopCnt, fraction, sampleByDegree,
+					thrust::raw_pointer_cast(sizesOfNhoods.data()), avgDegree);
 
-			if (isGauss) {
-				if (isToUpdate) {
-					nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
-					update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
-							thrust::raw_pointer_cast(tot.data()),
-							thrust::raw_pointer_cast(tot_new.data()),
-							thrust::raw_pointer_cast(n2c.data()),
-							thrust::raw_pointer_cast(n2c_new.data()),
-							thrust::raw_pointer_cast(cardinalityOfComms.data()),
-							thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
-				} else {
-					n2c = n2c_new;
-					tot = tot_new;
-					cardinalityOfComms = cardinalityOfComms_new;
+			int binStart = 0;
+			nrSCforBlkGMem = sampleBin(g_next.indices, sampledCandidates, binStart, nrCforBlkGMem, pick);
+			binStart += nrCforBlkGMem;
+			nrSCforBlkSMem = sampleBin(g_next.indices, sampledCandidates, binStart, nrCforBlkSMem, pick);
+			binStart += nrCforBlkSMem;
+			nrSCforWrp = sampleBin(g_next.indices, sampledCandidates, binStart, nrCforWrp, pick);
+			binStart += nrCforWrp;
+			nrSC_N_leq32 = sampleBin(g_next.indices, sampledCandidates, binStart, nrC_N_leq32, pick);
+			binStart += nrC_N_leq32;
+			nrSC_N_leq16 = sampleBin(g_next.indices, sampledCandidates, binStart, nrC_N_leq16, pick);
+			binStart += nrC_N_leq16;
+			nrSC_N_leq8 = sampleBin(g_next.indices, sampledCandidates, binStart, nrC_N_leq8, pick);
+			binStart += nrC_N_leq8;
+			nrSC_N_leq4 = sampleBin(g_next.indices, sampledCandidates, binStart, nrC_N_leq4, pick);
+
+			candidates = thrust::raw_pointer_cast(sampledCandidates.data());
+		}
+
+		if (nrSCforBlkGMem > 0) {
+			for (int batch = 0, nrBatches = std::min(binBatches[0], nrSCforBlkGMem); batch < nrBatches; batch++) {
+				int batchFirst = batchBound(nrSCforBlkGMem, nrBatches, batch);
+				int nrInBatch = batchBound(nrSCforBlkGMem, nrBatches, batch + 1) - batchFirst;
+
+				if (isGauss) {
+					//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
+					//tot_new = tot;
+					//cardinalityOfComms_new = cardinalityOfComms;
+				}
+
+				wrpSz = PHY_WRP_SZ;
+
+				cudaEventRecord(start, 0);
+
+				//std::cout<<" nrBlockForLargeNhoods: "<<nrBlockForLargeNhoods<<" nrCforBlkGMem:  "<<  nrCforBlkGMem<<std::endl;
+				moveBlk << <nrBlockForLargeNhoods, (NR_THREAD_PER_BLOCK * 2)>>>(
+						thrust::raw_pointer_cast(g.indices.data()),
+						thrust::raw_pointer_cast(g.links.data()),
+						thrust::raw_pointer_cast(g.weights.data()),
+						thrust::raw_pointer_cast(n2c.data()),
+						thrust::raw_pointer_cast(in.data()),
+						thrust::raw_pointer_cast(tot.data()), g.type,
+						thrust::raw_pointer_cast(n2c_new.data()),
+						NULL,
+						thrust::raw_pointer_cast(tot_new.data()),
+						blkMoveRecord, g.total_weight,
+						candidates + batchFirst, nrInBatch,
+						thrust::raw_pointer_cast(globalHashTable.data()),
+						thrust::raw_pointer_cast(hashTablePtrs.data()),
+						thrust::raw_pointer_cast(devPrimes.data()), nb_prime, wrpSz,
+						thrust::raw_pointer_cast(cardinalityOfComms.data()),
+						thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
+						thrust::raw_pointer_cast(wDegs.data()),
+						thrust::raw_pointer_cast(denseTables.data()), nrDenseTables, community_size);
+
+				if (measuring)
+					measureBin(binCosts[0], candidates + batchFirst,
+							nrInBatch, g, n2c, n2c_new, conflictCounts, start, stop);
+
+				report_time(start, stop, "lookAtNeigboringComms");
+				if (telemetry)
+					recordBin(telemetry, level, loopCnt, 0, nrInBatch, moveCounters, nrBlockForLargeNhoods, start, stop);
+				//nb_moves = nb_moves + thrust::reduce(moveCounters.begin(), moveCounters.begin() + nrBlockForLargeNhoods, (int) 0);
+
+				/*
+				   if (0) {
+				   changeAssignment << < nr_of_block, NR_THREAD_PER_BLOCK>>>(
+				   thrust::raw_pointer_cast(n2c.data()), // change from
+				   thrust::raw_pointer_cast(n2c_new.data()), // change to
+				   candidates + batchFirst, nrInBatch);
+				   }
+				 */
+
+				if (deterministic)
+					settleMoves(candidates + batchFirst, nrInBatch,
+							n2c, n2c_new, wDegs, totFixed, tot_new, gravityScale);
+
+				if (isGauss) {
+					if (isToUpdate) {
+						nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+						update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+								thrust::raw_pointer_cast(tot.data()),
+								thrust::raw_pointer_cast(tot_new.data()),
+								thrust::raw_pointer_cast(n2c.data()),
+								thrust::raw_pointer_cast(n2c_new.data()),
+								thrust::raw_pointer_cast(cardinalityOfComms.data()),
+								thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
+					} else {
+						n2c = n2c_new;
+						tot = tot_new;
+						cardinalityOfComms = cardinalityOfComms_new;
+					}
 				}
 			}
 		}
@@ -459,7 +841,6 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 		   }
 
 		 */
-		sc = 0; //std::cin>>sc;
 
 		//////////////////////////////////////////////////
 
@@ -476,7 +857,7 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 		nr_of_block = (nrC_N_leq32 + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
 
 		bucketSizePerWarp = 61; //MUST BE PRIME
-		sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * sizeof (HashItem);
+		sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * tableItemSize(deterministic);
 
 		cudaEventRecord(start, 0);
 
@@ -532,7 +913,7 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 		nr_of_block = (nrCforWrp + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
 
 		bucketSizePerWarp = WARP_TABLE_SIZE_1;
-		sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * sizeof (HashItem);
+		sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * tableItemSize(deterministic);
 
 		cudaEventRecord(start, 0);
 
@@ -676,21 +1057,208 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 		//////////////////////////////////////////////////
 
 
-		if (nrC_N_leq8) {
+		if (nrSC_N_leq8) {
+			for (int batch = 0, nrBatches = std::min(binBatches[5], nrSC_N_leq8); batch < nrBatches; batch++) {
+				int batchFirst = batchBound(nrSC_N_leq8, nrBatches, batch);
+				int nrInBatch = batchBound(nrSC_N_leq8, nrBatches, batch + 1) - batchFirst;
+
+				if (isGauss) {
+					//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
+					//tot_new = tot;
+					//cardinalityOfComms_new = cardinalityOfComms;
+				}
+				wrpSz = QUARTER_WARP;
+				nr_of_block = (nrInBatch + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
+
+				bucketSizePerWarp = LEQ8_TABLE_SIZE;
+				sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * tableItemSize(deterministic);
+
+				/*
+				   if (0) {
+				   std::cin>>sc;
+
+				   print_vector(g.indices, "g.indices: ");
+				   print_vector(g.links, "g.links: ");
+				   print_vector(n2c, "n2c:");
+				   print_vector(in, "in: ");
+				   print_vector(tot, "tot:");
+				   print_vector(n2c_new, "n2c_new:");
+				   print_vector(tot_new, "tot_new:");
+				   print_vector(movement_counters, "movement_counters:");
+				   print_vector(g_next.indices, "g_next.indices:");
+				   print_vector(devPrimes, "devPrimes:");
+				   print_vector(cardinalityOfComms, "cardinalityOfComms:");
+				   print_vector(cardinalityOfComms_new, "cardinalityOfComms_new:");
+				   }
+				 */
+				cudaEventRecord(start, 0);
+
+				//print_vector(in, "in (*): ");
+				moveLeq8 << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
+						community_size,
+						thrust::raw_pointer_cast(g.indices.data()),
+						thrust::raw_pointer_cast(g.links.data()),
+						thrust::raw_pointer_cast(g.weights.data()),
+						thrust::raw_pointer_cast(n2c.data()),
+						thrust::raw_pointer_cast(in.data()),
+						thrust::raw_pointer_cast(tot.data()), g.type,
+						thrust::raw_pointer_cast(n2c_new.data()),
+						thrust::raw_pointer_cast(tot_new.data()),
+						moveRecord,
+						g.total_weight, bucketSizePerWarp,
+						candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + batchFirst,
+						nrInBatch, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
+						thrust::raw_pointer_cast(cardinalityOfComms.data()),
+						thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
+						wrpSz, thrust::raw_pointer_cast(wDegs.data()));
+
+				if (measuring)
+					measureBin(binCosts[5], candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + batchFirst,
+							nrInBatch, g, n2c, n2c_new, conflictCounts, start, stop);
+
+				//print_vector(in, "in (*): ");
+				report_time(start, stop, "neigh_comm ( <=8)");
+				if (telemetry)
+					recordBin(telemetry, level, loopCnt, 5, nrInBatch, movement_counters, nrInBatch, start, stop);
+				//nb_moves = nb_moves + thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrInBatch, (int) 0);
+
+				/*
+				   changeAssignment<<< nr_of_block, NR_THREAD_PER_BLOCK>>>(  
+				   thrust::raw_pointer_cast(n2c.data()), // change from
+				   thrust::raw_pointer_cast(n2c_new.data()), // change to
+				   candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + batchFirst,
+				   nrInBatch);
+				 */
+
+				if (deterministic)
+					settleMoves(candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + batchFirst, nrInBatch,
+							n2c, n2c_new, wDegs, totFixed, tot_new, gravityScale);
+
+				if (isGauss) {
+
+					if (isToUpdate) {
+						assert(community_size == n2c.size());
+						assert(community_size == n2c_new.size());
+						assert(community_size == tot.size());
+						assert(community_size == tot_new.size());
+						assert(community_size == cardinalityOfComms.size());
+						assert(community_size == cardinalityOfComms_new.size());
+
+
+						nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+						update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+								thrust::raw_pointer_cast(tot.data()),
+								thrust::raw_pointer_cast(tot_new.data()),
+								thrust::raw_pointer_cast(n2c.data()),
+								thrust::raw_pointer_cast(n2c_new.data()),
+								thrust::raw_pointer_cast(cardinalityOfComms.data()),
+								thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
+					} else {
+						n2c = n2c_new;
+						tot = tot_new;
+						cardinalityOfComms = cardinalityOfComms_new;
+					}
+				}
+			}
+		}
 
+	if (nrSC_N_leq16) {
+		for (int batch = 0, nrBatches = std::min(binBatches[4], nrSC_N_leq16); batch < nrBatches; batch++) {
+			int batchFirst = batchBound(nrSC_N_leq16, nrBatches, batch);
+			int nrInBatch = batchBound(nrSC_N_leq16, nrBatches, batch + 1) - batchFirst;
 
 			if (isGauss) {
 				//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
 				//tot_new = tot;
 				//cardinalityOfComms_new = cardinalityOfComms;
 			}
-			wrpSz = QUARTER_WARP;
-			nr_of_block = (nrC_N_leq8 + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
 
-			bucketSizePerWarp = 17; // MUST BE PRIME
-			sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * sizeof (HashItem);
+			wrpSz = HALF_WARP;
+			nr_of_block = (nrInBatch + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
+
+			bucketSizePerWarp = LEQ16_TABLE_SIZE;
+			sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * tableItemSize(deterministic);
+
+			cudaEventRecord(start, 0);
+
+			moveLeq16 << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
+					community_size,
+					thrust::raw_pointer_cast(g.indices.data()),
+					thrust::raw_pointer_cast(g.links.data()),
+					thrust::raw_pointer_cast(g.weights.data()),
+					thrust::raw_pointer_cast(n2c.data()),
+					thrust::raw_pointer_cast(in.data()),
+					thrust::raw_pointer_cast(tot.data()), g.type,
+					thrust::raw_pointer_cast(n2c_new.data()),
+					thrust::raw_pointer_cast(tot_new.data()),
+					moveRecord,
+					g.total_weight, bucketSizePerWarp,
+					candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + batchFirst,
+					nrInBatch, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
+					thrust::raw_pointer_cast(cardinalityOfComms.data()),
+					thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
+					wrpSz, thrust::raw_pointer_cast(wDegs.data()));
+
+			if (measuring)
+				measureBin(binCosts[4], candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + batchFirst,
+						nrInBatch, g, n2c, n2c_new, conflictCounts, start, stop);
+
+			report_time(start, stop, "neigh_comm ( <=16)");
+			if (telemetry)
+				recordBin(telemetry, level, loopCnt, 4, nrInBatch, movement_counters, nrInBatch, start, stop);
+			//nb_moves = nb_moves + thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrInBatch, (int) 0);
+
+			/*
+			   changeAssignment<<< nr_of_block, NR_THREAD_PER_BLOCK>>>(  
+			   thrust::raw_pointer_cast(n2c.data()), // change from
+			   thrust::raw_pointer_cast(n2c_new.data()), // change to
+			   candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + batchFirst,
+			   nrInBatch);
+			 */
+
+			if (deterministic)
+				settleMoves(candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + batchFirst, nrInBatch,
+						n2c, n2c_new, wDegs, totFixed, tot_new, gravityScale);
+
+			if (isGauss) {
+				if (isToUpdate) {
+					nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+					update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+							thrust::raw_pointer_cast(tot.data()),
+							thrust::raw_pointer_cast(tot_new.data()),
+							thrust::raw_pointer_cast(n2c.data()),
+							thrust::raw_pointer_cast(n2c_new.data()),
+							thrust::raw_pointer_cast(cardinalityOfComms.data()),
+							thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
+				} else {
+					n2c = n2c_new;
+					tot = tot_new;
+					cardinalityOfComms = cardinalityOfComms_new;
+				}
+			}
+		}
+	}
+
+
+
+
+	if (nrSC_N_leq4) {
+		for (int batch = 0, nrBatches = std::min(binBatches[6], nrSC_N_leq4); batch < nrBatches; batch++) {
+			int batchFirst = batchBound(nrSC_N_leq4, nrBatches, batch);
+			int nrInBatch = batchBound(nrSC_N_leq4, nrBatches, batch + 1) - batchFirst;
+
+			if (isGauss) {
+				//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
+				//tot_new = tot;
+				//cardinalityOfComms_new = cardinalityOfComms;
+			}
+			wrpSz = QUARTER_WARP / 2;
+			nr_of_block = (nrInBatch + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
 
+			bucketSizePerWarp = LEQ4_TABLE_SIZE;
+			sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * tableItemSize(deterministic);
 			/*
+
 			   if (0) {
 			   std::cin>>sc;
 
@@ -711,7 +1279,7 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 			cudaEventRecord(start, 0);
 
 			//print_vector(in, "in (*): ");
-			neigh_comm << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
+			moveLeq4 << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
 					community_size,
 					thrust::raw_pointer_cast(g.indices.data()),
 					thrust::raw_pointer_cast(g.links.data()),
@@ -721,37 +1289,39 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 					thrust::raw_pointer_cast(tot.data()), g.type,
 					thrust::raw_pointer_cast(n2c_new.data()),
 					thrust::raw_pointer_cast(tot_new.data()),
-					thrust::raw_pointer_cast(movement_counters.data()),
+					moveRecord,
 					g.total_weight, bucketSizePerWarp,
-					thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16,
-					nrC_N_leq8, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
+					candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + nrC_N_leq8 + batchFirst,
+					nrInBatch, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
 					thrust::raw_pointer_cast(cardinalityOfComms.data()),
 					thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
 					wrpSz, thrust::raw_pointer_cast(wDegs.data()));
 
+			if (measuring)
+				measureBin(binCosts[6], candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + nrC_N_leq8 + batchFirst,
+						nrInBatch, g, n2c, n2c_new, conflictCounts, start, stop);
+
 			//print_vector(in, "in (*): ");
-			report_time(start, stop, "neigh_comm ( <=8)");
-			//nb_moves = nb_moves + thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrC_N_leq8, (int) 0);
+
+			report_time(start, stop, "neigh_comm ( <=4)");
+			if (telemetry)
+				recordBin(telemetry, level, loopCnt, 6, nrInBatch, movement_counters, nrInBatch, start, stop);
+			//nb_moves = nb_moves + thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrInBatch, (int) 0);
 
 			/*
 			   changeAssignment<<< nr_of_block, NR_THREAD_PER_BLOCK>>>(  
 			   thrust::raw_pointer_cast(n2c.data()), // change from
 			   thrust::raw_pointer_cast(n2c_new.data()), // change to
-			   thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16,
-			   nrC_N_leq8);
+			   candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + nrC_N_leq8 ,
+			   nrInBatch);
 			 */
 
-			if (isGauss) {
+			if (deterministic)
+				settleMoves(candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + nrC_N_leq8 + batchFirst, nrInBatch,
+						n2c, n2c_new, wDegs, totFixed, tot_new, gravityScale);
 
+			if (isGauss) {
 				if (isToUpdate) {
-					assert(community_size == n2c.size());
-					assert(community_size == n2c_new.size());
-					assert(community_size == tot.size());
-					assert(community_size == tot_new.size());
-					assert(community_size == cardinalityOfComms.size());
-					assert(community_size == cardinalityOfComms_new.size());
-
-
 					nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
 					update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
 							thrust::raw_pointer_cast(tot.data()),
@@ -767,351 +1337,244 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 				}
 			}
 		}
+	}
 
-	if (nrC_N_leq16) {
-
-		if (isGauss) {
-			//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
-			//tot_new = tot;
-			//cardinalityOfComms_new = cardinalityOfComms;
-		}
 
-		wrpSz = HALF_WARP;
-		nr_of_block = (nrC_N_leq16 + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
+	if (nrSC_N_leq32) {
+		for (int batch = 0, nrBatches = std::min(binBatches[3], nrSC_N_leq32); batch < nrBatches; batch++) {
+			int batchFirst = batchBound(nrSC_N_leq32, nrBatches, batch);
+			int nrInBatch = batchBound(nrSC_N_leq32, nrBatches, batch + 1) - batchFirst;
 
-		bucketSizePerWarp = 31; // MUST BE PRIME
-		sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * sizeof (HashItem);
+			if (isGauss) {
+				//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
+				//tot_new = tot;
+				//cardinalityOfComms_new = cardinalityOfComms;
+			}
 
-		cudaEventRecord(start, 0);
+			wrpSz = PHY_WRP_SZ;
+			nr_of_block = (nrInBatch + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
 
-		neigh_comm << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
-				community_size,
-				thrust::raw_pointer_cast(g.indices.data()),
-				thrust::raw_pointer_cast(g.links.data()),
-				thrust::raw_pointer_cast(g.weights.data()),
-				thrust::raw_pointer_cast(n2c.data()),
-				thrust::raw_pointer_cast(in.data()),
-				thrust::raw_pointer_cast(tot.data()), g.type,
-				thrust::raw_pointer_cast(n2c_new.data()),
-				thrust::raw_pointer_cast(tot_new.data()),
-				thrust::raw_pointer_cast(movement_counters.data()),
-				g.total_weight, bucketSizePerWarp,
-				thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32,
-				nrC_N_leq16, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
-				thrust::raw_pointer_cast(cardinalityOfComms.data()),
-				thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
-				wrpSz, thrust::raw_pointer_cast(wDegs.data()));
+			bucketSizePerWarp = LEQ32_TABLE_SIZE;
+			sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * tableItemSize(deterministic);
 
-		report_time(start, stop, "neigh_comm ( <=16)");
-		//nb_moves = nb_moves + thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrC_N_leq16, (int) 0);
+			cudaEventRecord(start, 0);
 
-		/*
-		   changeAssignment<<< nr_of_block, NR_THREAD_PER_BLOCK>>>(  
-		   thrust::raw_pointer_cast(n2c.data()), // change from
-		   thrust::raw_pointer_cast(n2c_new.data()), // change to
-		   thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32,
-		   nrC_N_leq16);
-		 */
+			moveLeq32 << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
+					community_size,
+					thrust::raw_pointer_cast(g.indices.data()),
+					thrust::raw_pointer_cast(g.links.data()),
+					thrust::raw_pointer_cast(g.weights.data()),
+					thrust::raw_pointer_cast(n2c.data()),
+					thrust::raw_pointer_cast(in.data()),
+					thrust::raw_pointer_cast(tot.data()), g.type,
+					thrust::raw_pointer_cast(n2c_new.data()),
+					thrust::raw_pointer_cast(tot_new.data()),
+					moveRecord,
+					g.total_weight, bucketSizePerWarp,
+					candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + batchFirst,
+					nrInBatch, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
+					thrust::raw_pointer_cast(cardinalityOfComms.data()),
+					thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
+					wrpSz, thrust::raw_pointer_cast(wDegs.data()));
 
-		if (isGauss) {
-			if (isToUpdate) {
-				nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
-				update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
-						thrust::raw_pointer_cast(tot.data()),
-						thrust::raw_pointer_cast(tot_new.data()),
-						thrust::raw_pointer_cast(n2c.data()),
-						thrust::raw_pointer_cast(n2c_new.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
-			} else {
-				n2c = n2c_new;
-				tot = tot_new;
-				cardinalityOfComms = cardinalityOfComms_new;
+			if (measuring)
+				measureBin(binCosts[3], candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + batchFirst,
+						nrInBatch, g, n2c, n2c_new, conflictCounts, start, stop);
+
+			report_time(start, stop, "neigh_comm(<=32)");
+			if (telemetry)
+				recordBin(telemetry, level, loopCnt, 3, nrInBatch, movement_counters, nrInBatch, start, stop);
+			//nb_moves = nb_moves + thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrInBatch, (int) 0);
+
+			if (0) {
+				changeAssignment << < nr_of_block, NR_THREAD_PER_BLOCK>>>(
+						thrust::raw_pointer_cast(n2c.data()), // change from
+						thrust::raw_pointer_cast(n2c_new.data()), // change to
+						candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + batchFirst,
+						nrInBatch);
 			}
-		}
-	}
-
-
-
 
-	if (nrC_N_leq4) {
-
-
-		if (isGauss) {
-			//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
-			//tot_new = tot;
-			//cardinalityOfComms_new = cardinalityOfComms;
-		}
-		wrpSz = QUARTER_WARP / 2;
-		nr_of_block = (nrC_N_leq4 + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
-
-		bucketSizePerWarp = 7; // MUST BE PRIME
-		sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * sizeof (HashItem);
-		/*
-
-		   if (0) {
-		   std::cin>>sc;
+			if (deterministic)
+				settleMoves(candidates + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + batchFirst, nrInBatch,
+						n2c, n2c_new, wDegs, totFixed, tot_new, gravityScale);
 
-		   print_vector(g.indices, "g.indices: ");
-		   print_vector(g.links, "g.links: ");
-		   print_vector(n2c, "n2c:");
-		   print_vector(in, "in: ");
-		   print_vector(tot, "tot:");
-		   print_vector(n2c_new, "n2c_new:");
-		   print_vector(tot_new, "tot_new:");
-		   print_vector(movement_counters, "movement_counters:");
-		   print_vector(g_next.indices, "g_next.indices:");
-		   print_vector(devPrimes, "devPrimes:");
-		   print_vector(cardinalityOfComms, "cardinalityOfComms:");
-		   print_vector(cardinalityOfComms_new, "cardinalityOfComms_new:");
-		   }
-		 */
-		cudaEventRecord(start, 0);
-
-		//print_vector(in, "in (*): ");
-		neigh_comm << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
-				community_size,
-				thrust::raw_pointer_cast(g.indices.data()),
-				thrust::raw_pointer_cast(g.links.data()),
-				thrust::raw_pointer_cast(g.weights.data()),
-				thrust::raw_pointer_cast(n2c.data()),
-				thrust::raw_pointer_cast(in.data()),
-				thrust::raw_pointer_cast(tot.data()), g.type,
-				thrust::raw_pointer_cast(n2c_new.data()),
-				thrust::raw_pointer_cast(tot_new.data()),
-				thrust::raw_pointer_cast(movement_counters.data()),
-				g.total_weight, bucketSizePerWarp,
-				thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + nrC_N_leq8,
-				nrC_N_leq4, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
-				thrust::raw_pointer_cast(cardinalityOfComms.data()),
-				thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
-				wrpSz, thrust::raw_pointer_cast(wDegs.data()));
-
-		//print_vector(in, "in (*): ");
-
-		report_time(start, stop, "neigh_comm ( <=4)");
-		//nb_moves = nb_moves + thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrC_N_leq4, (int) 0);
-
-		/*
-		   changeAssignment<<< nr_of_block, NR_THREAD_PER_BLOCK>>>(  
-		   thrust::raw_pointer_cast(n2c.data()), // change from
-		   thrust::raw_pointer_cast(n2c_new.data()), // change to
-		   thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp + nrC_N_leq32 + nrC_N_leq16 + nrC_N_leq8 ,
-		   nrC_N_leq4);
-		 */
-
-		if (isGauss) {
-			if (isToUpdate) {
-				nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
-				update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
-						thrust::raw_pointer_cast(tot.data()),
-						thrust::raw_pointer_cast(tot_new.data()),
-						thrust::raw_pointer_cast(n2c.data()),
-						thrust::raw_pointer_cast(n2c_new.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
-			} else {
-				n2c = n2c_new;
-				tot = tot_new;
-				cardinalityOfComms = cardinalityOfComms_new;
+			if (isGauss) {
+				if (isToUpdate) {
+					nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+					update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+							thrust::raw_pointer_cast(tot.data()),
+							thrust::raw_pointer_cast(tot_new.data()),
+							thrust::raw_pointer_cast(n2c.data()),
+							thrust::raw_pointer_cast(n2c_new.data()),
+							thrust::raw_pointer_cast(cardinalityOfComms.data()),
+							thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
+				} else {
+					n2c = n2c_new;
+					tot = tot_new;
+					cardinalityOfComms = cardinalityOfComms_new;
+				}
 			}
 		}
 	}
 
 
-	if (nrC_N_leq32) {
-
-		if (isGauss) {
-			//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
-			//tot_new = tot;
-			//cardinalityOfComms_new = cardinalityOfComms;
-		}
-
-		wrpSz = PHY_WRP_SZ;
-		nr_of_block = (nrC_N_leq32 + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
-
-		bucketSizePerWarp = 61; //MUST BE PRIME
-		sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * sizeof (HashItem);
-
-		cudaEventRecord(start, 0);
+	if (nrSCforWrp) {
+		for (int batch = 0, nrBatches = std::min(binBatches[2], nrSCforWrp); batch < nrBatches; batch++) {
+			int batchFirst = batchBound(nrSCforWrp, nrBatches, batch);
+			int nrInBatch = batchBound(nrSCforWrp, nrBatches, batch + 1) - batchFirst;
 
-		neigh_comm << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
-				community_size,
-				thrust::raw_pointer_cast(g.indices.data()),
-				thrust::raw_pointer_cast(g.links.data()),
-				thrust::raw_pointer_cast(g.weights.data()),
-				thrust::raw_pointer_cast(n2c.data()),
-				thrust::raw_pointer_cast(in.data()),
-				thrust::raw_pointer_cast(tot.data()), g.type,
-				thrust::raw_pointer_cast(n2c_new.data()),
-				thrust::raw_pointer_cast(tot_new.data()),
-				thrust::raw_pointer_cast(movement_counters.data()),
-				g.total_weight, bucketSizePerWarp,
-				thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp,
-				nrC_N_leq32, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
-				thrust::raw_pointer_cast(cardinalityOfComms.data()),
-				thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
-				wrpSz, thrust::raw_pointer_cast(wDegs.data()));
-
-		report_time(start, stop, "neigh_comm(<=32)");
-		//nb_moves = nb_moves + thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrC_N_leq32, (int) 0);
-
-		if (0) {
-			changeAssignment << < nr_of_block, NR_THREAD_PER_BLOCK>>>(
-					thrust::raw_pointer_cast(n2c.data()), // change from
-					thrust::raw_pointer_cast(n2c_new.data()), // change to
-					thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem + nrCforWrp,
-					nrC_N_leq32);
-		}
-
-		if (isGauss) {
-			if (isToUpdate) {
-				nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
-				update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
-						thrust::raw_pointer_cast(tot.data()),
-						thrust::raw_pointer_cast(tot_new.data()),
-						thrust::raw_pointer_cast(n2c.data()),
-						thrust::raw_pointer_cast(n2c_new.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
-			} else {
-				n2c = n2c_new;
-				tot = tot_new;
-				cardinalityOfComms = cardinalityOfComms_new;
+			if (isGauss) {
+				//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
+				//tot_new = tot;
+				//cardinalityOfComms_new = cardinalityOfComms;
 			}
-		}
-	}
-
-
-	if (nrCforWrp) {
-
-		if (isGauss) {
-			//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
-			//tot_new = tot;
-			//cardinalityOfComms_new = cardinalityOfComms;
-		}
 
 
-		wrpSz = PHY_WRP_SZ;
-		nr_of_block = (nrCforWrp + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
+			wrpSz = PHY_WRP_SZ;
+			nr_of_block = (nrInBatch + (NR_THREAD_PER_BLOCK / wrpSz) - 1) / (NR_THREAD_PER_BLOCK / wrpSz);
 
-		bucketSizePerWarp = WARP_TABLE_SIZE_1;
-		sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * sizeof (HashItem);
+			bucketSizePerWarp = WARP_TABLE_SIZE_1;
+			sizeHashMem = (NR_THREAD_PER_BLOCK / wrpSz) * bucketSizePerWarp * tableItemSize(deterministic);
 
-		cudaEventRecord(start, 0);
+			cudaEventRecord(start, 0);
 
-		neigh_comm << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
-				community_size,
-				thrust::raw_pointer_cast(g.indices.data()),
-				thrust::raw_pointer_cast(g.links.data()),
-				thrust::raw_pointer_cast(g.weights.data()),
-				thrust::raw_pointer_cast(n2c.data()),
-				thrust::raw_pointer_cast(in.data()),
-				thrust::raw_pointer_cast(tot.data()), g.type,
-				thrust::raw_pointer_cast(n2c_new.data()),
-				thrust::raw_pointer_cast(tot_new.data()),
-				thrust::raw_pointer_cast(movement_counters.data()),
-				g.total_weight, bucketSizePerWarp,
-				thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem,
-				nrCforWrp, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
-				thrust::raw_pointer_cast(cardinalityOfComms.data()),
-				thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
-				wrpSz, thrust::raw_pointer_cast(wDegs.data()));
+			moveWrp << < nr_of_block, NR_THREAD_PER_BLOCK, sizeHashMem >>>(
+					community_size,
+					thrust::raw_pointer_cast(g.indices.data()),
+					thrust::raw_pointer_cast(g.links.data()),
+					thrust::raw_pointer_cast(g.weights.data()),
+					thrust::raw_pointer_cast(n2c.data()),
+					thrust::raw_pointer_cast(in.data()),
+					thrust::raw_pointer_cast(tot.data()), g.type,
+					thrust::raw_pointer_cast(n2c_new.data()),
+					thrust::raw_pointer_cast(tot_new.data()),
+					moveRecord,
+					g.total_weight, bucketSizePerWarp,
+					candidates + nrCforBlkGMem + nrCforBlkSMem + batchFirst,
+					nrInBatch, thrust::raw_pointer_cast(devPrimes.data()), nb_prime,
+					thrust::raw_pointer_cast(cardinalityOfComms.data()),
+					thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
+					wrpSz, thrust::raw_pointer_cast(wDegs.data()));
 
-		report_time(start, stop, "neigh_comm");
-		//nb_moves = thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrCforWrp, (int) 0);
+			if (measuring)
+				measureBin(binCosts[2], candidates + nrCforBlkGMem + nrCforBlkSMem + batchFirst,
+						nrInBatch, g, n2c, n2c_new, conflictCounts, start, stop);
+
+			report_time(start, stop, "neigh_comm");
+			if (telemetry)
+				recordBin(telemetry, level, loopCnt, 2, nrInBatch, movement_counters, nrInBatch, start, stop);
+			//nb_moves = thrust::reduce(movement_counters.begin(), movement_counters.begin() + nrInBatch, (int) 0);
+
+			// change community assignment of processed vertices
+			if (0) {
+				changeAssignment << < nr_of_block, NR_THREAD_PER_BLOCK>>>(
+						thrust::raw_pointer_cast(n2c.data()), // change from
+						thrust::raw_pointer_cast(n2c_new.data()), // change to
+						candidates + nrCforBlkGMem + nrCforBlkSMem + batchFirst, // of these communities
+						nrInBatch);
+			}
 
-		// change community assignment of processed vertices
-		if (0) {
-			changeAssignment << < nr_of_block, NR_THREAD_PER_BLOCK>>>(
-					thrust::raw_pointer_cast(n2c.data()), // change from
-					thrust::raw_pointer_cast(n2c_new.data()), // change to
-					thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem + nrCforBlkSMem, // of these communities
-					nrCforWrp);
-		}
+			if (deterministic)
+				settleMoves(candidates + nrCforBlkGMem + nrCforBlkSMem + batchFirst, nrInBatch,
+						n2c, n2c_new, wDegs, totFixed, tot_new, gravityScale);
 
-		if (isGauss) {
-			if (isToUpdate) {
-				nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
-				update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
-						thrust::raw_pointer_cast(tot.data()),
-						thrust::raw_pointer_cast(tot_new.data()),
-						thrust::raw_pointer_cast(n2c.data()),
-						thrust::raw_pointer_cast(n2c_new.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
-			} else {
-				n2c = n2c_new;
-				tot = tot_new;
-				cardinalityOfComms = cardinalityOfComms_new;
+			if (isGauss) {
+				if (isToUpdate) {
+					nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+					update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+							thrust::raw_pointer_cast(tot.data()),
+							thrust::raw_pointer_cast(tot_new.data()),
+							thrust::raw_pointer_cast(n2c.data()),
+							thrust::raw_pointer_cast(n2c_new.data()),
+							thrust::raw_pointer_cast(cardinalityOfComms.data()),
+							thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
+				} else {
+					n2c = n2c_new;
+					tot = tot_new;
+					cardinalityOfComms = cardinalityOfComms_new;
+				}
 			}
 		}
 	}
 
-	if (nrCforBlkSMem > 0) {
+	if (nrSCforBlkSMem > 0) {
+		for (int batch = 0, nrBatches = std::min(binBatches[1], nrSCforBlkSMem); batch < nrBatches; batch++) {
+			int batchFirst = batchBound(nrSCforBlkSMem, nrBatches, batch);
+			int nrInBatch = batchBound(nrSCforBlkSMem, nrBatches, batch + 1) - batchFirst;
 
+			if (isGauss) {
+				//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
+				//tot_new = tot;
+				//cardinalityOfComms_new = cardinalityOfComms;
+			}
 
-		if (isGauss) {
-			//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
-			//tot_new = tot;
-			//cardinalityOfComms_new = cardinalityOfComms;
-		}
+			wrpSz = PHY_WRP_SZ;
+			cudaEventRecord(start, 0);
 
-		wrpSz = PHY_WRP_SZ;
-		cudaEventRecord(start, 0);
+			//std::cout<<" nrBlockForLargeNhoods :"<<nrBlockForLargeNhoods<<"   nrCforBlkSMem: "<<   nrCforBlkSMem<<std::endl;
 
-		//std::cout<<" nrBlockForLargeNhoods :"<<nrBlockForLargeNhoods<<"   nrCforBlkSMem: "<<   nrCforBlkSMem<<std::endl;
+			moveBlk << <nrBlockForLargeNhoods, NR_THREAD_PER_BLOCK>>>(
+					thrust::raw_pointer_cast(g.indices.data()),
+					thrust::raw_pointer_cast(g.links.data()),
+					thrust::raw_pointer_cast(g.weights.data()),
+					thrust::raw_pointer_cast(n2c.data()),
+					thrust::raw_pointer_cast(in.data()),
+					thrust::raw_pointer_cast(tot.data()), g.type,
+					thrust::raw_pointer_cast(n2c_new.data()),
+					NULL,
+					thrust::raw_pointer_cast(tot_new.data()),
+					blkMoveRecord, g.total_weight,
+					candidates + nrCforBlkGMem + batchFirst, nrInBatch,
+					thrust::raw_pointer_cast(globalHashTable.data()),
+					thrust::raw_pointer_cast(hashTablePtrs.data()),
+					thrust::raw_pointer_cast(devPrimes.data()), nb_prime, wrpSz,
+					thrust::raw_pointer_cast(cardinalityOfComms.data()),
+					thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
+					thrust::raw_pointer_cast(wDegs.data()),
+					thrust::raw_pointer_cast(denseTables.data()), nrDenseTables, community_size);
+
+			if (measuring)
+				measureBin(binCosts[1], candidates + nrCforBlkGMem + batchFirst,
+						nrInBatch, g, n2c, n2c_new, conflictCounts, start, stop);
+			report_time(start, stop, "lookAtNeigboringComms(sh)");
+			if (telemetry)
+				recordBin(telemetry, level, loopCnt, 1, nrInBatch, moveCounters, nrBlockForLargeNhoods, start, stop);
+			//nb_moves = nb_moves + thrust::reduce(moveCounters.begin(), moveCounters.begin() + nrBlockForLargeNhoods, (int) 0);
+			/*
+			   if (0) {
+			   changeAssignment << < nr_of_block, NR_THREAD_PER_BLOCK>>>(
+			   thrust::raw_pointer_cast(n2c.data()), // change from
+			   thrust::raw_pointer_cast(n2c_new.data()), // change to
+			   candidates + nrCforBlkGMem + batchFirst, nrInBatch);
+			   }
+			 */
 
-		lookAtNeigboringComms << <nrBlockForLargeNhoods, NR_THREAD_PER_BLOCK>>>(
-				thrust::raw_pointer_cast(g.indices.data()),
-				thrust::raw_pointer_cast(g.links.data()),
-				thrust::raw_pointer_cast(g.weights.data()),
-				thrust::raw_pointer_cast(n2c.data()),
-				thrust::raw_pointer_cast(in.data()),
-				thrust::raw_pointer_cast(tot.data()), g.type,
-				thrust::raw_pointer_cast(n2c_new.data()),
-				NULL,
-				thrust::raw_pointer_cast(tot_new.data()),
-				thrust::raw_pointer_cast(moveCounters.data()), g.total_weight,
-				thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem, nrCforBlkSMem,
-				thrust::raw_pointer_cast(globalHashTable.data()),
-				thrust::raw_pointer_cast(hashTablePtrs.data()),
-				thrust::raw_pointer_cast(devPrimes.data()), nb_prime, wrpSz,
-				thrust::raw_pointer_cast(cardinalityOfComms.data()),
-				thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
-				thrust::raw_pointer_cast(wDegs.data()));
-		report_time(start, stop, "lookAtNeigboringComms(sh)");
-		//nb_moves = nb_moves + thrust::reduce(moveCounters.begin(), moveCounters.begin() + nrBlockForLargeNhoods, (int) 0);
-		/*
-		   if (0) {
-		   changeAssignment << < nr_of_block, NR_THREAD_PER_BLOCK>>>(
-		   thrust::raw_pointer_cast(n2c.data()), // change from
-		   thrust::raw_pointer_cast(n2c_new.data()), // change to
-		   thrust::raw_pointer_cast(g_next.indices.data()) + nrCforBlkGMem, nrCforBlkSMem);
-		   }
-		 */
+			if (deterministic)
+				settleMoves(candidates + nrCforBlkGMem + batchFirst, nrInBatch,
+						n2c, n2c_new, wDegs, totFixed, tot_new, gravityScale);
 
-		if (isGauss) {
-			if (isToUpdate) {
-				nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
-				update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
-						thrust::raw_pointer_cast(tot.data()),
-						thrust::raw_pointer_cast(tot_new.data()),
-						thrust::raw_pointer_cast(n2c.data()),
-						thrust::raw_pointer_cast(n2c_new.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms.data()),
-						thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
-			} else {
-				n2c = n2c_new;
-				tot = tot_new;
-				cardinalityOfComms = cardinalityOfComms_new;
+			if (isGauss) {
+				if (isToUpdate) {
+					nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+					update << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+							thrust::raw_pointer_cast(tot.data()),
+							thrust::raw_pointer_cast(tot_new.data()),
+							thrust::raw_pointer_cast(n2c.data()),
+							thrust::raw_pointer_cast(n2c_new.data()),
+							thrust::raw_pointer_cast(cardinalityOfComms.data()),
+							thrust::raw_pointer_cast(cardinalityOfComms_new.data()));
+				} else {
+					n2c = n2c_new;
+					tot = tot_new;
+					cardinalityOfComms = cardinalityOfComms_new;
+				}
 			}
 		}
 	}
 
 #ifdef LARGE_LATER
 
-	if (nrCforBlkGMem > 0) {
+	if (nrSCforBlkGMem > 0) {
 
 		if (isGauss) {
 			//thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0); // initialize in to all zeros '0'
@@ -1124,7 +1587,7 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 		cudaEventRecord(start, 0);
 
 		//std::cout<<" nrBlockForLargeNhoods: "<<nrBlockForLargeNhoods<<" nrCforBlkGMem:  "<<  nrCforBlkGMem<<std::endl;
-		lookAtNeigboringComms << <nrBlockForLargeNhoods, (NR_THREAD_PER_BLOCK * 2)>>>(
+		moveBlk << <nrBlockForLargeNhoods, (NR_THREAD_PER_BLOCK * 2)>>>(
 				thrust::raw_pointer_cast(g.indices.data()),
 				thrust::raw_pointer_cast(g.links.data()),
 				thrust::raw_pointer_cast(g.weights.data()),
@@ -1134,16 +1597,19 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 				thrust::raw_pointer_cast(n2c_new.data()),
 				NULL,
 				thrust::raw_pointer_cast(tot_new.data()),
-				thrust::raw_pointer_cast(moveCounters.data()), g.total_weight,
-				thrust::raw_pointer_cast(g_next.indices.data()), nrCforBlkGMem,
+				blkMoveRecord, g.total_weight,
+				candidates, nrSCforBlkGMem,
 				thrust::raw_pointer_cast(globalHashTable.data()),
 				thrust::raw_pointer_cast(hashTablePtrs.data()),
 				thrust::raw_pointer_cast(devPrimes.data()), nb_prime, wrpSz,
 				thrust::raw_pointer_cast(cardinalityOfComms.data()),
 				thrust::raw_pointer_cast(cardinalityOfComms_new.data()),
-				thrust::raw_pointer_cast(wDegs.data()));
+				thrust::raw_pointer_cast(wDegs.data()),
+				thrust::raw_pointer_cast(denseTables.data()), nrDenseTables, community_size);
 
 		report_time(start, stop, "lookAtNeigboringComms");
+		if (telemetry)
+			recordBin(telemetry, level, loopCnt, 0, nrSCforBlkGMem, moveCounters, nrBlockForLargeNhoods, start, stop);
 		//nb_moves = nb_moves + thrust::reduce(moveCounters.begin(), moveCounters.begin() + nrBlockForLargeNhoods, (int) 0);
 
 		/*
@@ -1151,10 +1617,14 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 		   changeAssignment << < nr_of_block, NR_THREAD_PER_BLOCK>>>(
 		   thrust::raw_pointer_cast(n2c.data()), // change from
 		   thrust::raw_pointer_cast(n2c_new.data()), // change to
-		   thrust::raw_pointer_cast(g_next.indices.data()), nrCforBlkGMem);
+		   candidates, nrSCforBlkGMem);
 		   }
 		 */
 
+		if (deterministic)
+			settleMoves(candidates, nrSCforBlkGMem,
+					n2c, n2c_new, wDegs, totFixed, tot_new, gravityScale);
+
 		if (isGauss) {
 			if (isToUpdate) {
 				nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
@@ -1228,11 +1698,83 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 	}
 
 	 */
-	new_mod = modularity(tot, in);
+	if (isSampledSweep) {
+
+		// in holds contributions of the sampled vertices only
+		thrust::fill_n(thrust::device, in.begin(), in.size(), 0.0);
+
+		wrpSz = PHY_WRP_SZ;
+		load_per_blk = CHUNK_PER_WARP * (NR_THREAD_PER_BLOCK / wrpSz);
+		nr_of_block = (community_size + load_per_blk - 1) / load_per_blk;
+
+		computeInternals << <nr_of_block, NR_THREAD_PER_BLOCK>>>(thrust::raw_pointer_cast(g.indices.data()),
+				thrust::raw_pointer_cast(g.links.data()),
+				thrust::raw_pointer_cast(g.weights.data()),
+				thrust::raw_pointer_cast(n2c_new.data()),
+				thrust::raw_pointer_cast(in.data()), community_size, g.type);
+	}
+
+	// tot is not committed per bin in Jacobi mode
+	new_mod = modularity(isSampledSweep ? tot_new : tot, in);
 
 
 	double scur_mod = cur_mod;
 	double snew_mod = new_mod;
+
+	struct timespec sweepEnd;
+	clock_gettime(CLOCK_MONOTONIC, &sweepEnd);
+	// a sampled sweep says little about a full one
+	if (!isSampledSweep || deadline.sweepPerLink < 0)
+		deadline.recordSweep((sweepEnd.tv_sec - sweepStart.tv_sec) + (sweepEnd.tv_nsec - sweepStart.tv_nsec) / 1.0e9, g.nb_links);
+
+	if (telemetry) {
+
+		SweepRecord record;
+		record.level = level;
+		record.sweep = loopCnt;
+		record.modBefore = cur_mod;
+		record.modAfter = new_mod;
+		record.threshold = threshold;
+		record.easyThreshold = isEasyThreshold;
+		record.fraction = isSampledSweep ? fraction : 1.0;
+		record.accepted = (new_mod - cur_mod) >= threshold;
+		record.nrMoved = telemetry->movedInSweep(level, loopCnt);
+		record.seconds = (sweepEnd.tv_sec - sweepStart.tv_sec) + (sweepEnd.tv_nsec - sweepStart.tv_nsec) / 1.0e9;
+		telemetry->sweeps.push_back(record);
+	}
+
+	if (isSampledSweep) {
+
+		double gain = new_mod - cur_mod;
+
+		if (prevGain > 0 && gain < sampleBudget * prevGain)
+			fraction = thrust::min(2 * fraction, 1.0);
+
+		if (gain < threshold) {
+
+			// A sampled sweep never ends the level; drop its moves if they
+			// made things worse and continue with a larger sample
+			if (gain < 0) {
+				n2c = n2c_saved;
+				tot = tot_saved;
+				cardinalityOfComms = cardinalityOfComms_saved;
+			} else {
+				n2c_old = n2c_new;
+				n2c = n2c_new;
+				tot = tot_new;
+				cardinalityOfComms = cardinalityOfComms_new;
+				cur_mod = new_mod;
+			}
+
+			fraction = 1.0;
+
+			LOG(LOG_DEBUG, nrIteration << " " << "Modularity   " << scur_mod << " --> "
+				<< snew_mod << " Gain: " << (snew_mod - scur_mod) << " (sampled, retry)");
+			continue;
+		}
+
+		prevGain = gain;
+	}
 	/*
 	   std::cout << nrIteration << " " << "Modularity   " << cur_mod << " --> " << new_mod <<
 	   " Gain: " << (new_mod - cur_mod) << std::endl;
@@ -1252,13 +1794,24 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 
 		improvement = true;
 
+		if (fraction < 1.0) {
+			n2c_saved = n2c;
+			tot_saved = tot;
+			cardinalityOfComms_saved = cardinalityOfComms;
+		}
+
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		modularityTrace.push_back(std::make_pair((now.tv_sec - runStart.tv_sec) + (now.tv_nsec - runStart.tv_nsec) / 1.0e9, cur_mod));
+
 	} else {
 		//std::cout << "Break the loop " << std::endl;
 		break;
 	}
 	if (nrIteration)
-		std::cout << nrIteration << " " << "Modularity   " << scur_mod << " --> "
-			<< snew_mod << " Gain: " << (snew_mod - scur_mod) << std::endl;
+		LOG(LOG_DEBUG, nrIteration << " " << "Modularity   " << scur_mod << " --> "
+			<< snew_mod << " Gain: " << (snew_mod - scur_mod)
+			<< (isSampledSweep ? " (sampled)" : ""));
 
 
 	/*
@@ -1275,7 +1828,7 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 	t2 = clock();
 	float diff = (float)t2 - (float) t1;
 	float seconds = diff / CLOCKS_PER_SEC;
-	std::cout<< "iteration "<<(nrIteration+1)<<": "<<seconds<<" sec"<<std::endl;
+	LOG(LOG_DEBUG, "iteration "<<(nrIteration+1)<<": "<<seconds<<" sec");
 
 	} while (++nrIteration < 1000);
 
@@ -1310,9 +1863,10 @@ double Community::one_levelGaussSeidel(double init_mod, bool isLastRound,
 	g_next.indices.clear();
 	g_next.links.clear();
 	n2c_new.clear(); // <-----------
-	wDegs.clear();
+	// wDegs stay in the bundle for the contraction
 	//cudaEventDestroy(start);
 	//cudaEventDestroy(stop);
+	memory.endPhase(memoryStrategy, nrBlockForLargeNhoods, 1, predictedPeak);
 	return cur_mod;
 }
 
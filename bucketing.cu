@@ -0,0 +1,167 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"bucketing.h"
+#include"commonconstants.h"
+#include"devconstants.h"
+#include"thrust/scan.h"
+#include"thrust/iterator/transform_iterator.h"
+
+// The scan over the keys carries (items so far, used keys so far) packed
+// into one 64-bit sum
+
+struct PackCount : public thrust::unary_function<int, unsigned long long> {
+#ifdef RUNONGPU
+
+    __host__ __device__
+#endif
+    unsigned long long operator()(int count) {
+        return ((unsigned long long) count << 32) + (count > 0);
+    }
+};
+
+// Item of this lane for the warp's turn at position "first"; the loops
+// run warp-uniform so that all lanes take part in the ballots
+
+static __device__ int keyOfLane(const int* keys, int nrItems, const int* indices, int item) {
+
+    if (item >= nrItems)
+        return -1;
+    if (indices && indices[item + 1] == indices[item])
+        return -1;
+    return keys[item];
+}
+
+// Lanes with the same key add up once: the lowest such lane adds their
+// number and hands each its own rank; returns counter + rank
+
+static __device__ int aggregatedAdd(int* counters, int key, bool wantsPosition) {
+
+    unsigned int laneId = threadIdx.x % PHY_WRP_SZ;
+    unsigned int pending = __ballot(key >= 0);
+    int position = -1;
+
+    while (pending) {
+        int leader = __ffs(pending) - 1;
+        int leaderKey = __shfl(key, leader);
+        unsigned int peers = __ballot(key == leaderKey);
+
+        int base = 0;
+        if (laneId == leader)
+            base = atomicAdd(&counters[leaderKey], __popc(peers));
+        if (wantsPosition) {
+            base = __shfl(base, leader);
+            if (key == leaderKey)
+                position = base + __popc(peers & ((1u << laneId) - 1));
+        }
+        pending &= ~peers;
+    }
+    return position;
+}
+
+__global__
+void countKeys(const int* keys, int nrItems, const int* indices, int* counts) {
+
+    int stride = blockDim.x * gridDim.x;
+    int first = blockIdx.x * blockDim.x + (threadIdx.x / PHY_WRP_SZ) * PHY_WRP_SZ;
+
+    for (; first < nrItems; first += stride) {
+        int key = keyOfLane(keys, nrItems, indices, first + threadIdx.x % PHY_WRP_SZ);
+        aggregatedAdd(counts, key, false);
+    }
+}
+
+// Offsets of the used keys in bucket order; counts becomes the write
+// cursor of each key
+
+__global__
+void compactBuckets(int nrKeys, int* counts, const unsigned long long* packed,
+        int* newKeyOf, int* offsets) {
+
+    int key = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (key < nrKeys) {
+        int start = (int) (packed[key] >> 32);
+        if (counts[key] > 0) {
+            int bucket = (int) (packed[key] & 0xffffffffu);
+            newKeyOf[key] = bucket;
+            offsets[bucket] = start;
+        } else {
+            newKeyOf[key] = -1;
+        }
+        counts[key] = start;
+        key = key + blockDim.x * gridDim.x;
+    }
+}
+
+__global__
+void scatterKeys(const int* keys, int nrItems, const int* indices, int* cursors, int* grouped) {
+
+    int stride = blockDim.x * gridDim.x;
+    int first = blockIdx.x * blockDim.x + (threadIdx.x / PHY_WRP_SZ) * PHY_WRP_SZ;
+
+    for (; first < nrItems; first += stride) {
+        int item = first + threadIdx.x % PHY_WRP_SZ;
+        int key = keyOfLane(keys, nrItems, indices, item);
+        int position = aggregatedAdd(cursors, key, true);
+        if (key >= 0)
+            grouped[position] = item;
+    }
+}
+
+int bucketByKey(const thrust::device_vector<int>& keys, int nrKeys, const int* indices,
+        thrust::device_vector<int>& newKeyOf, thrust::device_vector<int>& offsets,
+        thrust::device_vector<int>& grouped) {
+
+    int nrItems = keys.size();
+    thrust::device_vector<int> counts(nrKeys, 0);
+    thrust::device_vector<unsigned long long> packed(nrKeys);
+
+    int nrBlocks = (nrItems + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+    if (nrItems)
+        countKeys << <nrBlocks, NR_THREAD_PER_BLOCK>>>(thrust::raw_pointer_cast(keys.data()), nrItems,
+                indices, thrust::raw_pointer_cast(counts.data()));
+
+    thrust::exclusive_scan(thrust::make_transform_iterator(counts.begin(), PackCount()),
+            thrust::make_transform_iterator(counts.end(), PackCount()), packed.begin());
+
+    unsigned long long total = nrKeys ? packed.back() + PackCount()(counts.back()) : 0;
+    int nrBuckets = (int) (total & 0xffffffffu);
+    int nrGrouped = (int) (total >> 32);
+
+    newKeyOf.resize(nrKeys);
+    offsets.resize(nrBuckets + 1);
+    offsets[nrBuckets] = nrGrouped;
+    grouped.resize(nrGrouped);
+
+    int nrKeyBlocks = (nrKeys + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+    if (nrKeys)
+        compactBuckets << <nrKeyBlocks, NR_THREAD_PER_BLOCK>>>(nrKeys, thrust::raw_pointer_cast(counts.data()),
+                thrust::raw_pointer_cast(packed.data()), thrust::raw_pointer_cast(newKeyOf.data()),
+                thrust::raw_pointer_cast(offsets.data()));
+
+    if (nrItems)
+        scatterKeys << <nrBlocks, NR_THREAD_PER_BLOCK>>>(thrust::raw_pointer_cast(keys.data()), nrItems,
+                indices, thrust::raw_pointer_cast(counts.data()), thrust::raw_pointer_cast(grouped.data()));
+
+    return nrBuckets;
+}
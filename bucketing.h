@@ -0,0 +1,40 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#ifndef BUCKETING_H
+#define	BUCKETING_H
+
+#include"thrust/device_vector.h"
+
+// Counting sort on the device, the counterpart of bucketByKeyHOST with
+// compact: in two passes over the items (count, then scatter, both with
+// warp-aggregated atomics) and one scan over the keys, items 0..nrItems-1
+// are grouped by keys[item] in [0, nrKeys). Bucket newKeyOf[key] (-1:
+// unused key) holds grouped[offsets[b]..offsets[b+1]); the order within a
+// bucket is not fixed. With indices (CSR offsets), items without
+// neighbors are left out. Returns the number of buckets.
+
+int bucketByKey(const thrust::device_vector<int>& keys, int nrKeys, const int* indices,
+        thrust::device_vector<int>& newKeyOf, thrust::device_vector<int>& offsets,
+        thrust::device_vector<int>& grouped);
+
+#endif	/* BUCKETING_H */
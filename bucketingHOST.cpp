@@ -0,0 +1,124 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"bucketingHOST.h"
+#include"hostconstants.h"
+#include"thread"
+#include"functional"
+#include"algorithm"
+
+static void runThreads(int nrThreads, std::function<void(int) > fn) {
+
+    if (nrThreads == 1) {
+        fn(0);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < nrThreads; t++)
+        workers.push_back(std::thread(fn, t));
+    for (int t = 0; t < nrThreads; t++)
+        workers[t].join();
+}
+
+int bucketByKeyHOST(const int* keys, size_t nrItems, int nrKeys, bool compact, int nrThreads,
+        std::vector<int>& newKeyOf, std::vector<int>& offsets, std::vector<int>& grouped) {
+
+    // Enough items per thread, and histograms together at most 4x the items
+    nrThreads = std::min(nrThreads, (int) (nrItems / HOST_BUCKET_GRAIN));
+    nrThreads = std::min((size_t) nrThreads, 4 * nrItems / std::max(nrKeys, 1));
+    nrThreads = std::max(1, nrThreads);
+
+    // Thread t owns items [itemBound(t), itemBound(t+1)) and, between the
+    // passes, keys [keyBound(t), keyBound(t+1))
+    auto itemBound = [&](int t) {
+        return (size_t) ((unsigned long long) nrItems * t / nrThreads);
+    };
+    auto keyBound = [&](int t) {
+        return (int) ((long long) nrKeys * t / nrThreads);
+    };
+
+    // hist[t * nrKeys + k]: items of key k in the range of thread t; turned
+    // into the position of the first of them
+    std::vector<int> hist((size_t) nrThreads * nrKeys, 0);
+
+    runThreads(nrThreads, [&](int t) {
+        int* myHist = &hist[(size_t) t * nrKeys];
+        for (size_t i = itemBound(t); i < itemBound(t + 1); i++)
+            myHist[keys[i]]++;
+    });
+
+    // Items and used keys of each key range
+    std::vector<long> rangeItems(nrThreads + 1, 0), rangeKeys(nrThreads + 1, 0);
+
+    runThreads(nrThreads, [&](int t) {
+        for (int k = keyBound(t); k < keyBound(t + 1); k++) {
+            long total = 0;
+            for (int u = 0; u < nrThreads; u++)
+                total += hist[(size_t) u * nrKeys + k];
+            rangeItems[t + 1] += total;
+            rangeKeys[t + 1] += (total > 0);
+        }
+    });
+
+    for (int t = 0; t < nrThreads; t++) {
+        rangeItems[t + 1] += rangeItems[t];
+        rangeKeys[t + 1] += rangeKeys[t];
+    }
+
+    int nrBuckets = compact ? rangeKeys[nrThreads] : nrKeys;
+    offsets.assign(nrBuckets + 1, 0);
+    offsets[nrBuckets] = nrItems;
+    if (compact)
+        newKeyOf.assign(nrKeys, -1);
+    else
+        newKeyOf.clear();
+
+    runThreads(nrThreads, [&](int t) {
+        long position = rangeItems[t];
+        int bucket = rangeKeys[t];
+        for (int k = keyBound(t); k < keyBound(t + 1); k++) {
+            long start = position;
+            for (int u = 0; u < nrThreads; u++) {
+                int count = hist[(size_t) u * nrKeys + k];
+                hist[(size_t) u * nrKeys + k] = position;
+                position += count;
+            }
+            if (!compact)
+                offsets[k] = start;
+            else if (position > start) {
+                newKeyOf[k] = bucket;
+                offsets[bucket++] = start;
+            }
+        }
+    });
+
+    grouped.resize(nrItems);
+
+    runThreads(nrThreads, [&](int t) {
+        int* myHist = &hist[(size_t) t * nrKeys];
+        for (size_t i = itemBound(t); i < itemBound(t + 1); i++)
+            grouped[myHist[keys[i]]++] = i;
+    });
+
+    return nrBuckets;
+}
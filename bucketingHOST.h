@@ -0,0 +1,39 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#ifndef BUCKETINGHOST_H
+#define	BUCKETINGHOST_H
+
+#include"vector"
+#include"stddef.h"
+
+// Counting sort of the items 0..nrItems-1 by keys[item] in [0, nrKeys), in
+// two passes over the items with one histogram per thread. Items of bucket
+// b are grouped[offsets[b]..offsets[b+1]), in increasing order. With
+// compact, unused keys get no bucket and newKeyOf[key] is the bucket of key
+// (-1: unused); otherwise bucket b is key b and newKeyOf is left empty.
+// Returns the number of buckets.
+
+int bucketByKeyHOST(const int* keys, size_t nrItems, int nrKeys, bool compact, int nrThreads,
+        std::vector<int>& newKeyOf, std::vector<int>& offsets, std::vector<int>& grouped);
+
+#endif	/* BUCKETINGHOST_H */
@@ -30,6 +30,7 @@
 
 #define WEIGHTED   0
 #define UNWEIGHTED 1
+#define ANY_GRAPH -1 // graph type is a runtime argument
 
 #define PRINTALL 0
 
@@ -26,6 +26,7 @@
 
 #include <functional>
 #include"numeric"
+#include"cmath"
 
 Community::Community(const GraphHOST& input_graph, int nb_pass, double min_mod) {
 
@@ -39,67 +40,138 @@ Community::Community(const GraphHOST& input_graph, int nb_pass, double min_mod)
 
     //Copy degree array into indices with an extra zero(0) at the beginning
     g.indices = thrust::device_vector<int>(input_graph.nb_nodes + 1, 0);
-    thrust::copy(input_graph.degrees.begin(), input_graph.degrees.end(), g.indices.begin() + 1); // 0 at first position
+    const unsigned long* cumDegree = input_graph.degreeData();
+    thrust::copy(cumDegree, cumDegree + input_graph.nb_nodes, g.indices.begin() + 1); // 0 at first position
 
     /********************Gather Graph Statistics***************/
-    std::vector< int> vtxDegs;
+    // Only printed; skipped unless the level is shown
+    if (LOG_ENABLED(LOG_INFO) && input_graph.maxDegree >= 0) {
+        // computed by the loader while reading
+        LOG(LOG_INFO, "MaxDeg = " << input_graph.maxDegree << " AvgDeg = " << input_graph.avgDegree << " STD = "
+                << input_graph.stdDegree << " STD2AvgRatio = " << input_graph.stdDegree / input_graph.avgDegree);
+    } else if (LOG_ENABLED(LOG_INFO)) {
+        std::vector< int> vtxDegs;
 
-    vtxDegs.resize(input_graph.degrees.size());
+        vtxDegs.resize(input_graph.nb_nodes);
 
-    std::adjacent_difference(input_graph.degrees.begin(), input_graph.degrees.end(), vtxDegs.begin());
+        std::adjacent_difference(cumDegree, cumDegree + input_graph.nb_nodes, vtxDegs.begin());
 
-    int totNbrs = std::accumulate(vtxDegs.begin(), vtxDegs.end(), 0);
-    int maxDeg = *std::max_element(vtxDegs.begin(), vtxDegs.end());
+        int totNbrs = std::accumulate(vtxDegs.begin(), vtxDegs.end(), 0);
+        int maxDeg = *std::max_element(vtxDegs.begin(), vtxDegs.end());
 
-    double sumSquareDiff = 0;
-    double avgDeg = (double) totNbrs / g.nb_nodes;
+        double sumSquareDiff = 0;
+        double avgDeg = (double) totNbrs / g.nb_nodes;
 
-    for (int i = 0; i < vtxDegs.size(); i++) {
-        double delta = ((double) vtxDegs[i] - avgDeg);
-        sumSquareDiff += delta*delta;
-    }
+        for (int i = 0; i < vtxDegs.size(); i++) {
+            double delta = ((double) vtxDegs[i] - avgDeg);
+            sumSquareDiff += delta*delta;
+        }
 
-    double standardDeviation = sqrt(sumSquareDiff / input_graph.nb_nodes);
+        double standardDeviation = sqrt(sumSquareDiff / input_graph.nb_nodes);
 
-    std::cout << "MaxDeg = " << maxDeg << " AvgDeg = " << avgDeg << " STD = "
-            << standardDeviation << " STD2AvgRatio = " << standardDeviation / avgDeg << std::endl;
+        LOG(LOG_INFO, "MaxDeg = " << maxDeg << " AvgDeg = " << avgDeg << " STD = "
+                << standardDeviation << " STD2AvgRatio = " << standardDeviation / avgDeg);
 
-    std::cout << "totNbrs =" << totNbrs << " #links =" << input_graph.nb_links << std::endl;
+        LOG(LOG_INFO, "totNbrs =" << totNbrs << " #links =" << input_graph.nb_links);
 
-    if (input_graph.nb_nodes < 10) {
-        std::cout << std::endl;
-        for (int i = 0; i < vtxDegs.size(); i++) {
-            std::cout << vtxDegs[i] << " ";
+        if (input_graph.nb_nodes < 10) {
+            std::ostringstream degreeList;
+            for (int i = 0; i < vtxDegs.size(); i++) {
+                degreeList << vtxDegs[i] << " ";
+            }
+            LOG(LOG_DEBUG, degreeList.str());
         }
-        std::cout << std::endl;
     }
     /**********************************/
 
     //copy all edges
     g.links.resize(g.nb_links);
-    g.links = input_graph.links;
+    thrust::copy(input_graph.linkData(), input_graph.linkData() + g.nb_links, g.links.begin());
 
     //copy all weights
-    g.weights.resize(input_graph.weights.size());
-    g.weights = input_graph.weights;
+    const float* linkWeights = input_graph.weightData();
+    g.weights.resize(linkWeights ? g.nb_links : 0);
+    if (linkWeights)
+        thrust::copy(linkWeights, linkWeights + g.nb_links, g.weights.begin());
 
-    std::cout << std::endl << "Copied  " << g.weights.size() << " weights" << std::endl;
+    LOG(LOG_DEBUG, "Copied  " << g.weights.size() << " weights");
 
     g.total_weight = input_graph.total_weight;
 
 
-    if (input_graph.weights.size() > 0) {
+    if (linkWeights) {
         g.type = WEIGHTED;
-        std::cout << " Setting type to WEIGHTED" << std::endl;
+        LOG(LOG_DEBUG, " Setting type to WEIGHTED");
     } else {
-        std::cout << "Type is already set to UNWEIGHTED" << std::endl;
+        LOG(LOG_DEBUG, "Type is already set to UNWEIGHTED");
     }
 
     //Community
     community_size = g.nb_nodes;
     min_modularity = min_mod;
 
-    std::cout << std::endl << "(Dev Graph) " << " #Nodes: " << g.nb_nodes << "  #Links: " << g.nb_links / 2 << "  Total_Weight: " << g.total_weight / 2 << std::endl;
-    std::cout << "community_size: " << community_size << std::endl;
+    keepDendrogram = false;
+    level = 0;
+    telemetry = NULL;
+
+    sampleFraction = 1.0;
+    sampleByDegree = false;
+    sampleSeed = 0;
+    sampleLevels = 1;
+    sampleBudget = 0.5;
+    clock_gettime(CLOCK_MONOTONIC, &runStart);
+
+    // tot sums at most the total weight; tables pick their own scale per phase
+    deterministic = false;
+    gravityScale = fixedPointScale(g.total_weight);
+
+    genericKernels = false;
+    registerKernels = true;
+    denseTableBudget = (size_t) DENSE_TABLE_BUDGET_MB << 20;
+    warmStartRounds = 0;
+    warmStartContract = false;
+    hostCutover = 0;
+    levelZero = NULL;
+    globalTotalWeight = 0;
+    miniBatches = 1;
+    nrSweeps = 0;
+    bucketCompare = false;
+
+    LOG(LOG_INFO, "(Dev Graph) " << " #Nodes: " << g.nb_nodes << "  #Links: " << g.nb_links / 2 << "  Total_Weight: " << g.total_weight / 2);
+    LOG(LOG_DEBUG, "community_size: " << community_size);
     // seriously !!
 }
+
+void Community::inheritSettings(const Community& parent) {
+
+    hostPrimes = parent.hostPrimes;
+    nb_prime = parent.nb_prime;
+    devPrimes = parent.devPrimes;
+
+    // A subgraph weighs at most the parent, so the parent's tot scale bounds
+    // it; the table scale is set by each phase of the solve itself
+    deterministic = parent.deterministic;
+    gravityScale = parent.gravityScale;
+    genericKernels = parent.genericKernels;
+    registerKernels = parent.registerKernels;
+    denseTableBudget = parent.denseTableBudget;
+    hostCutover = parent.hostCutover;
+    memory.budget = parent.memory.budget;
+    miniBatches = parent.miniBatches;
+}
+
+void Community::configureLike(const Community& timed) {
+
+    inheritSettings(timed);
+
+    levelZero = timed.levelZero;
+    warmStartRounds = timed.warmStartRounds;
+    warmStartContract = timed.warmStartContract;
+    deadline.limit = timed.deadline.limit;
+
+    sampleFraction = timed.sampleFraction;
+    sampleByDegree = timed.sampleByDegree;
+    sampleSeed = timed.sampleSeed;
+    sampleLevels = timed.sampleLevels;
+    sampleBudget = timed.sampleBudget;
+}
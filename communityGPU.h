@@ -27,6 +27,11 @@
 #include "cuda.h"
 #include"cuda_runtime_api.h"
 #include "graphHOST.h"
+#include"dendrogramHOST.h"
+#include"telemetryHOST.h"
+#include"logger.h"
+#include"memoryPlanner.h"
+#include"graphCache.h"
 
 #include"commonconstants.h"
 #include"hostconstants.h"
@@ -45,6 +50,76 @@
 #include"thrust/extrema.h"
 #include"thrust/fill.h"
 #include"string"
+#include"vector"
+#include"time.h"
+#include"algorithm"
+
+// Measured costs from which the level loop picks the engine of a level
+
+struct EngineCosts {
+    double deviceLevelTime; // seconds of the last device level
+    double deviceLevelFloor; // shortest device level so far
+    unsigned long deviceLevelLinks;
+    int deviceLevelSweeps;
+    double hostTimePerLink; // one host sweep, per link; < 0 until probed
+
+    EngineCosts() : deviceLevelTime(0), deviceLevelFloor(0), deviceLevelLinks(0),
+    deviceLevelSweeps(1), hostTimePerLink(-1) {
+    }
+};
+
+// Anytime mode: cost per link of the sweeps and contractions seen so far,
+// to predict whether the next sweep or level still ends before the deadline
+
+struct DeadlineCosts {
+    double limit; // seconds after the start of run(), 0: none
+    double sweepPerLink, sweepFloor; // last sweep; floor: shortest sweep so far
+    double contractPerLink, contractFloor;
+    bool hit; // a sweep or level was given up for the deadline
+
+    DeadlineCosts() : limit(0), sweepPerLink(-1), sweepFloor(0), contractPerLink(-1),
+    contractFloor(0), hit(false) {
+    }
+
+    void recordSweep(double seconds, unsigned long links) {
+        sweepFloor = (sweepPerLink < 0) ? seconds : std::min(sweepFloor, seconds);
+        sweepPerLink = seconds / std::max(links, 1UL);
+    }
+
+    void recordContraction(double seconds, unsigned long links) {
+        contractFloor = (contractPerLink < 0) ? seconds : std::min(contractFloor, seconds);
+        contractPerLink = seconds / std::max(links, 1UL);
+    }
+
+    // Sweep and contraction of a level with links links; a contraction not
+    // measured yet is taken as long as a sweep
+    double predictSweep(unsigned long links) const {
+        return std::max(sweepFloor, sweepPerLink * links);
+    }
+
+    double predictContraction(unsigned long links) const {
+        if (contractPerLink < 0)
+            return predictSweep(links);
+        return std::max(contractFloor, contractPerLink * links);
+    }
+
+    bool fits(double elapsed, double seconds) const {
+        return limit <= 0 || sweepPerLink < 0 || elapsed + DEADLINE_MARGIN * seconds <= limit;
+    }
+};
+
+// What the contraction already knows about the graph it builds, handed to
+// the move phase of that graph instead of being recomputed from its edges
+
+struct LevelBundle {
+    int level; // level of the graph described, -1: none
+    thrust::device_vector<float> wDegs; // weighted degree of each vertex
+    int binSizes[NR_BINS]; // vertices per degree bin
+    double totalWeight;
+
+    LevelBundle() : level(-1), totalWeight(0) {
+    }
+};
 
 struct Community {
     int community_size;
@@ -68,9 +143,100 @@ struct Community {
     GraphGPU g;
     GraphGPU g_next;
 
+    // If set, compute_next_graph() records node->supernode map of each level
+    bool keepDendrogram;
+    Dendrogram dendrogram;
+
+    int level; // current level, 0 for the input graph
+
+    Telemetry* telemetry; // NULL: nothing is recorded
+
+    // Sampled sweeps: in the first sampleLevels levels a sweep processes only
+    // a pseudo-random fraction (sampleFraction, uniform or degree-weighted) of
+    // each bin. The fraction doubles once the gain falls below sampleBudget
+    // times the previous gain; only a full sweep can end a level.
+    double sampleFraction;
+    bool sampleByDegree;
+    unsigned int sampleSeed;
+    int sampleLevels;
+    double sampleBudget;
+
+    // Deterministic mode: table gravities and tot are accumulated in 64-bit
+    // fixed point and new neighborhoods are sorted, so a given input and
+    // launch configuration always yields the same partition. tot uses
+    // gravityScale, chosen from the total weight of the input; the tables
+    // are rescaled per phase to their largest slot sum.
+    bool deterministic;
+    float gravityScale;
+
+    // Launch the generic move/contraction kernels instead of the instances
+    // specialized per bin (group width, table size, graph type)
+    bool genericKernels;
+
+    // Bins with at most 4 and 8 neighbors run the table-free kernels
+    bool registerKernels;
+
+    // Device memory (bytes) per level for the dense accumulators of the
+    // heaviest rows; one table of #communities slots per block, 0 disables
+    size_t denseTableBudget;
+
+    // Level 0 starts from at most warmStartRounds rounds of label
+    // propagation instead of singletons (0 disables); with warmStartContract
+    // the propagated partition is contracted without any sweep
+    int warmStartRounds;
+    bool warmStartContract;
+
+    // The first level with at most hostCutover links and all levels after
+    // it run on the sequential host engine (LouvainHOST); -1 decides per
+    // level from the measured costs, 0 keeps every level on the device
+    long hostCutover;
+
+    // Predicted and measured device memory of each phase, against a budget
+    MemoryPlanner memory;
+
+    // Bins and weighted degrees of the input graph from the graph cache,
+    // used by the first level; NULL computes them on the device
+    const LevelZeroData* levelZero;
+
+    // Weighted degrees of the current level (kept for the contraction) and,
+    // once contracted, the state of the next level
+    LevelBundle bundle;
+
+    // Total weight of the graph this one is a part of (e.g. a connected
+    // component); gains and modularity are taken relative to it. 0: own weight
+    double globalTotalWeight;
+
+    // Gauss-Seidel sweeps split every bin into this many mini-batches with a
+    // commit of n2c/tot after each; 0 picks the count of each bin per level
+    // from the conflicts and timings of the level's first sweep
+    int miniBatches;
+    int nrSweeps; // sweeps of the last run()
+
+    // Also run the former renumber/group chain next to bucketByKey and keep
+    // (chain ms, bucketByKey ms) of each level
+    bool bucketCompare;
+    std::vector<std::pair<float, float> > bucketTimes;
+
+    // (seconds since start of run(), modularity) after each accepted sweep
+    std::vector<std::pair<double, double> > modularityTrace;
+    struct timespec runStart;
+
+    // Anytime mode: sweeps and levels that would end after the deadline are
+    // skipped; run() then returns the partition reached so far
+    DeadlineCosts deadline;
+    double secondsSinceStart() const;
+
     //
     Community(const GraphHOST& input_graph, int nb_pass, double min_mod);
 
+    // Primes and kernel, table and memory settings of a solve on a part of
+    // parent's graph
+    void inheritSettings(const Community& parent);
+
+    // All settings of timed, a run on the same input graph: the comparison
+    // runs of main then differ from it only in what they measure
+    void configureLike(const Community& timed);
+
     double modularity(thrust::device_vector<float> &tot, thrust::device_vector<float> &in);
     double one_level(double init_mod, bool isLastRound);
     double one_levelGaussSeidel(double init_mod, bool isLastRound, int minSize,
@@ -87,6 +253,23 @@ struct Community {
     void gatherStatistics(bool isPreprocessingStep = false);
     void readPrimes(std::string filename);
     void preProcess();
+    double warmStart(thrust::device_vector<float>& wDegs, thrust::device_vector<float>& tot,
+            thrust::device_vector<int>& cardinalityOfComms);
+
+    // Connected component of each vertex of the current graph, labeled by
+    // its smallest vertex id
+    std::vector<int> componentLabels();
+
+    bool levelOnHost(EngineCosts& costs);
+    double hostTimePerLink();
+    double runOnHost(double threshold, int maxLevels);
+
+    // Optimize and contract level by level until the gain drops below threshold
+    // (or maxLevels); returns the final modularity
+    double run(double threshold, double binThreshold, int szSmallComm, bool isGauss,
+            int maxLevels, cudaStream_t *streams, int nrStreams, cudaEvent_t &start,
+            cudaEvent_t &stop, std::vector<clock_t> &clkList_decision,
+            std::vector<clock_t> &clkList_contration);
 
 };
 
@@ -268,6 +451,46 @@ struct Community_ID_By_Prefix_Sum : public thrust::binary_function< T, T, T> {
     }
 };
 
+// Deterministic choice of vertices for a sampled sweep, from a hash of
+// (seed, level, sweep, vertex)
+
+struct IsSampled {
+    unsigned int seed;
+    unsigned int level;
+    unsigned int sweep;
+    float fraction;
+    bool byDegree;
+    int* degrees;
+    float avgDegree;
+
+    IsSampled(unsigned int _seed, unsigned int _level, unsigned int _sweep, float _fraction,
+            bool _byDegree, int* _degrees, float _avgDegree) : seed(_seed), level(_level),
+    sweep(_sweep), fraction(_fraction), byDegree(_byDegree), degrees(_degrees), avgDegree(_avgDegree) {
+    }
+
+#ifdef RUNONGPU
+
+    __host__ __device__
+#endif
+    bool operator()(const int vertex) {
+
+        unsigned int h = seed ^ (level * 0x9E3779B9u) ^ (sweep * 0x85EBCA6Bu) ^ ((unsigned int) vertex * 0xC2B2AE35u);
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        h *= 0x846CA68Bu;
+        h ^= h >> 16;
+
+        float p = fraction;
+        if (byDegree)
+            p = fraction * degrees[vertex] / avgDegree;
+        if (p >= 1.0f)
+            return true;
+
+        return (h >> 8) < (unsigned int) (p * 16777216.0f);
+    }
+};
+
 template<typename In_type, typename Out_type>
 struct Is_Non_Negative {
 #ifdef RUNONGPU
@@ -282,15 +505,33 @@ struct Is_Non_Negative {
 
 template<class T1, class T2>
 void print_vector(const thrust::device_vector<T1, T2>& dateVector, std::string title, std::string prefix = "") {
-    //return;
-    std::cout << std::endl << title << std::endl;
-    std::cout << prefix << std::endl;
-    thrust::copy(dateVector.begin(), dateVector.end(), std::ostream_iterator<T1>(std::cout, " "));
-    std::cout << std::endl;
+    if (!LOG_ENABLED(LOG_TRACE))
+        return;
+    std::ostringstream values;
+    thrust::copy(dateVector.begin(), dateVector.end(), std::ostream_iterator<T1>(values, " "));
+    LOG(LOG_TRACE, title << "\n" << prefix << "\n" << values.str());
 
 }
 void report_time(cudaEvent_t start, cudaEvent_t stop, std::string moduleName);
 
+// Split communities of the final partition of dendrogram having more than
+// minCommSize vertices: each one is solved independently (nrJobs at a time)
+// on its induced subgraph. Returns the levels [vertex->refined community,
+// refined community->community of dendrogram]; main makes them the levels
+// of the run, so flatten(1) is the refined partition.
+Dendrogram reclusterLargeCommunities(const GraphHOST& input_graph,
+        const Dendrogram& dendrogram, const Community& parent, int minCommSize,
+        int nrJobs, double threshold, double binThreshold, int szSmallComm, bool isGauss);
+
+// Splits the graph into connected components: tiny cliques and trees
+// (at most tinySize vertices) are settled as one community each, the
+// others are packed into disjoint solves of up to batchSize vertices (a
+// larger component is a solve of its own) that run nrJobs at a time.
+// The dendrograms of the solves are merged level by level.
+Dendrogram clusterComponents(const GraphHOST& input_graph, Community& parent,
+        int tinySize, int batchSize, int nrJobs, double threshold, double binThreshold,
+        int szSmallComm, bool isGauss);
+
 #define CHECK(call)                                                            \
 {                                                                              \
     const cudaError_t error = call;                                            \
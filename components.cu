@@ -0,0 +1,243 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"algorithm"
+#include"thread"
+#include"atomic"
+#include"communityGPU.h"
+#include"hostconstants.h"
+#include"bucketingHOST.h"
+
+std::vector<int> Community::componentLabels() {
+
+    thrust::device_vector<int> label(g.nb_nodes);
+    thrust::sequence(label.begin(), label.end(), 0);
+    thrust::device_vector<int> changed(1, 1);
+
+    int nr_of_block = (g.nb_nodes + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+    int nrRounds = 0;
+
+    while (changed[0]) {
+        changed[0] = 0;
+        hookComponents << <nr_of_block, NR_THREAD_PER_BLOCK>>>(g.nb_nodes,
+                thrust::raw_pointer_cast(g.indices.data()),
+                thrust::raw_pointer_cast(g.links.data()),
+                thrust::raw_pointer_cast(label.data()),
+                thrust::raw_pointer_cast(changed.data()));
+        compressComponents << <nr_of_block, NR_THREAD_PER_BLOCK>>>(g.nb_nodes,
+                thrust::raw_pointer_cast(label.data()));
+        nrRounds++;
+    }
+
+    LOG(LOG_DEBUG, "Connected components after " << nrRounds << " hooking rounds");
+
+    std::vector<int> hostLabel(g.nb_nodes);
+    thrust::copy(label.begin(), label.end(), hostLabel.begin());
+    return hostLabel;
+}
+
+// Nodes of level l of a solve; levels past its last one repeat its final
+// communities
+static int nodesAtLevel(const Dendrogram& d, int l) {
+
+    if (l < d.nrLevels())
+        return d.levels[l].size();
+    const std::vector<int>& last = d.levels[d.nrLevels() - 1];
+    return last.size() ? *std::max_element(last.begin(), last.end()) + 1 : 0;
+}
+
+Dendrogram clusterComponents(const GraphHOST& input_graph, Community& parent,
+        int tinySize, int batchSize, int nrJobs, double threshold, double binThreshold,
+        int szSmallComm, bool isGauss) {
+
+    unsigned int nbNodes = input_graph.nb_nodes;
+    std::vector<int> label = parent.componentLabels();
+
+    // Component ids in order of their smallest vertex
+    std::vector<int> compOf(nbNodes);
+    int nrComps = 0;
+    for (unsigned int v = 0; v < nbNodes; v++)
+        compOf[v] = (label[v] == (int) v) ? nrComps++ : compOf[label[v]];
+
+    std::vector<int> compSize(nrComps, 0);
+    std::vector<unsigned long> compLinks(nrComps, 0);
+    const unsigned long* cumDegree = input_graph.degreeData();
+    const unsigned int* adjacent = input_graph.linkData();
+    for (unsigned int v = 0; v < nbNodes; v++) {
+        compSize[compOf[v]]++;
+        unsigned long first = v ? cumDegree[v - 1] : 0;
+        for (unsigned long e = first; e < cumDegree[v]; e++) {
+            if (adjacent[e] != v)
+                compLinks[compOf[v]]++;
+        }
+    }
+
+    // Settled: a clique or a tree is best kept whole as long as its volume
+    // is small next to the graph
+    std::vector<int> settledId(nrComps, -1);
+    int nrSettled = 0;
+    for (int c = 0; c < nrComps; c++) {
+        unsigned long k = compSize[c];
+        bool clique = (compLinks[c] == k * (k - 1));
+        bool tree = (compLinks[c] == 2 * (k - 1));
+        if ((int) k <= tinySize && (clique || tree))
+            settledId[c] = nrSettled++;
+    }
+
+    // Largest first: the giant component starts early and medium ones are
+    // packed into the following solves
+    std::vector<int> order;
+    for (int c = 0; c < nrComps; c++) {
+        if (settledId[c] < 0)
+            order.push_back(c);
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return compSize[a] > compSize[b];
+    });
+
+    std::vector<int> batchOfComp(nrComps, -1);
+    std::vector<int> batchSizes;
+    for (unsigned int k = 0; k < order.size(); k++) {
+        int c = order[k];
+        if (!batchSizes.size() || batchSizes.back() + compSize[c] > batchSize)
+            batchSizes.push_back(0);
+        batchOfComp[c] = batchSizes.size() - 1;
+        batchSizes.back() += compSize[c];
+    }
+    int nrBatches = batchSizes.size();
+
+    LOG(LOG_INFO, "#Components: " << nrComps << " (largest " << (order.size() ? compSize[order[0]] : 1)
+            << " vertices) settled: " << nrSettled << " #solves: " << nrBatches);
+
+    // Block 0 holds the settled vertices, block b+1 the vertices of batch b;
+    // members of block b are members[blockPtr[b]..blockPtr[b+1])
+    int nrBlocks = nrBatches + 1;
+    std::vector<int> blockOf(nbNodes);
+    for (unsigned int v = 0; v < nbNodes; v++)
+        blockOf[v] = batchOfComp[compOf[v]] + 1;
+
+    std::vector<int> blockPtr, members, unusedMap;
+    bucketByKeyHOST(blockOf.data(), nbNodes, nrBlocks, false, std::thread::hardware_concurrency(),
+            unusedMap, blockPtr, members);
+
+    std::vector<int> localId(nbNodes);
+    for (int b = 0; b < nrBlocks; b++)
+        for (int i = blockPtr[b]; i < blockPtr[b + 1]; i++)
+            localId[members[i]] = i - blockPtr[b];
+
+    std::vector<Dendrogram> solved(nrBlocks);
+
+    std::vector<int> settledLevel(blockPtr[1]);
+    for (int i = 0; i < blockPtr[1]; i++)
+        settledLevel[i] = settledId[compOf[members[i]]];
+    solved[0].addLevel(settledLevel);
+
+    std::atomic<int> nextJob(0);
+    nrJobs = std::max(1, std::min(nrJobs, nrBatches));
+    // The table scale of deterministic mode is one device symbol, set by each
+    // phase; concurrent solves would overwrite each other's
+    if (parent.deterministic)
+        nrJobs = 1;
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < nrJobs; w++) {
+        workers.push_back(std::thread([&]() {
+
+            // with --default-stream per-thread each worker has its own stream
+            cudaEvent_t start, stop;
+            cudaEventCreate(&start);
+            cudaEventCreate(&stop);
+
+            int k;
+            while ((k = nextJob++) < nrBatches) {
+
+                int b = k + 1;
+                int nrMembers = blockPtr[b + 1] - blockPtr[b];
+
+                GraphHOST subGraph;
+                input_graph.inducedSubgraph(&members[blockPtr[b]], nrMembers, blockOf, localId, subGraph);
+
+                if (subGraph.nb_links) {
+                    Community subCommunity(subGraph, -1, threshold);
+                    subCommunity.inheritSettings(parent);
+                    subCommunity.keepDendrogram = true;
+                    subCommunity.globalTotalWeight = input_graph.total_weight;
+
+                    std::vector<clock_t> clkList_decision, clkList_contration;
+                    subCommunity.run(threshold, binThreshold, szSmallComm, isGauss, 33, NULL, 0,
+                            start, stop, clkList_decision, clkList_contration);
+
+                    solved[b] = subCommunity.dendrogram;
+                }
+
+                // no level improved: every vertex stays on its own
+                if (!solved[b].nrLevels()) {
+                    std::vector<int> identity(nrMembers);
+                    for (int i = 0; i < nrMembers; i++)
+                        identity[i] = i;
+                    solved[b].addLevel(identity);
+                }
+            }
+
+            cudaEventDestroy(start);
+            cudaEventDestroy(stop);
+        }));
+    }
+    for (unsigned int w = 0; w < workers.size(); w++)
+        workers[w].join();
+
+    // Merge: node i of level l of block b becomes node offset[b] + i of the
+    // merged level l; blocks with fewer levels keep their final communities
+    int nrLevels = 0;
+    for (int b = 0; b < nrBlocks; b++)
+        nrLevels = std::max(nrLevels, solved[b].nrLevels());
+
+    Dendrogram merged;
+    std::vector<int> offset(nrBlocks + 1, 0), nextOffset(nrBlocks + 1, 0);
+
+    for (int l = 0; l < nrLevels; l++) {
+
+        for (int b = 0; b < nrBlocks; b++) {
+            offset[b + 1] = offset[b] + nodesAtLevel(solved[b], l);
+            nextOffset[b + 1] = nextOffset[b] + nodesAtLevel(solved[b], l + 1);
+        }
+
+        std::vector<int> level(offset[nrBlocks]);
+        for (int b = 0; b < nrBlocks; b++) {
+            for (int i = 0; i < offset[b + 1] - offset[b]; i++) {
+                int to = (l < solved[b].nrLevels()) ? solved[b].levels[l][i] : i;
+                level[offset[b] + i] = nextOffset[b] + to;
+            }
+        }
+
+        // level 0 is indexed by input vertex
+        if (!l) {
+            std::vector<int> byVertex(nbNodes);
+            for (unsigned int v = 0; v < nbNodes; v++)
+                byVertex[v] = level[blockPtr[blockOf[v]] + localId[v]];
+            level.swap(byVertex);
+        }
+        merged.addLevel(level);
+    }
+
+    return merged;
+}
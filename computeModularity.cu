@@ -51,7 +51,7 @@ double Community::modularity(thrust::device_vector<float>& tot, thrust::device_v
     float q = 0.;
     float m2 = (float) g.total_weight;
 
-    std::cout << "m2: " << m2 << std::endl;
+    LOG(LOG_TRACE, "m2: " << m2);
 
     /*
     thrust::host_vector<float> in_ = in;
@@ -79,24 +79,12 @@ double Community::modularity(thrust::device_vector<float>& tot, thrust::device_v
     return q;
      */
 
-    bool hostPrint = false;
+    print_vector(tot, " Inside  modularity() ", "tot: ");
+    print_vector(in, " Inside  modularity() ", "in: ");
 
-    if (hostPrint) {
-        std::cout << std::endl << " Inside  modularity() " << std::endl;
-
-        thrust::copy(tot.begin(), tot.end(), std::ostream_iterator<float>(std::cout, " "));
-        std::cout << std::endl;
-
-        thrust::copy(in.begin(), in.end(), std::ostream_iterator<float>(std::cout, " "));
-        std::cout << std::endl;
-    }
-
-    int sc;
     //std::cout << community_size << " |in|:" << in.size() << " |tot|:" << tot.size() << std::endl;
 
-    sc = 0; //std::cin>>sc;
     thrust::device_vector<double> result_array(community_size, 0.0);
-    sc = 0; //std::cin>>sc;
 
     thrust::transform(thrust::device, in.begin(), in.end(), tot.begin(), result_array.begin(), my_modularity_functor_2(m2));
 
@@ -25,13 +25,13 @@
 #include "communityGPU.h"
 
 void report_time(cudaEvent_t start, cudaEvent_t stop, std::string moduleName) {
-    /*
+
+    // Waits for the kernel; only done when kernel timings are shown
+    if (!LOG_ENABLED(LOG_TRACE))
+        return;
     cudaEventRecord(stop, 0);
     cudaEventSynchronize(stop);
     float milliseconds = 0;
     cudaEventElapsedTime(&milliseconds, start, stop);
-    //if(moduleName.compare("FilterCopy&M"))
-    std::cout << moduleName << " (kernel):  " << milliseconds << std::endl;
-    */
+    LOG(LOG_TRACE, moduleName << " (kernel):  " << milliseconds);
 }
-
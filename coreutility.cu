@@ -32,17 +32,17 @@
 //#define WID (1<<29)
 //#define EID (1<<29)
 //#define DUMP 0
+template<typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-void initByBlock(HashItem* shashTable, unsigned int bucketSize,
+void initByBlock(ITEM* shashTable, unsigned int bucketSize,
         unsigned int workerId, unsigned int stride) {
 
     __syncthreads();
     for (unsigned int i = workerId; i < bucketSize; i = i + stride) {
         shashTable[i].cId = FLAG_FREE;
-        shashTable[i].gravity = 0.0;
+        tableClearGravity(shashTable[i]);
     }
     __syncthreads();
 }
@@ -252,11 +252,14 @@ float comWDegOfNodeByBlock(int workerId, int nr_neighors, float* weightsOfLinks,
     }
 
 }
+template<unsigned int GROUP_SIZE, int GRAPH_TYPE>
 #ifdef RUNONGPU
-
 __device__
 #endif
-float comWDegOfNode(int laneId, int nr_neighors, float* weights_of_links_to_neighbors, int type, unsigned int WARP_SIZE) {
+float comWDegOfNode(int laneId, int nr_neighors, float* weights_of_links_to_neighbors, int graphType, unsigned int wrpSz) {
+
+    const unsigned int WARP_SIZE = GROUP_SIZE ? GROUP_SIZE : wrpSz;
+    const int type = (GRAPH_TYPE == ANY_GRAPH) ? graphType : GRAPH_TYPE;
 
     if (type == UNWEIGHTED) {
         return (float) nr_neighors;
@@ -300,7 +303,7 @@ void preComputeWdegs(int *indices, float* weights, float *wDegs, int type, unsig
         float wdeg = endNbr - startNbr;
 
         if (type == WEIGHTED) {
-            wdeg = comWDegOfNode(laneId, (endNbr - startNbr), &weights[startNbr], type, WARP_SIZE);
+            wdeg = comWDegOfNode<0, WEIGHTED>(laneId, (endNbr - startNbr), &weights[startNbr], type, WARP_SIZE);
         }
 
         wDegs[wid] = wdeg;
@@ -314,122 +317,6 @@ void preComputeWdegs(int *indices, float* weights, float *wDegs, int type, unsig
 
 #ifdef RUNONGPU
 
-__device__
-#endif
-int hashInsertGPU(HashItem* Table, unsigned int* totNrAttempt,
-        unsigned int bucketSize, HashItem *dataItem, float* tot, float wDegNode,
-        float m2, float* bestGain, int *bestDest, int sCId) {
-
-    //unsigned int wid = threadIdx.x / WARP_SIZE;
-    //unsigned int laneId = threadIdx.x % WARP_SIZE; // id in the warp
-    float addedValue = 0.0, prevValue = 0.0;
-    unsigned int i = 0, j = 0;
-
-    unsigned int h1 = H1GPU(dataItem->cId, bucketSize); // h1
-
-
-    unsigned int h2 = H2GPU(dataItem->cId, bucketSize);
-    do {
-
-        j = (h1 + i * h2) % bucketSize;
-
-        int currCId = atomicCAS((int*) &Table[j].cId, FLAG_FREE, (1 + dataItem->cId)); //NOTE: HashTable stores (cid+1)
-
-        // the winner might be sleeping  while the losers might run and succeed else if () test !!!!!!!!!
-
-        if (currCId == FLAG_FREE) { // new cId @ location j;  exactly ONE winner
-
-            addedValue = dataItem->gravity;
-
-            prevValue = atomicAdd((float*) &Table[j].gravity, addedValue);
-
-            //if (prevValue > 0.0)printf("\nUnexpected value in HashTable\n");
-
-            prevValue = prevValue + addedValue;
-
-            //float gain = (prevValue * m2 - tot[dataItem->cId] * wDegNode);
-
-            double dgain = 0.0;
-            if (dataItem->cId != sCId)
-                //dgain =  2.0 *  prevValue - 2.0 *  wDegNode * (tot[dataItem->cId] -  tot[sCId] +  wDegNode)*  (1.0 / (double) m2);
-                dgain = (double) (2.0 * (double) prevValue - 2.0 * (double) wDegNode * ((double) tot[dataItem->cId] - (double) tot[sCId] + (double) wDegNode)* (1.0 / (double) m2));
-
-            float gain = (float) dgain;
-
-            //if(dataItem->cId == 97)
-            //printf("\npcId= %d gpc= %f tot[pc]= %f wDeg= %f sCId= %d tot[sCId]= %f m2= %f gain= %f\n",dataItem->cId, prevValue, tot[dataItem->cId], wDegNode, sCId, tot[sCId], m2, gain);
-
-            if ((gain > *bestGain) || (gain == *bestGain && gain != 0 && dataItem->cId < *bestDest)) {
-
-                *bestGain = gain;
-                *bestDest = dataItem->cId;
-            }
-
-            //*totNrAttempt = *totNrAttempt + (i + 1);
-            return (int) i;
-
-        } else if (currCId == (1 + dataItem->cId)) { //existing cId; what if multiple losers came with same currCId !!!!!!!!!!!!!!!
-
-            addedValue = dataItem->gravity;
-
-            prevValue = atomicAdd((float*) &Table[j].gravity, addedValue); //Table[j].gravity += dataItem->gravity;
-
-            prevValue = prevValue + addedValue;
-
-            //float gain = (prevValue * m2 - tot[dataItem->cId] * wDegNode);
-
-            // double  dgain= (double)(2.0* (double)prevValue  - 2.0*(double)tot[dataItem->cId] * (double)wDegNode * (double)(1.0/(double)m2));
-            double dgain = 0.0;
-            if (dataItem->cId != sCId)
-                dgain = (double) (2.0 * (double) prevValue - 2.0 * (double) wDegNode * ((double) tot[dataItem->cId] - (double) tot[sCId] + (double) wDegNode)* (double) (1.0 / (double) m2));
-
-            float gain = (float) dgain;
-
-            //if(dataItem->cId == 97)
-            //printf("\npcId= %d gpc= %f tot[pc]= %f wDeg= %f sCId= %d tot[sCId]= %f m2= %f\n",dataItem->cId, prevValue, tot[dataItem->cId], wDegNode, sCId, tot[sCId], m2);
-
-            if ((gain > *bestGain) || (gain == *bestGain && gain != 0 && dataItem->cId < *bestDest)) {
-
-                *bestGain = gain;
-                *bestDest = dataItem->cId;
-            }
-            //*totNrAttempt = *totNrAttempt + (i + 1);
-            return (int) i;
-
-        } else {
-            i = i + 1;
-        }
-
-    } while (i < bucketSize);
-    return -1;
-}
-
-#ifdef RUNONGPU
-
-__device__
-#endif
-int hashSearchGPU(HashItem* Table, unsigned int* totNrAttempt, unsigned int bucketSize, HashItem *dataItem) {
-
-    unsigned int i = 0, j = 0;
-
-    unsigned int h1 = H1GPU(dataItem->cId, bucketSize); // h1
-    unsigned int h2 = H2GPU(dataItem->cId, bucketSize);
-
-    do {
-
-        j = (h1 + i * h2) % bucketSize;
-
-        if (Table[j].cId == (1 + dataItem->cId)) {
-            *totNrAttempt = *totNrAttempt + (i + 1);
-            return (int) j; // returning the index where the  key is found
-        } else {
-            i = i + 1;
-        }
-    } while (i < bucketSize && Table[j].cId != FLAG_FREE);
-    return -1;
-}
-#ifdef RUNONGPU
-
 __device__
 #endif
 int hashSearchModified(HashItem* Table, unsigned int* totNrAttempt, unsigned int bucketSize, HashItem *dataItem) {
@@ -587,16 +474,43 @@ HashItem findTheBest(int bestDestination, float bestGain, unsigned int WARP_SIZE
     }
     return toReturn;
 }
-#ifdef RUNONGPU
+#ifdef HASH_PROBE_STATS
+
+template<typename ITEM>
+__device__
+int countOccupied(ITEM* table, unsigned int bucketSize, int workerId, int nrWorker) {
 
+    int nrOccupied = 0;
+    for (unsigned int i = workerId; i < bucketSize; i = i + nrWorker)
+        nrOccupied += (table[i].cId != FLAG_FREE);
+    return nrOccupied;
+}
+#endif
+
+// Weight of the j-th link of a neighborhood; weights is NULL for unweighted
+// graphs. The test disappears when the graph type is a template argument.
+template<int GRAPH_TYPE>
+#ifdef RUNONGPU
 __device__
 #endif
+inline float linkWeight(const float* weights, int j) {
 
+    if (GRAPH_TYPE == UNWEIGHTED)
+        return 1.0;
+    if (GRAPH_TYPE == WEIGHTED)
+        return weights[j];
+    return (weights == NULL) ? 1.0 : weights[j];
+}
+
+template<int GRAPH_TYPE, typename ITEM>
+#ifdef RUNONGPU
+__device__
+#endif
 void decideBestDest(int node, int workerId, int nr_neighbor,
         unsigned int* neighbors, float* weightsToNeighbors, int *n2c,
         float *in, float* tot, float wDegOfNode,
         float total_weight, int *nr_moves, float* tot_new, int* n2c_new,
-        HashItem* shashTable, unsigned int bucketSize, int nrWorker,
+        ITEM* shashTable, unsigned int bucketSize, int nrWorker,
         unsigned int wrpSz, int* cardinalityOfComms_old,
         int* cardinalityOfComms_new) {
 
@@ -619,7 +533,7 @@ void decideBestDest(int node, int workerId, int nr_neighbor,
         if (j < nr_neighbor) {
 
             dataItem.cId = n2c[neighbors[j]];
-            dataItem.gravity = (weightsToNeighbors == NULL) ? 1.0 : weightsToNeighbors[j];
+            dataItem.gravity = linkWeight<GRAPH_TYPE>(weightsToNeighbors, j);
 
             flagInsert = (node != (int) neighbors[j]); // NOTE: Ignore self-loop to "node"
             selfLoop += (!flagInsert)*(dataItem.gravity);
@@ -651,14 +565,18 @@ void decideBestDest(int node, int workerId, int nr_neighbor,
 
     selfLoop = blockReduceFloat(selfLoop, wrpSz);
 
+#ifdef HASH_PROBE_STATS
+    int nrOccupied = blockReduce(countOccupied(shashTable, bucketSize, workerId, nrWorker), wrpSz);
+    if (!workerId) HASH_STAT_LOAD(bucketSize, nrOccupied);
+#endif
+
     HashItem sourceItem;
     sourceItem.cId = n2c[node];
     flagInsert = hashSearchGPU(shashTable, &nrAttempts, bucketSize, &sourceItem);
     if (flagInsert >= 0) {
 
-        sourceItem = shashTable[flagInsert];
-
-        sourceItem.cId = sourceItem.cId - 1; //NOTE: inserted as (sourceItem.cId+1)--------------------<<
+        sourceItem.cId = shashTable[flagInsert].cId - 1; //NOTE: inserted as (sourceItem.cId+1)--------------------<<
+        sourceItem.gravity = tableGravity(shashTable[flagInsert]);
 
         bestGain = bestGain - 2.0 * sourceItem.gravity + 2.0 * selfLoop;
 
@@ -711,21 +629,20 @@ void decideBestDest(int node, int workerId, int nr_neighbor,
         }
     }
 }
+template<unsigned int GROUP_SIZE, unsigned int TABLE_SIZE, int GRAPH_TYPE, typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-
 void compute_neighboring_communites_using_Hash(int node, int laneId,
         int nr_neighbor, unsigned int* neighbors, float* weightsToNbors,
         int *n2c, float *in, float* tot, float weighted_degree_of_node,
         float total_weight, int *nr_moves, float* tot_new, int* n2c_new,
-        HashItem* shashTable, unsigned int bucketSize,
+        ITEM* shashTable, unsigned int tableSize,
         int* cardinalityOfComms_old, int* cardinalityOfComms_new,
-        unsigned int WARP_SIZE) {
-
-
+        unsigned int wrpSz) {
 
+    const unsigned int WARP_SIZE = GROUP_SIZE ? GROUP_SIZE : wrpSz;
+    const unsigned int bucketSize = TABLE_SIZE ? TABLE_SIZE : tableSize;
 
     HashItem dataItem;
     unsigned int nrAttempts = 0;
@@ -746,7 +663,7 @@ void compute_neighboring_communites_using_Hash(int node, int laneId,
         if (j < nr_neighbor) {
 
             dataItem.cId = n2c[neighbors[j]];
-            dataItem.gravity = (weightsToNbors == NULL) ? 1.0 : weightsToNbors[j];
+            dataItem.gravity = linkWeight<GRAPH_TYPE>(weightsToNbors, j);
 
             flagInsert = (node != (int) neighbors[j]); // NOTE: Ignore self-loop to "node"
             selfLoop += (!flagInsert) * dataItem.gravity;
@@ -783,9 +700,8 @@ void compute_neighboring_communites_using_Hash(int node, int laneId,
     flagInsert = hashSearchGPU(shashTable, &nrAttempts, bucketSize, &sourceItem);
     if (flagInsert >= 0) {
 
-        sourceItem = shashTable[flagInsert];
-
-        sourceItem.cId = sourceItem.cId - 1; //NOTE: inserted as (sourceItem.cId+1)--------------------<<
+        sourceItem.cId = shashTable[flagInsert].cId - 1; //NOTE: inserted as (sourceItem.cId+1)--------------------<<
+        sourceItem.gravity = tableGravity(shashTable[flagInsert]);
 
         //if (DUMP && node == 8)printf("\n sourceItem.cId= %d, sourceItem.gravity =%f \n", sourceItem.cId, sourceItem.gravity);
         // ---> bestGain  = bestGain -  2.0 * sourceItem.gravity; 
@@ -794,6 +710,13 @@ void compute_neighboring_communites_using_Hash(int node, int laneId,
         printf("\nEveryone must find sourceItem.cId\n");
     }
 
+#ifdef HASH_PROBE_STATS
+    int nrOccupied = countOccupied(shashTable, bucketSize, laneId, WARP_SIZE);
+    for (int i = WARP_SIZE / 2; i >= 1; i = i / 2)
+        nrOccupied += __shfl_xor(nrOccupied, i, WARP_SIZE);
+    if (!laneId) HASH_STAT_LOAD(bucketSize, nrOccupied);
+#endif
+
 
     if (!laneId)atomicAdd(&in[node], sourceItem.gravity); // Only one thread should do it
 
@@ -858,11 +781,9 @@ void compute_neighboring_communites_using_Hash(int node, int laneId,
 
         if (flagInsert >= 0) {
 
-            dataItem = shashTable[flagInsert];
-
-            dataItem.cId = dataItem.cId - 1; //NOTE: inserted as (dataItem.cId+1)--------------------<<
+            dataItem.cId = shashTable[flagInsert].cId - 1; //NOTE: inserted as (dataItem.cId+1)--------------------<<
 
-            float gain = dataItem.gravity; //- (tot[dataItem.cId] * weighted_degree_of_node) / total_weight;
+            float gain = tableGravity(shashTable[flagInsert]); //- (tot[dataItem.cId] * weighted_degree_of_node) / total_weight;
 
             //if (node == 18459128)printf("\nSearch: laneId= %d,dataItem.cId= %d gravity=%f gain= %f \n", laneId, dataItem.cId, dataItem.gravity, gain);
 
@@ -938,35 +859,40 @@ void compute_neighboring_communites_using_Hash(int node, int laneId,
 
     for (int j = laneId; j < bucketSize; j = j + WARP_SIZE) {
         shashTable[j].cId = 0;
-        shashTable[j].gravity = 0.0;
+        tableClearGravity(shashTable[j]);
     }
 }
 
+template<unsigned int GROUP_SIZE, unsigned int TABLE_SIZE, int GRAPH_TYPE, typename ITEM>
 #ifdef RUNONGPU
-
 __global__
 #endif
-
 void neigh_comm(int community_size, int* indices, unsigned int* links,
-        float* weights, int *n2c, float *in, float* tot, int type, int *n2c_new,
+        float* weights, int *n2c, float *in, float* tot, int graphType, int *n2c_new,
         float* tot_new, int* movement_record, double total_weight,
-        unsigned int bucketSzLimit, int* candidateComms, int nrCandidate,
+        unsigned int tableSize, int* candidateComms, int nrCandidate,
         int* primes, int nrPrime, int* cardinalityOfComms_old,
-        int* cardinalityOfComms_new, unsigned int WARP_SIZE, float *wDegs) {
+        int* cardinalityOfComms_new, unsigned int wrpSz, float *wDegs) {
 
+    // Lane ids, loop strides and the table modulo are compile-time constants
+    // unless this is the generic (0, 0, ANY_GRAPH) instance
+    const unsigned int WARP_SIZE = GROUP_SIZE ? GROUP_SIZE : wrpSz;
+    const unsigned int bucketSzLimit = TABLE_SIZE ? TABLE_SIZE : tableSize;
+    const int type = (GRAPH_TYPE == ANY_GRAPH) ? graphType : GRAPH_TYPE;
 
     unsigned int wid = threadIdx.x / WARP_SIZE;
     unsigned int laneId = threadIdx.x % WARP_SIZE; // id in the warp
 
 
-    extern __shared__ HashItem __sMem[];
-    HashItem* shashTable = __sMem + wid * bucketSzLimit; // NOTE: bucketSize == size of Table in "Warp Memory"
+    // one extern array for all item types; long long keeps the alignment
+    extern __shared__ long long __sMem[];
+    ITEM* shashTable = (ITEM*) __sMem + wid * bucketSzLimit; // NOTE: bucketSize == size of Table in "Warp Memory"
 
     // Warp based initialization
 
     for (unsigned int i = laneId; i < bucketSzLimit; i = i + WARP_SIZE) {
         shashTable[i].cId = 0;
-        shashTable[i].gravity = 0.0;
+        tableClearGravity(shashTable[i]);
     }
 
 
@@ -1020,7 +946,7 @@ void neigh_comm(int community_size, int* indices, unsigned int* links,
         if(wDegs[node] != wdegNode)
                 if(!laneId) printf("\n wDegs PROBLEM neigh_comm\n");
          */
-        compute_neighboring_communites_using_Hash(node, laneId, nr_neighbor,
+        compute_neighboring_communites_using_Hash<GROUP_SIZE, TABLE_SIZE, GRAPH_TYPE>(node, laneId, nr_neighbor,
                 &links[startOfNhood], weightsMem, n2c, in, tot, wdegNode,
                 total_weight, &nr_moves, tot_new, n2c_new, shashTable,
                 activeBktSz, cardinalityOfComms_old, cardinalityOfComms_new,
@@ -1029,31 +955,179 @@ void neigh_comm(int community_size, int* indices, unsigned int* links,
 
         cId = cId + (blockDim.x * gridDim.x) / WARP_SIZE;
     }
-    /*
-    if (!laneId)
+    // movement_record is NULL unless moves are counted (telemetry)
+    if (movement_record && !laneId && wid < nrCandidate)
         movement_record[wid] = nr_moves;
-
+    /*
     if (!laneId && !wid)
         printf("\nReturning From Kernel\n");
      */
 
 }
 
+// Bins of at most GROUP_SIZE (4 or 8) neighbors: lane j of a group keeps the
+// community and the weight of neighbor j in registers and duplicates are
+// combined by an all-pairs compare over the group, so no table is cleared,
+// probed or updated atomically. Same decision rule as the hash path.
+template<unsigned int GROUP_SIZE, int GRAPH_TYPE>
 #ifdef RUNONGPU
+__global__
+#endif
+void neighCommInRegisters(int community_size, int* indices, unsigned int* links,
+        float* weights, int *n2c, float *in, float* tot, int graphType, int *n2c_new,
+        float* tot_new, int* movement_record, double total_weight,
+        unsigned int tableSize, int* candidateComms, int nrCandidate,
+        int* primes, int nrPrime, int* cardinalityOfComms_old,
+        int* cardinalityOfComms_new, unsigned int wrpSz, float *wDegs) {
+
+    unsigned int wid = threadIdx.x / GROUP_SIZE;
+    unsigned int laneId = threadIdx.x % GROUP_SIZE;
+
+    // Global group ID
+    wid = blockIdx.x * (blockDim.x / GROUP_SIZE) + wid;
+
+    float m2 = total_weight;
+    int nr_moves = 0;
+
+    for (unsigned int cId = wid; cId < nrCandidate; cId = cId + (blockDim.x * gridDim.x) / GROUP_SIZE) {
+
+        int node = candidateComms[cId];
+
+        int startOfNhood = indices[node];
+        int nr_neighbor = indices[node + 1] - startOfNhood;
+
+        float *weightsMem = NULL;
+        if (GRAPH_TYPE == WEIGHTED) {
+            weightsMem = &weights[startOfNhood];
+        }
+
+        int sCId = n2c[node];
+        float wDegNode = wDegs[node];
+
+        // lanes beyond the neighborhood hold no community
+        int myComm = -1;
+        float myWeight = 0.0, selfLoop = 0.0;
+
+        if (laneId < nr_neighbor) {
+            unsigned int neighbor = links[startOfNhood + laneId];
+            myComm = n2c[neighbor];
+            myWeight = linkWeight<GRAPH_TYPE>(weightsMem, laneId);
+            if ((int) neighbor == node)
+                selfLoop = myWeight;
+        }
+
+        // gravity towards my community and towards the source community
+        float gravity = 0.0, toSource = 0.0;
+
+#pragma unroll
+        for (unsigned int k = 0; k < GROUP_SIZE; k++) {
+            int comm = __shfl(myComm, k, GROUP_SIZE);
+            float w = __shfl(myWeight, k, GROUP_SIZE);
+            gravity += (comm == myComm) ? w : 0.0;
+            toSource += (comm == sCId) ? w : 0.0;
+        }
+
+#pragma unroll
+        for (int i = GROUP_SIZE / 2; i >= 1; i = i / 2)
+            selfLoop += __shfl_xor(selfLoop, i, GROUP_SIZE);
+
+        float bestGain = 0.0;
+        int bestDestination = -1;
+
+        if (myComm >= 0 && myComm != sCId) {
+
+            float gain = (float) (2.0 * (double) gravity - 2.0 * (double) wDegNode * ((double) tot[myComm] - (double) tot[sCId] + (double) wDegNode)* (1.0 / (double) m2));
+
+            if (gain > bestGain) {
+                bestGain = gain;
+                bestDestination = myComm;
+            }
+        }
 
+#pragma unroll
+        for (int i = GROUP_SIZE / 2; i >= 1; i = i / 2) {
+
+            float recvGain = __shfl_xor(bestGain, i, GROUP_SIZE);
+            int recvDest = __shfl_xor(bestDestination, i, GROUP_SIZE);
+
+            if ((recvGain > bestGain) || (recvGain == bestGain && recvDest < bestDestination)) {
+                bestGain = recvGain;
+                bestDestination = recvDest;
+            }
+        }
+
+        bestGain = bestGain - 2.0 * toSource + 2.0 * selfLoop;
+
+        if (!laneId) {
+
+            atomicAdd(&in[node], toSource);
+
+            if (bestDestination >= 0 && bestDestination != sCId && bestGain > 0) {
+
+                if (!(cardinalityOfComms_old[sCId] == 1 && cardinalityOfComms_old[bestDestination] == 1 && bestDestination > sCId)) {
+
+                    nr_moves++;
+
+                    atomicAdd(&tot_new[sCId], (-1) * wDegNode);
+                    atomicAdd(&cardinalityOfComms_new[sCId], -1);
+                    atomicAdd(&tot_new[bestDestination], wDegNode);
+                    atomicAdd(&cardinalityOfComms_new[bestDestination], 1);
+
+                    n2c_new[node] = bestDestination;
+                }
+            } else {
+                n2c_new[node] = sCId;
+            }
+        }
+    }
+
+    // movement_record is NULL unless moves are counted (telemetry)
+    if (movement_record && !laneId && wid < nrCandidate)
+        movement_record[wid] = nr_moves;
+}
+
+// A dense table has one slot per community (bucketSize = #communities), so
+// H1GPU places every key at its own id and the first probe always hits.
+// Instead of clearing the whole table before each row, only the slots of
+// the communities seen in the neighborhood are freed afterwards.
+template<typename ITEM>
+#ifdef RUNONGPU
+__device__
+#endif
+void clearTouchedByBlock(ITEM* denseTable, unsigned int* neighbors,
+        int szNhood, int* n2c, int* renumber, unsigned int workerId, int stride) {
+
+    for (unsigned int i = workerId; i < szNhood; i = i + stride) {
+        int c = n2c[neighbors[i]];
+        if (renumber)
+            c = renumber[c];
+        denseTable[c].cId = FLAG_FREE;
+        tableClearGravity(denseTable[c]);
+    }
+}
+
+template<int GRAPH_TYPE, typename ITEM>
+#ifdef RUNONGPU
 __global__
 #endif
 void lookAtNeigboringComms(int* indices, unsigned int* links, float* weights,
-        int *n2c, float *in, float* tot, int type, int *n2c_new, float *in_new,
+        int *n2c, float *in, float* tot, int graphType, int *n2c_new, float *in_new,
         float* tot_new, int* movement_record, double total_weight,
-        int* candidateComms, int nrCandidateComms, HashItem* gblTable,
+        int* candidateComms, int nrCandidateComms, void* gblTableMem,
         int* glbTblPtrs, int* primes, int nrPrime, unsigned int wrpSz,
-        int* cardinalityOfComms_old, int* cardinalityOfComms_new, float *wDegs) {
+        int* cardinalityOfComms_old, int* cardinalityOfComms_new, float *wDegs,
+        void* denseTableMem, int nrDenseTables, int nrComms) {
+
+    const int type = (GRAPH_TYPE == ANY_GRAPH) ? graphType : GRAPH_TYPE;
 
-    HashItem* blockTable = NULL;
+    // table memory holds ITEM slots (TableMemory)
+    ITEM* gblTable = (ITEM*) gblTableMem;
+    ITEM* denseTables = (ITEM*) denseTableMem;
+
+    ITEM* blockTable = NULL;
     float *weightsMem = NULL;
 
-    __shared__ HashItem blkTblShared[SHARED_TABLE_SIZE];
+    __shared__ ITEM blkTblShared[SHARED_TABLE_SIZE];
 
     //NOTE: Make sure host module has allocated at least 2 times memory than upper limit
     //for global Hash Table
@@ -1076,6 +1150,7 @@ void lookAtNeigboringComms(int* indices, unsigned int* links, float* weights,
         unsigned int endOfNhd = indices[node + 1];
 
         int nr_neighbor = (endOfNhd - startOfNhd);
+        bool isDense = false;
 
 
         if (nr_neighbor < (SHARED_TABLE_SIZE * CAPACITY_FACTOR_NUMERATOR / CAPACITY_FACTOR_DENOMINATOR)) {
@@ -1095,6 +1170,13 @@ void lookAtNeigboringComms(int* indices, unsigned int* links, float* weights,
 	
              */
 
+        } else if (blockIdx.x < nrDenseTables && (long) nr_neighbor * DENSE_TABLE_RATIO >= nrComms) {
+
+            // the first nrDenseTables blocks own a table of nrComms slots
+            blockTable = &denseTables[(size_t) blockIdx.x * nrComms];
+            bucketSize = nrComms;
+            isDense = true;
+
         } else {
 
             blockTable = &gblTable[tblStart];
@@ -1115,8 +1197,9 @@ void lookAtNeigboringComms(int* indices, unsigned int* links, float* weights,
             weightsMem = &weights[startOfNhd];
         }
 
-        // Clear HashTable
-        initByBlock(blockTable, bucketSize, threadIdx.x, blockDim.x);
+        // Clear HashTable; dense tables are kept clean after each row
+        if (!isDense)
+            initByBlock(blockTable, bucketSize, threadIdx.x, blockDim.x);
         float wDegNode = wDegs[node];
         /*
         // Lets get it done by warp; each warp will do the same independently
@@ -1134,12 +1217,22 @@ void lookAtNeigboringComms(int* indices, unsigned int* links, float* weights,
         if (threadIdx.x == 0 && node == EID)
             printf("\n------> Before Call to decideBestDest\n");
          */
-        decideBestDest(node, threadIdx.x, nr_neighbor, &links[startOfNhd],
+        decideBestDest<GRAPH_TYPE>(node, threadIdx.x, nr_neighbor, &links[startOfNhd],
                 weightsMem, n2c, in, tot, wDegNode, total_weight,
                 &nr_moves, tot_new, n2c_new, blockTable,
                 bucketSize, blockDim.x, wrpSz, cardinalityOfComms_old,
                 cardinalityOfComms_new);
 
+        if (isDense) {
+            __syncthreads();
+            clearTouchedByBlock(blockTable, &links[startOfNhd], nr_neighbor,
+                    n2c, NULL, threadIdx.x, blockDim.x);
+            if (!threadIdx.x) {
+                blockTable[n2c[node]].cId = FLAG_FREE;
+                tableClearGravity(blockTable[n2c[node]]);
+            }
+            __syncthreads();
+        }
 
         commIndex += gridDim.x;
 
@@ -1148,7 +1241,8 @@ void lookAtNeigboringComms(int* indices, unsigned int* links, float* weights,
     nr_moves = blockReduce(nr_moves, wrpSz);
     // Only one thread in a block will do the  following
     if (!threadIdx.x) {
-        //---> movement_record[blockIdx.x] = nr_moves;
+        if (movement_record)
+            movement_record[blockIdx.x] = nr_moves;
         if (nr_moves < 0)
             printf("\n nr_moves can't be negative \n");
     }
@@ -1159,58 +1253,11 @@ void lookAtNeigboringComms(int* indices, unsigned int* links, float* weights,
     */
 }
 
-/**
- * Returns bucketSize if inserted new record in the table else position of record 
- * @param Table
- * @param bucketSize
- * @param dataItem
- * @return 
- */
-#ifdef RUNONGPU
-
-__device__
-#endif
-int hashInsertSimple(HashItem* Table, unsigned int bucketSize, HashItem *dataItem) {
-
-
-    unsigned int i = 0, j = 0;
-    unsigned int h1 = H1GPU(dataItem->cId, bucketSize); // h1
-    unsigned int h2 = H2GPU(dataItem->cId, bucketSize);
-
-
-    do {
-
-        j = (h1 + i * h2) % bucketSize;
-
-        //NOTE: HashTable stores (cid+1)
-        int currCId = atomicCAS((int*) &Table[j].cId, FLAG_FREE, (1 + dataItem->cId));
-
-        if (currCId == FLAG_FREE) { // new cId @ location j;  exactly ONE winner
-
-            //printf("\nCame with %d \n", dataItem->cId);
-
-            atomicAdd((float*) &Table[j].gravity, dataItem->gravity);
-            //return (int) i;
-            return (int) bucketSize; // returns bucketSize to indicate new in table
-
-        } else if (currCId == (1 + dataItem->cId)) {
-
-            atomicAdd((float*) &Table[j].gravity, dataItem->gravity);
-            return (int) i;
-
-        } else {
-            i = i + 1;
-        }
-
-    } while (i < bucketSize);
-
-    return -1;
-}
+template<typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-int hashInsertSimple2(HashItem* Table, unsigned int bucketSize, HashItem *dataItem, int cId, int node) {
+int hashInsertSimple2(ITEM* Table, unsigned int bucketSize, HashItem *dataItem, int cId, int node) {
 
 
     unsigned int i = 0, j = 0;
@@ -1232,13 +1279,15 @@ int hashInsertSimple2(HashItem* Table, unsigned int bucketSize, HashItem *dataIt
 
             //if(cId==CID)printf("\nCame with %d  threadid.x = %u node = %d bucketSize=%u cid = %d j = %u\n", dataItem->cId, threadIdx.x, node, bucketSize, cId, j);
 
-            atomicAdd((float*) &Table[j].gravity, dataItem->gravity);
+            tableAddGravity(&Table[j], dataItem->gravity);
+            HASH_STAT_INSERT(bucketSize, i + 1);
             //return (int) i;
             return (int) bucketSize; // returns bucketSize to indicate new in table
 
         } else if (currCId == (1 + dataItem->cId)) {
 
-            atomicAdd((float*) &Table[j].gravity, dataItem->gravity);
+            tableAddGravity(&Table[j], dataItem->gravity);
+            HASH_STAT_INSERT(bucketSize, i + 1);
             return (int) i;
 
         } else {
@@ -1248,28 +1297,29 @@ int hashInsertSimple2(HashItem* Table, unsigned int bucketSize, HashItem *dataIt
     } while (i < bucketSize);
 
     printf("\n Can't Happen  for neighbor= %d of node= %d bucketSize= %d \n", dataItem->cId, cId, bucketSize);
+    HASH_STAT_INSERT(bucketSize, -1);
 
     return -1;
 }
+template<typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-void initWarpHashTable(HashItem* shashTable, unsigned int bucketSize,
+void initWarpHashTable(ITEM* shashTable, unsigned int bucketSize,
         unsigned int laneId, unsigned int WARP_SIZE) {
 
     // Warp based initialization
     for (unsigned int i = laneId; i < bucketSize; i = i + WARP_SIZE) {
         shashTable[i].cId = FLAG_FREE;
-        shashTable[i].gravity = 0.0;
+        tableClearGravity(shashTable[i]);
     }
 }
 
+template<int GRAPH_TYPE, typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-void hashNeighborsOfNode(unsigned int cid, HashItem* hashTable, float* weightsOfNhood,
+void hashNeighborsOfNode(unsigned int cid, ITEM* hashTable, float* weightsOfNhood,
         int szNhood, unsigned int* neighbors, int* n2c, int* renumber,
         unsigned int bucketSize, unsigned int laneId, int *nrDiscoveredByMe,
         unsigned int WARP_SIZE) {
@@ -1280,7 +1330,7 @@ void hashNeighborsOfNode(unsigned int cid, HashItem* hashTable, float* weightsOf
     for (unsigned int i = laneId; i < szNhood; i = i + WARP_SIZE) {
 
         item.cId = renumber[n2c[neighbors[i]]];
-        item.gravity = (weightsOfNhood == NULL) ? 1.0 : weightsOfNhood[i];
+        item.gravity = linkWeight<GRAPH_TYPE>(weightsOfNhood, i);
 
         //hash the item into hasTable
         int retValue = hashInsertSimple(hashTable, bucketSize, &item);
@@ -1319,11 +1369,11 @@ void hashNeighborsOfNode(unsigned int cid, HashItem* hashTable, float* weightsOf
  * @param newLinksOfNewComm
  * @param newWeightsOfNewComm
  */
+template<typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-void collectFromHashTable(unsigned int cid, HashItem* hashTable, int szNhood, unsigned int* neighbors,
+void collectFromHashTable(unsigned int cid, ITEM* hashTable, int szNhood, unsigned int* neighbors,
         int* n2c, int* renumber, unsigned int bucketSize, unsigned int laneId,
         int *offsetInGlobalMem, unsigned int* newLinksOfNewComm, float* newWeightsOfNewComm, unsigned int WARP_SIZE) {
 
@@ -1333,7 +1383,7 @@ void collectFromHashTable(unsigned int cid, HashItem* hashTable, int szNhood, un
 
     unsigned int wid = threadIdx.x / WARP_SIZE;
     wid = blockIdx.x * (blockDim.x / WARP_SIZE) + wid;
-    HashItem dataItem;
+    ITEM dataItem;
     for (unsigned int i = laneId; i < szNhood; i = i + WARP_SIZE) {
 
         int neighId = neighbors[i];
@@ -1359,7 +1409,7 @@ void collectFromHashTable(unsigned int cid, HashItem* hashTable, int szNhood, un
 
 
             newLinksOfNewComm[*offsetInGlobalMem] = dataItem.cId - 1;
-            newWeightsOfNewComm[*offsetInGlobalMem] = dataItem.gravity;
+            newWeightsOfNewComm[*offsetInGlobalMem] = tableGravity(dataItem);
             /*
             if (DUMP && cid == 6)
                 printf("\n-------------Fetched---------->>>> wid = %u laneId =%u neighId=%d C= %d  W= %f szNhood=%d\n", wid, laneId, neighId, dataItem.cId - 1, dataItem.gravity, szNhood);
@@ -1371,16 +1421,16 @@ void collectFromHashTable(unsigned int cid, HashItem* hashTable, int szNhood, un
 
 }
 
+template<typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-void clrTblByWarp(HashItem* table, int bucketSz, int WarpSize, int laneId) {
+void clrTblByWarp(ITEM* table, int bucketSz, int WarpSize, int laneId) {
 
     for (int i = laneId; i < bucketSz; i = i + WarpSize) {
 
         table[i].cId = 0;
-        table[i].gravity = 0;
+        tableClearGravity(table[i]);
     }
 
 }
@@ -1397,15 +1447,19 @@ void clrTblByWarp(HashItem* table, int bucketSz, int WarpSize, int laneId) {
  * @param wid
  * @param graphType
  */
+template<unsigned int GROUP_SIZE, unsigned int TABLE_SIZE, int GRAPH_TYPE, typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-void processNodesOfNewComm(HashItem* table, unsigned int* links, float* weights,
+void processNodesOfNewComm(ITEM* table, unsigned int* links, float* weights,
         int* superNodes, int* commNodes, int* indices, int* n2c, int* renumber,
-        unsigned int bucketSize, unsigned int laneId, unsigned int cid,
-        int graphType, unsigned int* linksOfNewComm, float* weightsOfNewComm,
-        unsigned int* nrNeighborsOfNewComms, unsigned int WARP_SIZE) {
+        unsigned int tableSize, unsigned int laneId, unsigned int cid,
+        int type, unsigned int* linksOfNewComm, float* weightsOfNewComm,
+        unsigned int* nrNeighborsOfNewComms, unsigned int wrpSz) {
+
+    const unsigned int WARP_SIZE = GROUP_SIZE ? GROUP_SIZE : wrpSz;
+    const unsigned int bucketSize = TABLE_SIZE ? TABLE_SIZE : tableSize;
+    const int graphType = (GRAPH_TYPE == ANY_GRAPH) ? type : GRAPH_TYPE;
 
 
     int startOfNewComm = superNodes[cid];
@@ -1436,7 +1490,7 @@ void processNodesOfNewComm(HashItem* table, unsigned int* links, float* weights,
         //clrTblByWarp(table, bucketSize, WARP_SIZE, laneId);
         //Hash all neighbors of a node
 
-        hashNeighborsOfNode(cid, table, weightsOfNeighood, szNeighood,
+        hashNeighborsOfNode<GRAPH_TYPE>(cid, table, weightsOfNeighood, szNeighood,
                 &links[startOfNeighood], n2c, renumber, bucketSize, laneId, &nrDiscovered, WARP_SIZE);
 
     }
@@ -1462,6 +1516,7 @@ void processNodesOfNewComm(HashItem* table, unsigned int* links, float* weights,
     // write actual #neighbor of new community
     if (laneId == WARP_SIZE - 1) {
         nrNeighborsOfNewComms[cid + 1] = myPosition;
+        HASH_STAT_LOAD(bucketSize, myPosition);
     }
 
 
@@ -1634,11 +1689,11 @@ void checkTable(int cId, int bucketSize, HashItem* table) {
         __syncthreads();
     }
 }
+template<int GRAPH_TYPE, typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-void hashNeighbors(HashItem* hashTable, float* weightsOfNhood,
+void hashNeighbors(ITEM* hashTable, float* weightsOfNhood,
         int szNhood, unsigned int* neighbors, int* n2c, int* renumber,
         unsigned int bucketSize, unsigned int workerId, int *nrDiscoveredByMe,
         int stride, int cId, unsigned int wrpSz, int node) {
@@ -1661,7 +1716,7 @@ void hashNeighbors(HashItem* hashTable, float* weightsOfNhood,
         //printf("\ni=%d neighbor[%d] =%d szNhood = %d\n", i, i, neighbors[i], szNhood);
 
         item.cId = renumber[n2c[neighbors[i]]];
-        item.gravity = (weightsOfNhood == NULL) ? 1.0 : weightsOfNhood[i];
+        item.gravity = linkWeight<GRAPH_TYPE>(weightsOfNhood, i);
 
         //hash the item into hasTable
         /*
@@ -1718,11 +1773,11 @@ void hashNeighbors(HashItem* hashTable, float* weightsOfNhood,
     __syncthreads();
 
 }
+template<typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-void collectFromHash(HashItem* hashTable, int szNhood, unsigned int* neighbors,
+void collectFromHash(ITEM* hashTable, int szNhood, unsigned int* neighbors,
         int* n2c, int* renumber, unsigned int bucketSize, unsigned int workerId,
         int *offsetInGlobalMem, unsigned int* newLinksOfNewComm,
         float* newWeightsOfNewComm, int stride) {
@@ -1731,7 +1786,7 @@ void collectFromHash(HashItem* hashTable, int szNhood, unsigned int* neighbors,
     HashItem item;
     unsigned int nrAttempt = 0;
 
-    HashItem dataItem;
+    ITEM dataItem;
 
     for (unsigned int i = workerId; i < szNhood; i = i + stride) {
 
@@ -1762,7 +1817,7 @@ void collectFromHash(HashItem* hashTable, int szNhood, unsigned int* neighbors,
             //printf("\n-------------Fetched---------->>>>  workerId=%d neighId=%d C= %d szNhood=%d\n",  workerId, neighId, dataItem.cId, szNhood);
 
             newLinksOfNewComm[*offsetInGlobalMem] = dataItem.cId - 1;
-            newWeightsOfNewComm[*offsetInGlobalMem] = dataItem.gravity;
+            newWeightsOfNewComm[*offsetInGlobalMem] = tableGravity(dataItem);
             *offsetInGlobalMem = *offsetInGlobalMem + 1;
         }
     }
@@ -1810,16 +1865,18 @@ __global__ void prescan(float *g_odata, float *g_idata, int n) {
 }
 
 
+template<int GRAPH_TYPE, typename ITEM>
 #ifdef RUNONGPU
-
 __device__
 #endif
-void processCommByBlock(HashItem* table, unsigned int* links, float* weights,
+void processCommByBlock(ITEM* table, unsigned int* links, float* weights,
         int* superNodes, int* commNodes, int* indices, int* n2c, int* renumber,
-        unsigned int bucketSize, int graphType, unsigned int* linksOfNewComm,
+        unsigned int bucketSize, int type, unsigned int* linksOfNewComm,
         float* weightsOfNewComm, unsigned int* nrNeighborsOfNewComms, int cId,
         unsigned int wrpSz) {
 
+    const int graphType = (GRAPH_TYPE == ANY_GRAPH) ? type : GRAPH_TYPE;
+
     int startOfNewComm = superNodes[cId];
     int endOfNewComm = superNodes[cId + 1];
 
@@ -1851,7 +1908,7 @@ void processCommByBlock(HashItem* table, unsigned int* links, float* weights,
          */
 
         //Hash all neighbors of a node
-        hashNeighbors(table, weightsOfNeighood, szNeighood,
+        hashNeighbors<GRAPH_TYPE>(table, weightsOfNeighood, szNeighood,
                 &links[startOfNeighood], n2c, renumber, bucketSize, threadIdx.x,
                 &nrDiscovered, blockDim.x, cId, wrpSz, node);
 
@@ -1872,6 +1929,9 @@ void processCommByBlock(HashItem* table, unsigned int* links, float* weights,
 
     int myPosition = blockPrefix(nrDiscovered, nrNeighborsOfNewComms, cId, wrpSz);
 
+    // the last thread wrote the #neighbors of the new community
+    if (threadIdx.x == blockDim.x - 1) HASH_STAT_LOAD(bucketSize, nrNeighborsOfNewComms[cId + 1]);
+
     /*
     int nrH = blockReduce(nrDiscovered);
     __syncthreads();
@@ -1913,19 +1973,24 @@ void processCommByBlock(HashItem* table, unsigned int* links, float* weights,
 /**
  * Make sure that both blocks and grids  are ONE-DIMENSIONAL
  */
+template<int GRAPH_TYPE, typename ITEM>
 __global__
 void findNewNeighodByBlock(int* super_node_ptrs, float* newWeights,
         unsigned int* newLinks, unsigned int* nrNeighborsOfNewComms,
         int* indices, float* weights, unsigned int* links, int* comms_nodes,
         int new_nb_comm, int* n2c, int* renumber, int* start_locations,
         int graphType, unsigned int bucketSize, int* candidateComms,
-        int nrCandidateComms, HashItem* gblTable, int* glbTblPtrs,
-        int* primes, int nrPrime, unsigned int wrpSz) {
+        int nrCandidateComms, void* gblTableMem, int* glbTblPtrs,
+        int* primes, int nrPrime, unsigned int wrpSz, void* denseTableMem,
+        int nrDenseTables) {
 
+    // table memory holds ITEM slots (TableMemory)
+    ITEM* gblTable = (ITEM*) gblTableMem;
+    ITEM* denseTables = (ITEM*) denseTableMem;
 
-    HashItem* blockTable = NULL;
+    ITEM* blockTable = NULL;
 
-    __shared__ HashItem blkTblShared[SHARED_TABLE_SIZE];
+    __shared__ ITEM blkTblShared[SHARED_TABLE_SIZE];
 
     //NOTE: Make sure host module has allocated at least 2 times memory than upper limit
 
@@ -1950,6 +2015,7 @@ void findNewNeighodByBlock(int* super_node_ptrs, float* newWeights,
 
         //USE maxSizeOfNeighborhood to decide type of hashTable;shared or global
         int maxSizeOfNeighborhood = gblEnd - gblStart;
+        bool isDense = false;
 
         if (maxSizeOfNeighborhood < (SHARED_TABLE_SIZE / 2)) {
 
@@ -1973,6 +2039,13 @@ void findNewNeighodByBlock(int* super_node_ptrs, float* newWeights,
 
             bucketSize = nearestPrime;
 
+        } else if (blockIdx.x < nrDenseTables && (long) maxSizeOfNeighborhood * DENSE_TABLE_RATIO >= new_nb_comm) {
+
+            // slots are indexed by the renumbered id of the neighbor community
+            blockTable = &denseTables[(size_t) blockIdx.x * new_nb_comm];
+            bucketSize = new_nb_comm;
+            isDense = true;
+
         } else {
 
 
@@ -1997,15 +2070,27 @@ void findNewNeighodByBlock(int* super_node_ptrs, float* newWeights,
             return;
         }
 
-        initByBlock(blockTable, bucketSize, threadIdx.x, blockDim.x);
+        if (!isDense)
+            initByBlock(blockTable, bucketSize, threadIdx.x, blockDim.x);
 
 
 
-        processCommByBlock(blockTable, links, weights, super_node_ptrs,
+        processCommByBlock<GRAPH_TYPE>(blockTable, links, weights, super_node_ptrs,
                 comms_nodes, indices, n2c, renumber, bucketSize, graphType,
                 &newLinks[gblStart], &newWeights[gblStart],
                 nrNeighborsOfNewComms, cId, wrpSz);
 
+        // neighbor lists are restored by collectFromHash at this point
+        if (isDense) {
+            for (int i = super_node_ptrs[cId]; i < super_node_ptrs[cId + 1]; i++) {
+                int node = comms_nodes[i];
+                clearTouchedByBlock(blockTable, &links[indices[node]],
+                        indices[node + 1] - indices[node], n2c, renumber,
+                        threadIdx.x, blockDim.x);
+            }
+            __syncthreads();
+        }
+
         // Put Marked on unused memory
 
 
@@ -2028,22 +2113,26 @@ void findNewNeighodByBlock(int* super_node_ptrs, float* newWeights,
     }
 }
 
+template<unsigned int GROUP_SIZE, unsigned int TABLE_SIZE, int GRAPH_TYPE, typename ITEM>
 __global__
 void determineNewNeighborhood(int* super_node_ptrs, float* newWeights,
         unsigned int* newLinks, unsigned int* nrNeighborsOfNewComms, int* indices,
         float* weights, unsigned int* links, int* comms_nodes, int new_nb_comm,
         int* n2c, int* renumber, int* start_locations, int graphType,
-        unsigned int bktSzLimit, int* candidateComms, int nrCandidateComms,
-        unsigned int WARP_SIZE) {
+        unsigned int tableSize, int* candidateComms, int nrCandidateComms,
+        unsigned int wrpSz) {
+
+    const unsigned int WARP_SIZE = GROUP_SIZE ? GROUP_SIZE : wrpSz;
+    const unsigned int bktSzLimit = TABLE_SIZE ? TABLE_SIZE : tableSize;
 
     unsigned int wid = threadIdx.x / WARP_SIZE;
     unsigned int laneId = threadIdx.x & (WARP_SIZE - 1); // id in the warp
 
 
-    extern __shared__ HashItem __sMem[];
+    extern __shared__ long long __sMem[];
 
     // NOTE: bucketSize == size of Table in "Warp Memory"
-    HashItem* shashTable = __sMem + wid * bktSzLimit;
+    ITEM* shashTable = (ITEM*) __sMem + wid * bktSzLimit;
 
     initWarpHashTable(shashTable, bktSzLimit, laneId, WARP_SIZE);
 
@@ -2072,7 +2161,7 @@ void determineNewNeighborhood(int* super_node_ptrs, float* newWeights,
 
             initWarpHashTable(shashTable, bktSzLimit, laneId, WARP_SIZE);
 
-            processNodesOfNewComm(shashTable, links, weights, super_node_ptrs,
+            processNodesOfNewComm<GROUP_SIZE, TABLE_SIZE, GRAPH_TYPE>(shashTable, links, weights, super_node_ptrs,
                     comms_nodes, indices, n2c, renumber, bktSzLimit, laneId,
                     cId, graphType, &newLinks[gblStart], &newWeights[gblStart],
                     nrNeighborsOfNewComms, WARP_SIZE);
@@ -2298,3 +2387,116 @@ void computeMaxDegreeForWarps(int * indices, int *maxDegreePerWarp,
 
 }
 
+template<unsigned int GROUP_SIZE, unsigned int TABLE_SIZE, typename ITEM>
+static NeighCommKernel neighCommOfType(int type) {
+
+    if (type == WEIGHTED)
+        return neigh_comm<GROUP_SIZE, TABLE_SIZE, WEIGHTED, ITEM>;
+    return neigh_comm<GROUP_SIZE, TABLE_SIZE, UNWEIGHTED, ITEM>;
+}
+
+template<typename ITEM>
+static NeighCommKernel neighCommOfItem(unsigned int wrpSz, unsigned int bucketSize, int type, bool generic) {
+
+    if (!generic) {
+        if (wrpSz == QUARTER_WARP / 2 && bucketSize == LEQ4_TABLE_SIZE)
+            return neighCommOfType<QUARTER_WARP / 2, LEQ4_TABLE_SIZE, ITEM>(type);
+        if (wrpSz == QUARTER_WARP && bucketSize == LEQ8_TABLE_SIZE)
+            return neighCommOfType<QUARTER_WARP, LEQ8_TABLE_SIZE, ITEM>(type);
+        if (wrpSz == HALF_WARP && bucketSize == LEQ16_TABLE_SIZE)
+            return neighCommOfType<HALF_WARP, LEQ16_TABLE_SIZE, ITEM>(type);
+        if (wrpSz == PHY_WRP_SZ && bucketSize == LEQ32_TABLE_SIZE)
+            return neighCommOfType<PHY_WRP_SZ, LEQ32_TABLE_SIZE, ITEM>(type);
+        if (wrpSz == PHY_WRP_SZ && bucketSize == WARP_TABLE_SIZE_1)
+            return neighCommOfType<PHY_WRP_SZ, WARP_TABLE_SIZE_1, ITEM>(type);
+    }
+    return neigh_comm<0, 0, ANY_GRAPH, ITEM>;
+}
+
+NeighCommKernel selectNeighComm(unsigned int wrpSz, unsigned int bucketSize, int type, bool generic, bool deterministic) {
+
+    if (deterministic)
+        return neighCommOfItem<WideHashItem>(wrpSz, bucketSize, type, generic);
+    return neighCommOfItem<HashItem>(wrpSz, bucketSize, type, generic);
+}
+
+NeighCommKernel selectNeighCommInRegisters(unsigned int wrpSz, int type) {
+
+    if (wrpSz == QUARTER_WARP / 2)
+        return (type == WEIGHTED) ? neighCommInRegisters<QUARTER_WARP / 2, WEIGHTED> : neighCommInRegisters<QUARTER_WARP / 2, UNWEIGHTED>;
+    if (wrpSz == QUARTER_WARP)
+        return (type == WEIGHTED) ? neighCommInRegisters<QUARTER_WARP, WEIGHTED> : neighCommInRegisters<QUARTER_WARP, UNWEIGHTED>;
+    return NULL;
+}
+
+template<typename ITEM>
+static BlockMoveKernel lookAtNeigboringCommsOfItem(int type, bool generic) {
+
+    if (generic)
+        return lookAtNeigboringComms<ANY_GRAPH, ITEM>;
+    if (type == WEIGHTED)
+        return lookAtNeigboringComms<WEIGHTED, ITEM>;
+    return lookAtNeigboringComms<UNWEIGHTED, ITEM>;
+}
+
+BlockMoveKernel selectLookAtNeigboringComms(int type, bool generic, bool deterministic) {
+
+    if (deterministic)
+        return lookAtNeigboringCommsOfItem<WideHashItem>(type, generic);
+    return lookAtNeigboringCommsOfItem<HashItem>(type, generic);
+}
+
+template<typename ITEM>
+static BlockContractKernel findNewNeighodByBlockOfItem(int type, bool generic) {
+
+    if (generic)
+        return findNewNeighodByBlock<ANY_GRAPH, ITEM>;
+    if (type == WEIGHTED)
+        return findNewNeighodByBlock<WEIGHTED, ITEM>;
+    return findNewNeighodByBlock<UNWEIGHTED, ITEM>;
+}
+
+BlockContractKernel selectFindNewNeighodByBlock(int type, bool generic, bool deterministic) {
+
+    if (deterministic)
+        return findNewNeighodByBlockOfItem<WideHashItem>(type, generic);
+    return findNewNeighodByBlockOfItem<HashItem>(type, generic);
+}
+
+template<typename ITEM>
+static WarpContractKernel determineNewNeighborhoodOfItem(unsigned int wrpSz, unsigned int bucketSize, int type, bool generic) {
+
+    if (!generic && wrpSz == PHY_WRP_SZ && bucketSize == WARP_TABLE_SIZE_1) {
+        if (type == WEIGHTED)
+            return determineNewNeighborhood<PHY_WRP_SZ, WARP_TABLE_SIZE_1, WEIGHTED, ITEM>;
+        return determineNewNeighborhood<PHY_WRP_SZ, WARP_TABLE_SIZE_1, UNWEIGHTED, ITEM>;
+    }
+    return determineNewNeighborhood<0, 0, ANY_GRAPH, ITEM>;
+}
+
+WarpContractKernel selectDetermineNewNeighborhood(unsigned int wrpSz, unsigned int bucketSize, int type, bool generic, bool deterministic) {
+
+    if (deterministic)
+        return determineNewNeighborhoodOfItem<WideHashItem>(wrpSz, bucketSize, type, generic);
+    return determineNewNeighborhoodOfItem<HashItem>(wrpSz, bucketSize, type, generic);
+}
+
+void setTableGravityScale(float scale) {
+
+    cudaMemcpyToSymbol(d_gravityScale, &scale, sizeof (float));
+}
+
+#ifdef HASH_PROBE_STATS
+
+void fetchHashProbeStats(HashProbeStats& stats) {
+
+    cudaMemcpyFromSymbol(&stats, d_hashStats, sizeof (HashProbeStats));
+}
+
+void resetHashProbeStats() {
+
+    HashProbeStats zeros;
+    clearHashProbeStats(zeros);
+    cudaMemcpyToSymbol(d_hashStats, &zeros, sizeof (HashProbeStats));
+}
+#endif
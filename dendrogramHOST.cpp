@@ -0,0 +1,58 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#include"dendrogramHOST.h"
+#include"algorithm"
+#include"assert.h"
+
+std::vector<int> Dendrogram::flatten(int nrLevel) const {
+
+    if (nrLevel < 0 || nrLevel > nrLevels())
+        nrLevel = nrLevels();
+
+    if (!nrLevels())
+        return std::vector<int>();
+
+    std::vector<int> partition(levels[0]);
+
+    if (!nrLevel) {
+        for (unsigned int v = 0; v < partition.size(); v++)
+            partition[v] = v;
+    }
+
+    for (int l = 1; l < nrLevel; l++) {
+        for (unsigned int v = 0; v < partition.size(); v++) {
+            assert(partition[v] >= 0 && partition[v] < (int) levels[l].size());
+            partition[v] = levels[l][partition[v]];
+        }
+    }
+    return partition;
+}
+
+int Dendrogram::nrCommunities(int nrLevel) const {
+
+    std::vector<int> partition = flatten(nrLevel);
+    if (!partition.size())
+        return 0;
+    return *std::max_element(partition.begin(), partition.end()) + 1;
+}
@@ -0,0 +1,55 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#ifndef DENDROGRAMHOST_H
+#define	DENDROGRAMHOST_H
+
+#include"vector"
+
+// levels[l][i] is the community (node of level l+1) that node i of level l
+// was merged into; level 0 nodes are the vertices of the input graph
+
+struct Dendrogram {
+    std::vector<std::vector<int> > levels;
+
+    int nrLevels() const {
+        return levels.size();
+    }
+
+    void addLevel(const std::vector<int>& n2c) {
+        levels.push_back(n2c);
+    }
+
+    // Community of each input vertex after the first nrLevel levels;
+    // nrLevel < 0 means all levels (the final partition)
+    std::vector<int> flatten(int nrLevel = -1) const;
+
+    // Number of distinct communities after nrLevel levels
+    int nrCommunities(int nrLevel = -1) const;
+
+    void clear() {
+        levels.clear();
+    }
+};
+
+#endif	/* DENDROGRAMHOST_H */
@@ -0,0 +1,158 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"ensembleHOST.h"
+#include"fstream"
+#include"sstream"
+#include"thread"
+#include"atomic"
+#include"algorithm"
+#include"time.h"
+#include"logger.h"
+
+#include<unistd.h>
+
+EnsembleHOST::EnsembleHOST(const GraphHOST& input_graph) : graph(input_graph), level0(input_graph) {
+
+    coAssociate = false;
+    topo = NULL;
+    nrFolded = 0;
+}
+
+int EnsembleHOST::maxJobs(size_t budget) const {
+
+    if (!budget)
+        budget = (size_t) sysconf(_SC_AVPHYS_PAGES) * sysconf(_SC_PAGESIZE);
+
+    // State arrays of allocateWork, plus contracted levels of at most the
+    // size of the input
+    size_t perNode = 3 * sizeof (int) + 5 * sizeof (double) + 2 * sizeof (unsigned long);
+    size_t perLink = sizeof (unsigned int) + sizeof (float);
+    size_t perInstance = perNode * level0.nb_nodes + perLink * level0.offsets.back();
+
+    return (int) std::max((size_t) 1, budget / std::max(perInstance, (size_t) 1));
+}
+
+void EnsembleHOST::fold(int run, const std::vector<int>& partition) {
+
+    if (partitionPrefix.size()) {
+        std::stringstream fileName;
+        fileName << partitionPrefix << "_" << run << ".txt";
+        std::ofstream out(fileName.str().c_str());
+        for (unsigned int v = 0; v < partition.size(); v++)
+            out << partition[v] << "\n";
+    }
+
+    if (!coAssociate)
+        return;
+
+    std::lock_guard<std::mutex> guard(foldLock);
+    for (unsigned int u = 0; u < level0.nb_nodes; u++)
+        for (unsigned long e = level0.offsets[u]; e < level0.offsets[u + 1]; e++)
+            agree[e] += (partition[u] == partition[level0.links[e]]);
+    nrFolded++;
+}
+
+double EnsembleHOST::run(int nrRuns, int nrJobs, unsigned int firstSeed, double threshold, int maxLevels) {
+
+    modularity.assign(nrRuns, 0);
+    seconds.assign(nrRuns, 0);
+    nrCommunities.assign(nrRuns, 0);
+    agree.assign(coAssociate ? level0.offsets.back() : 0, 0);
+    nrFolded = 0;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    std::atomic<int> nextRun(0);
+    nrJobs = std::max(1, std::min(nrJobs, nrRuns));
+
+    if (topo && wDegReplica.copies.size() != (size_t) topo->nrNodes)
+        wDegReplica.create(*topo, level0.wDegs.data(), level0.nb_nodes);
+
+    auto work = [&](int w) {
+
+        const double* wDegs = topo ? wDegReplica.of(topo->nodeOfWorker(w, nrJobs)) : NULL;
+
+        int r;
+        while ((r = nextRun++) < nrRuns) {
+
+            struct timespec runStart, runEnd;
+            clock_gettime(CLOCK_MONOTONIC, &runStart);
+
+            LouvainHOST instance(level0, firstSeed + r, wDegs);
+            instance.run(threshold, maxLevels);
+
+            // no level improved: every vertex stays on its own
+            std::vector<int> partition = instance.dendrogram.flatten();
+            if (!partition.size()) {
+                partition.resize(level0.nb_nodes);
+                for (unsigned int v = 0; v < level0.nb_nodes; v++)
+                    partition[v] = v;
+            }
+
+            // the instance reports the modularity of its last level
+            modularity[r] = graph.modularity(partition);
+            nrCommunities[r] = *std::max_element(partition.begin(), partition.end()) + 1;
+            fold(r, partition);
+
+            clock_gettime(CLOCK_MONOTONIC, &runEnd);
+            seconds[r] = (runEnd.tv_sec - runStart.tv_sec) + (runEnd.tv_nsec - runStart.tv_nsec) / 1.0e9;
+
+            LOG(LOG_DEBUG, "Ensemble run " << r << " (seed " << firstSeed + r << "): #Communities "
+                    << nrCommunities[r] << " Modularity " << modularity[r] << " in " << seconds[r] << " sec");
+        }
+    };
+
+    if (topo) {
+        runPinned(*topo, nrJobs, work);
+    } else {
+        std::vector<std::thread> workers;
+        for (int w = 0; w < nrJobs; w++)
+            workers.push_back(std::thread(work, w));
+        for (unsigned int w = 0; w < workers.size(); w++)
+            workers[w].join();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1.0e9;
+}
+
+double EnsembleHOST::writeCoAssociation(const std::string& fileName) const {
+
+    std::ofstream out(fileName.c_str());
+    double sum = 0;
+    unsigned long nrPairs = 0;
+
+    for (unsigned int u = 0; u < level0.nb_nodes; u++) {
+        for (unsigned long e = level0.offsets[u]; e < level0.offsets[u + 1]; e++) {
+            unsigned int v = level0.links[e];
+            if (v <= u)
+                continue;
+            double fraction = nrFolded ? (double) agree[e] / nrFolded : 0;
+            out << u << " " << v << " " << fraction << "\n";
+            sum += fraction;
+            nrPairs++;
+        }
+    }
+    return nrPairs ? sum / nrPairs : 0;
+}
@@ -0,0 +1,77 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#ifndef ENSEMBLEHOST_H
+#define	ENSEMBLEHOST_H
+
+#include"graphHOST.h"
+#include"louvainHOST.h"
+#include"numaHOST.h"
+#include"string"
+#include"vector"
+#include"mutex"
+
+// Many seeded LouvainHOST runs on one input graph, for consensus and
+// stability analysis. The CSR and its weighted degrees are held once
+// (SharedLevelHOST); each instance owns its n2c/tot, its visiting orders
+// and its contracted levels. Runs are folded into the results as they
+// finish, so no more than nrJobs partitions are alive at a time. With a
+// topology the workers are pinned node by node and each instance reads the
+// weighted degrees from the replica of its node.
+
+struct EnsembleHOST {
+    const GraphHOST& graph;
+    SharedLevelHOST level0;
+
+    std::string partitionPrefix; // run r writes partitionPrefix_r.txt; empty: none
+    bool coAssociate;
+    const NumaTopology* topo; // NULL: workers are not pinned
+
+    // Per run, in seed order
+    std::vector<double> modularity, seconds;
+    std::vector<int> nrCommunities;
+
+    // agree[e]: runs that put both ends of link e in one community
+    std::vector<unsigned int> agree;
+    int nrFolded;
+
+    EnsembleHOST(const GraphHOST& input_graph);
+
+    // Instances that fit next to each other in budget bytes (0: the free
+    // physical memory)
+    int maxJobs(size_t budget) const;
+
+    // Runs seeds firstSeed..firstSeed+nrRuns-1 on nrJobs threads; returns
+    // the wall-clock seconds
+    double run(int nrRuns, int nrJobs, unsigned int firstSeed, double threshold, int maxLevels);
+
+    // "u v fraction" per undirected link (u < v) and the mean over links
+    double writeCoAssociation(const std::string& fileName) const;
+
+private:
+    std::mutex foldLock;
+    NumaReplica<double> wDegReplica;
+
+    void fold(int run, const std::vector<int>& partition);
+};
+
+#endif	/* ENSEMBLEHOST_H */
@@ -0,0 +1,142 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+// Scores a partition of a graph given in the .bin format: modularity, its
+// share per community, coverage and performance, in one parallel scan of
+// the mapped CSR.
+//
+// usage: evalPartition graph.bin [weight.bin] partition.txt [--threads=T]
+//        [--top=K] [--contributions=FILE]
+
+#include"partitionEvalHOST.h"
+#include"logger.h"
+
+#include"iostream"
+#include"fstream"
+#include"string"
+#include"vector"
+#include"algorithm"
+#include"thread"
+#include"stdlib.h"
+#include"time.h"
+
+static double secondsSince(const struct timespec& start) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char** argv) {
+
+    int nrThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    int nrTop = 10;
+    std::string contributionFile;
+    std::vector<char*> positionalArgs(1, argv[0]);
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 10, "--threads=") == 0)
+            nrThreads = std::max(1, atoi(arg.c_str() + 10));
+        else if (arg.compare(0, 6, "--top=") == 0)
+            nrTop = std::max(0, atoi(arg.c_str() + 6));
+        else if (arg.compare(0, 16, "--contributions=") == 0)
+            contributionFile = arg.substr(16);
+        else if (arg.compare(0, 6, "--log=") == 0 && parseLogLevel(arg.substr(6)) >= 0)
+            setLogLevel(parseLogLevel(arg.substr(6)));
+        else
+            positionalArgs.push_back(argv[i]);
+    }
+
+    if (positionalArgs.size() < 3 || positionalArgs.size() > 4) {
+        LOG(LOG_ERROR, "usage: " << argv[0] << " graph.bin [weight.bin] partition.txt [--threads=T]"
+                << " [--top=K] [--contributions=FILE]");
+        return 1;
+    }
+
+    const char* graphFile = positionalArgs[1];
+    const char* weightFile = (positionalArgs.size() == 4) ? positionalArgs[2] : NULL;
+    const char* partitionFile = positionalArgs.back();
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    MappedCSR g;
+    if (!g.map(graphFile, weightFile)) {
+        LOG(LOG_ERROR, "cannot map " << graphFile << (weightFile ? " / " : "") << (weightFile ? weightFile : ""));
+        return 1;
+    }
+
+    std::vector<int> n2c;
+    int nrCommunities = 0;
+    if (!readPartition(partitionFile, g.nb_nodes, n2c, nrCommunities)) {
+        LOG(LOG_ERROR, partitionFile << " is not a partition of the " << g.nb_nodes << " vertices of " << graphFile);
+        return 1;
+    }
+    double readSeconds = secondsSince(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    PartitionScore score;
+    scorePartition(g, n2c, nrCommunities, nrThreads, score);
+    double scanSeconds = secondsSince(start);
+
+    LOG(LOG_SUMMARY, "#nodes: " << g.nb_nodes << " #links: " << g.nb_links << " #communities: " << nrCommunities);
+    LOG(LOG_SUMMARY, "Modularity: " << score.modularity << " Coverage: " << score.coverage
+            << " Performance: " << score.performance);
+    LOG(LOG_SUMMARY, "Scan: " << scanSeconds << " sec on " << score.nrThreads << " threads, "
+            << (scanSeconds > 0 ? 60 * g.nb_links / scanSeconds / 1e9 : 0) << " G links/min"
+            << " (partition read in " << readSeconds << " sec)");
+
+    // Largest contributions first
+    std::vector<int> order(nrCommunities);
+    for (int c = 0; c < nrCommunities; c++)
+        order[c] = c;
+    int nrShown = std::min(nrTop, nrCommunities);
+    std::partial_sort(order.begin(), order.begin() + nrShown, order.end(), [&](int a, int b) {
+        return score.contribution[a] > score.contribution[b];
+    });
+    for (int i = 0; i < nrShown; i++) {
+        int c = order[i];
+        LOG(LOG_INFO, "  community " << c << ": size " << score.sizes[c] << " in " << score.in[c]
+                << " tot " << score.tot[c] << " contribution " << score.contribution[c]);
+    }
+
+    if (contributionFile.size()) {
+        std::ofstream out(contributionFile.c_str());
+        out << "Community,Size,In,Tot,Contribution" << std::endl;
+        for (int c = 0; c < nrCommunities; c++)
+            out << c << "," << score.sizes[c] << "," << score.in[c] << "," << score.tot[c]
+                << "," << score.contribution[c] << "\n";
+    }
+
+    std::string logName = "Log/louvain_method_gpu_evaluation.csv";
+    std::ifstream infile(logName.c_str());
+    bool existingLog = infile.good();
+    std::ofstream log(logName.c_str(), std::ios_base::out | std::ios_base::app | std::ios_base::ate);
+    if (!existingLog)
+        log << "Graph,Partition,Threads,Links,Time,Links Per Sec,Modularity,Coverage,Performance,Communities" << std::endl;
+    log << graphFile << "," << partitionFile << "," << score.nrThreads << "," << g.nb_links << ","
+            << 1000 * scanSeconds << "," << (scanSeconds > 0 ? g.nb_links / scanSeconds : 0) << ","
+            << score.modularity << "," << score.coverage << "," << score.performance << "," << nrCommunities << std::endl;
+
+    return 0;
+}
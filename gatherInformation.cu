@@ -23,6 +23,7 @@
 
 #include"fstream"
 #include"communityGPU.h"
+#include"bucketing.h"
 
 template < class T>
 __global__
@@ -45,163 +46,110 @@ void filter_entries_by_threshold(T *source, T* dest, T threshold, int nr_old_com
     }
 }
 
-void Community::gatherStatistics(bool isPreprocess) {
+// The former chain: count, flag, scan, renumber, filter, scan, then a
+// scatter pass; kept to compare against bucketByKey (--bucket-compare)
 
-    bool hostPrint = false;
-    int sc;
-    sc = 0; //std::cin>>sc;
-    hostPrint = (sc > 1);
+static int gatherByChain(const thrust::device_vector<int>& n2c, int community_size, int nb_nodes,
+        int* indices, thrust::device_vector<int>& n2c_new, thrust::device_vector<int>& pos_ptr,
+        thrust::device_vector<int>& comm_nodes) {
 
     thrust::device_vector<int> renumber(community_size, 0);
 
-/*
-    thrust::host_vector<int> hn2c = n2c;
-    std::ofstream ofs;
-    ofs.open ("n2c.txt", std::ofstream::out | std::ofstream::app);
-    for(int i=0; i< hn2c.size(); i++) {
-
-	ofs<<i<<":"<<hn2c[i]<<" ";
-
-	if(hn2c[i]==320)
-		std::cout<<"####" << i  <<"; (cid before renumbering) "<<hn2c[i]<<std::endl;
-
-	if( (i+1)%100 == 0)
-		ofs<<"\n";		
-    }
-
-    ofs<<"\n";
-    ofs.close();
-*/
-    if (hostPrint) {
-        print_vector(renumber, " Size of Communities: ");
-        print_vector(n2c, "n2c: ");
-    }
-
     int load_per_blk = CHUNK_PER_WARP * (NR_THREAD_PER_BLOCK / PHY_WRP_SZ);
     int nr_of_block = (community_size + load_per_blk - 1) / load_per_blk;
 
+    int* n2cPtr = (int*) thrust::raw_pointer_cast(n2c.data());
 
-    //Count the size of each new community and store the sizes in renumber
-
-    cudaEvent_t start, stop;
-    cudaEventCreate(&start);
-    cudaEventCreate(&stop);
+    if (indices == NULL)
+        get_size_of_communities << < nr_of_block, NR_THREAD_PER_BLOCK >>>(
+                thrust::raw_pointer_cast(renumber.data()), n2cPtr, nb_nodes);
+    else
+        get_size_of_communities_NEW << < nr_of_block, NR_THREAD_PER_BLOCK >>>(
+                thrust::raw_pointer_cast(renumber.data()), n2cPtr, nb_nodes, indices);
 
-    cudaEventRecord(start, 0);
-    if(isPreprocess ==false ){
-    get_size_of_communities << < nr_of_block, NR_THREAD_PER_BLOCK >>>(
-            thrust::raw_pointer_cast(renumber.data()), thrust::raw_pointer_cast(n2c.data()), g.nb_nodes);
-    }else{
-    get_size_of_communities_NEW << < nr_of_block, NR_THREAD_PER_BLOCK >>>(
-            thrust::raw_pointer_cast(renumber.data()), thrust::raw_pointer_cast(n2c.data()), g.nb_nodes,thrust::raw_pointer_cast(g.indices.data()));
-    }
-    report_time(start, stop, "get_size_of_communities");
-
-
-    if (hostPrint) {
-        print_vector(renumber, "Size of Communities: (by Atomic Add) ");
-    }
-
-
-    n2c_new.resize(community_size, 0);// DO NOT clear it here, it will be cleared in gatherStatistics
-    // 1 to indicate community of size greater or equal 1, 
-
-    assert(renumber.size() == n2c_new.size());
-  
-    //int myZero = 0;
-    //if(isPreprocess == true)
-	//myZero = 1;
+    n2c_new.resize(community_size);
 
     thrust::transform(thrust::device, renumber.begin(), renumber.end(),
             n2c_new.begin(), IsGreaterThanZero<int>(0));
-
-    //NOTE:n2c_new contains 0s and 1s only
-
-    if (hostPrint) {
-        print_vector(n2c_new, "Before Prefix Sum: ");
-    }
-
     thrust::inclusive_scan(thrust::device, n2c_new.begin(), n2c_new.end(), n2c_new.begin());
 
-    int new_nb_comm = n2c_new.back();
-
-    if (hostPrint) {
-        print_vector(n2c_new, "After Prefix Sum: ");
-    }
-
+    int new_nb_comm = community_size ? n2c_new.back() : 0;
 
     thrust::transform(thrust::device, renumber.begin(), renumber.end(),
             n2c_new.begin(), n2c_new.begin(), Community_ID_By_Prefix_Sum<int>());
 
-    // After Transform, n2c_new contains mapping from old_CId to new_Cid
-    {
+    pos_ptr.assign(new_nb_comm + 1, 0);
 
-        //(renumber): 0 4 0 0 0, 0 4 0 0 0,......( #member per Community)
-        // (n2c_new): 0 1 1 1 1, 1 2 2 2 2,...............   
+    filter_entries_by_threshold << < nr_of_block, NR_THREAD_PER_BLOCK >>>(
+            thrust::raw_pointer_cast(renumber.data()), thrust::raw_pointer_cast(pos_ptr.data()) + 1,
+            (int) 0, community_size, thrust::raw_pointer_cast(n2c_new.data()));
 
-        //( n2c_new): X 0 X X X, X 1 X X X,.......( New CId, X = -1 in my case)
+    thrust::inclusive_scan(thrust::device, pos_ptr.begin(), pos_ptr.end(), pos_ptr.begin(),
+            thrust::plus<int>());
 
-        //n2c_new now holds renumbered CIDs *******
-    }
+    // group_nodes_based_on_new_CID advances the pointers it is given
+    thrust::device_vector<int> cursors(pos_ptr);
+    comm_nodes.resize(pos_ptr.back());
 
-    /*
-    thrust::host_vector<int> hn2c_new = n2c_new;
-   
-    	for(int i=0; i< hn2c_new.size(); i++) {
-    		if(hn2c_new[i] == 63 || ( i>=320 && i<=329) || (i >=2945 && i <=2949) )
-			std::cout<<"node:"<<i<<" ; new_CID "<<hn2c_new[i]<<std::endl;
-	}
-    */
-    
-    if (hostPrint) {
-        print_vector(n2c_new, "CID by Prefix Sum: ");
-    }
+    group_nodes_based_on_new_CID << < nr_of_block, NR_THREAD_PER_BLOCK>>>
+            (thrust::raw_pointer_cast(comm_nodes.data()),
+            thrust::raw_pointer_cast(cursors.data()),
+            thrust::raw_pointer_cast(n2c_new.data()), n2cPtr, nb_nodes);
 
-   //std::cout << "#NewCommunity: " << new_nb_comm << std::endl;
+    return new_nb_comm;
+}
 
-    //for next phase
-    pos_ptr_of_new_comm.resize(new_nb_comm + 1, 0);
+// Renumbers the surviving communities and groups the vertices by their
+// new community: n2c_new (old to new id, -1 if empty), pos_ptr_of_new_comm
+// and comm_nodes, which compute_next_graph contracts
 
+void Community::gatherStatistics(bool isPreprocess) {
 
+    bool hostPrint = LOG_ENABLED(LOG_TRACE);
 
-    if (hostPrint) {
-        print_vector(pos_ptr_of_new_comm, "Pos ptrs: ");
-    }
+    // isolated vertices are filtered out at the beginning
+    int* indices = isPreprocess ? thrust::raw_pointer_cast(g.indices.data()) : NULL;
+
+    cudaEvent_t start, stop;
+    cudaEventCreate(&start);
+    cudaEventCreate(&stop);
 
-    // copy all non zero entries that corresponds to #nodes per communities 
+    float chainMs = 0;
+    thrust::device_vector<int> chainMap, chainPtrs, chainNodes;
 
-    //Note: renumber still contains #nodes per community
-    //n2c_new contains renumbered cIds of communities having size >=1
+    if (bucketCompare) {
+        cudaEventRecord(start, 0);
+        gatherByChain(n2c, community_size, g.nb_nodes, indices, chainMap, chainPtrs, chainNodes);
+        cudaEventRecord(stop, 0);
+        cudaEventSynchronize(stop);
+        cudaEventElapsedTime(&chainMs, start, stop);
+    }
 
     cudaEventRecord(start, 0);
 
-    filter_entries_by_threshold << < nr_of_block, NR_THREAD_PER_BLOCK >>>(
-            thrust::raw_pointer_cast(renumber.data()), thrust::raw_pointer_cast(pos_ptr_of_new_comm.data()) + 1,
-            (int) 0, community_size, thrust::raw_pointer_cast(n2c_new.data()));
+    int new_nb_comm = bucketByKey(n2c, community_size, indices, n2c_new, pos_ptr_of_new_comm, comm_nodes);
 
-    report_time(start, stop, "filter_entries_by_threshold");
+    cudaEventRecord(stop, 0);
+    cudaEventSynchronize(stop);
+    float primitiveMs = 0;
+    cudaEventElapsedTime(&primitiveMs, start, stop);
 
-    // copied all non zero entries that corresponds to #nodes per communities into pos_ptr_of_new_comm
-
-    if (hostPrint) {
-        print_vector(pos_ptr_of_new_comm, "Pos ptrs: ");
+    if (bucketCompare) {
+        bool same = (chainMap == n2c_new) && (chainPtrs == pos_ptr_of_new_comm);
+        if (!same)
+            LOG(LOG_ERROR, "bucketByKey disagrees with the scan chain at level " << level);
+        LOG(LOG_DEBUG, "Renumber and group " << new_nb_comm << " communities: chain " << chainMs
+                << " ms, bucketByKey " << primitiveMs << " ms");
+        bucketTimes.push_back(std::make_pair(chainMs, primitiveMs));
     }
 
-    // after prefix sum pos_ptr points to start of each community where 
-    //nodes of same community are placed consecutively
-
-    thrust::inclusive_scan(thrust::device, pos_ptr_of_new_comm.begin(),
-            pos_ptr_of_new_comm.end(), pos_ptr_of_new_comm.begin(),
-            thrust::plus<int>());
-
-
     if (hostPrint) {
+        print_vector(n2c_new, "CID by bucketing: ");
         print_vector(pos_ptr_of_new_comm, "Pos ptrs: ");
-
     }
 
     g_next.nb_nodes = new_nb_comm;
 
-    renumber.clear();
-
+    cudaEventDestroy(start);
+    cudaEventDestroy(stop);
 }
@@ -0,0 +1,333 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"graphCache.h"
+#include"hostconstants.h"
+#include"logger.h"
+#include"fstream"
+#include"sstream"
+#include"algorithm"
+#include"string.h"
+#include"stdlib.h"
+
+#include<fcntl.h>
+#include<unistd.h>
+#include<dirent.h>
+#include<utime.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+#define CACHE_MAGIC "LVGCACHE"
+#define CACHE_VERSION 1
+#define CACHE_ALIGN 4096
+
+struct CacheHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int weighted;
+    unsigned long long key;
+    unsigned long long nbNodes;
+    unsigned long long nbLinks;
+    double totalWeight;
+    int binSizes[NR_BINS];
+    // byte offsets of the sections, each page aligned
+    unsigned long long degrees, links, weights, wDegs, binOrder, fileSize;
+};
+
+static unsigned long long alignUp(unsigned long long offset) {
+    return (offset + CACHE_ALIGN - 1) & ~(unsigned long long) (CACHE_ALIGN - 1);
+}
+
+// Bin of a vertex with degree neighbors, with the limits of one_levelGaussSeidel
+static int levelZeroBin(unsigned long degree) {
+
+    unsigned long warpLimit = (WARP_TABLE_SIZE_1 * CAPACITY_FACTOR_NUMERATOR / CAPACITY_FACTOR_DENOMINATOR) - 1;
+    unsigned long blkSMemLimit = (SHARED_TABLE_SIZE * CAPACITY_FACTOR_NUMERATOR / CAPACITY_FACTOR_DENOMINATOR) - 1;
+
+    if (degree > blkSMemLimit) return 0;
+    if (degree > warpLimit) return 1;
+    if (degree > 32) return 2;
+    if (degree > 16) return 3;
+    if (degree > 8) return 4;
+    if (degree > 4) return 5;
+    if (degree > 0) return 6;
+    return 7;
+}
+
+void computeLevelZero(const GraphHOST& graph, LevelZeroData& levelZero) {
+
+    unsigned int nbNodes = graph.nb_nodes;
+    levelZero.wDegStore.assign(nbNodes, 0.0);
+
+    std::vector<int> binOf(nbNodes);
+    std::fill(levelZero.binSizes, levelZero.binSizes + NR_BINS, 0);
+
+    for (unsigned int v = 0; v < nbNodes; v++) {
+        unsigned long first = v ? graph.degrees[v - 1] : 0;
+        double wDeg = 0;
+        for (unsigned long e = first; e < graph.degrees[v]; e++)
+            wDeg += graph.weights.size() ? graph.weights[e] : 1.0;
+        levelZero.wDegStore[v] = (float) wDeg;
+
+        binOf[v] = levelZeroBin(graph.degrees[v] - first);
+        levelZero.binSizes[binOf[v]]++;
+    }
+
+    std::vector<int> fill(NR_BINS, 0);
+    for (int b = 1; b < NR_BINS; b++)
+        fill[b] = fill[b - 1] + levelZero.binSizes[b - 1];
+
+    levelZero.binOrderStore.resize(nbNodes);
+    for (unsigned int v = 0; v < nbNodes; v++)
+        levelZero.binOrderStore[fill[binOf[v]]++] = v;
+
+    std::stable_sort(levelZero.binOrderStore.begin(), levelZero.binOrderStore.begin() + levelZero.binSizes[0],
+            [&](int a, int b) {
+                return (graph.degrees[a] - (a ? graph.degrees[a - 1] : 0)) > (graph.degrees[b] - (b ? graph.degrees[b - 1] : 0));
+            });
+
+    levelZero.wDegs = levelZero.wDegStore.data();
+    levelZero.binOrder = levelZero.binOrderStore.data();
+    levelZero.nbNodes = nbNodes;
+    levelZero.mapping.reset();
+}
+
+GraphCache::GraphCache(const std::string& dir, size_t limit) : dir(dir), limit(limit) {
+
+    mkdir(dir.c_str(), 0755);
+}
+
+std::string GraphCache::pathOf(unsigned long long key) const {
+
+    std::stringstream path;
+    path << dir << "/" << std::hex << key << ".lgc";
+    return path.str();
+}
+
+unsigned long long GraphCache::key(const char* filename, const char* filename_w, int type) {
+
+    // FNV-1a over the path, size and modification time of the input files,
+    // the format and the bin limits
+    unsigned long long hash = 14695981039346656037ULL;
+
+    const char* files[2] = {filename, type == WEIGHTED ? filename_w : NULL};
+    for (int f = 0; f < 2; f++) {
+        if (!files[f])
+            continue;
+
+        char* resolved = realpath(files[f], NULL);
+        std::string path = resolved ? resolved : files[f];
+        free(resolved);
+
+        struct stat info;
+        memset(&info, 0, sizeof (info));
+        stat(files[f], &info);
+        unsigned long long stamp[3] = {(unsigned long long) info.st_size,
+            (unsigned long long) info.st_mtim.tv_sec, (unsigned long long) info.st_mtim.tv_nsec};
+
+        for (size_t i = 0; i < path.size(); i++)
+            hash = (hash ^ (unsigned char) path[i]) * 1099511628211ULL;
+        const unsigned char* bytes = (const unsigned char*) stamp;
+        for (unsigned int i = 0; i < sizeof (stamp); i++)
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        hash = (hash ^ 0xff) * 1099511628211ULL;
+    }
+
+    int options[] = {CACHE_VERSION, type, WARP_TABLE_SIZE_1, SHARED_TABLE_SIZE,
+        CAPACITY_FACTOR_NUMERATOR, CAPACITY_FACTOR_DENOMINATOR};
+    const unsigned char* bytes = (const unsigned char*) options;
+    for (unsigned int i = 0; i < sizeof (options); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+    return hash;
+}
+
+bool GraphCache::load(unsigned long long key, GraphHOST& graph, LevelZeroData& levelZero) {
+
+    std::string path = pathOf(key);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof (CacheHeader)) {
+        close(fd);
+        return false;
+    }
+
+    size_t length = info.st_size;
+    void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+
+    // unmapped once neither the graph nor the level-0 data use it
+    std::shared_ptr<const void> mapping(mapped, [length](const void* addr) {
+        munmap((void*) addr, length);
+    });
+
+    const char* base = (const char*) mapped;
+    CacheHeader header;
+    memcpy(&header, base, sizeof (header));
+
+    bool valid = !memcmp(header.magic, CACHE_MAGIC, 8) && header.version == CACHE_VERSION
+            && header.key == key && header.fileSize == (unsigned long long) length;
+
+    if (!valid) {
+        LOG(LOG_WARN, "Graph cache: ignoring damaged entry " << path);
+        return false;
+    }
+
+    graph = GraphHOST();
+    graph.nb_nodes = header.nbNodes;
+    graph.nb_links = header.nbLinks;
+    graph.total_weight = header.totalWeight;
+    graph.mappedDegrees = (const unsigned long*) (base + header.degrees);
+    graph.mappedLinks = (const unsigned int*) (base + header.links);
+    graph.mappedWeights = header.weighted ? (const float*) (base + header.weights) : NULL;
+    graph.mapping = mapping;
+
+    levelZero.wDegStore.clear();
+    levelZero.binOrderStore.clear();
+    levelZero.wDegs = (const float*) (base + header.wDegs);
+    levelZero.binOrder = (const int*) (base + header.binOrder);
+    levelZero.nbNodes = header.nbNodes;
+    std::copy(header.binSizes, header.binSizes + NR_BINS, levelZero.binSizes);
+    levelZero.mapping = mapping;
+
+    // a hit bumps the modification time, the LRU stamp evict() sorts on
+    // (the access time is unreliable on noatime mounts)
+    utime(path.c_str(), NULL);
+
+    return true;
+}
+
+void GraphCache::store(unsigned long long key, const GraphHOST& graph, const LevelZeroData& levelZero) {
+
+    CacheHeader header;
+    memset(&header, 0, sizeof (header));
+    memcpy(header.magic, CACHE_MAGIC, 8);
+    header.version = CACHE_VERSION;
+    header.weighted = graph.weights.size() > 0;
+    header.key = key;
+    header.nbNodes = graph.nb_nodes;
+    header.nbLinks = graph.nb_links;
+    header.totalWeight = graph.total_weight;
+    std::copy(levelZero.binSizes, levelZero.binSizes + NR_BINS, header.binSizes);
+
+    header.degrees = alignUp(sizeof (header));
+    header.links = alignUp(header.degrees + graph.degrees.size() * sizeof (unsigned long));
+    header.weights = alignUp(header.links + graph.links.size() * sizeof (unsigned int));
+    header.wDegs = alignUp(header.weights + graph.weights.size() * sizeof (float));
+    header.binOrder = alignUp(header.wDegs + levelZero.nbNodes * sizeof (float));
+    header.fileSize = header.binOrder + levelZero.nbNodes * sizeof (int);
+
+    if (header.fileSize > limit) {
+        LOG(LOG_INFO, "Graph cache: " << (header.fileSize >> 20) << " MB entry exceeds the limit, not stored");
+        return;
+    }
+
+    // written aside and renamed, so readers never see a partial entry
+    std::string path = pathOf(key);
+    std::string partial = path + ".part";
+    std::ofstream output(partial.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    std::vector<char> padding(CACHE_ALIGN, 0);
+    unsigned long long written = 0;
+    struct Section {
+        unsigned long long offset;
+        const void* data;
+        size_t bytes;
+    } sections[] = {
+        {0, &header, sizeof (header)},
+        {header.degrees, graph.degrees.data(), graph.degrees.size() * sizeof (unsigned long)},
+        {header.links, graph.links.data(), graph.links.size() * sizeof (unsigned int)},
+        {header.weights, graph.weights.data(), graph.weights.size() * sizeof (float)},
+        {header.wDegs, levelZero.wDegs, levelZero.nbNodes * sizeof (float)},
+        {header.binOrder, levelZero.binOrder, levelZero.nbNodes * sizeof (int)}
+    };
+
+    for (unsigned int s = 0; s < sizeof (sections) / sizeof (Section); s++) {
+        output.write(&padding[0], sections[s].offset - written);
+        output.write((const char*) sections[s].data, sections[s].bytes);
+        written = sections[s].offset + sections[s].bytes;
+    }
+    output.close();
+
+    if (!output || rename(partial.c_str(), path.c_str()) != 0) {
+        LOG(LOG_WARN, "Graph cache: could not write " << path);
+        unlink(partial.c_str());
+        return;
+    }
+
+    evict(path);
+}
+
+void GraphCache::evict(const std::string& keep) {
+
+    DIR* entries = opendir(dir.c_str());
+    if (!entries)
+        return;
+
+    std::vector<std::pair<time_t, std::string> > files;
+    size_t total = 0;
+
+    struct dirent* entry;
+    while ((entry = readdir(entries)) != NULL) {
+        std::string name = entry->d_name;
+        if (name.size() < 4 || name.compare(name.size() - 4, 4, ".lgc") != 0)
+            continue;
+        std::string path = dir + "/" + name;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            continue;
+        files.push_back(std::make_pair(info.st_mtime, path));
+        total += info.st_size;
+    }
+    closedir(entries);
+
+    std::sort(files.begin(), files.end());
+
+    for (unsigned int i = 0; i < files.size() && total > limit; i++) {
+        if (files[i].second == keep)
+            continue;
+        struct stat info;
+        if (stat(files[i].second.c_str(), &info) == 0 && unlink(files[i].second.c_str()) == 0) {
+            total -= info.st_size;
+            LOG(LOG_INFO, "Graph cache: evicted " << files[i].second);
+        }
+    }
+}
+
+bool GraphCache::fetch(const char* filename, const char* filename_w, int type,
+        GraphHOST& graph, LevelZeroData& levelZero) {
+
+    unsigned long long contentKey = key(filename, filename_w, type);
+
+    if (load(contentKey, graph, levelZero))
+        return true;
+
+    graph = GraphHOST((char*) filename, (char*) filename_w, type);
+    computeLevelZero(graph, levelZero);
+    store(contentKey, graph, levelZero);
+    return false;
+}
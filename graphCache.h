@@ -0,0 +1,81 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#ifndef GRAPHCACHE_H
+#define	GRAPHCACHE_H
+
+#include"string"
+#include"vector"
+#include"memory"
+#include"graphHOST.h"
+#include"telemetryHOST.h"
+
+// Level-0 work that only depends on the input graph: weighted degrees and
+// the vertices grouped by bin (BlkGMem, BlkSMem, Wrp, leq32, leq16, leq8,
+// leq4, None; BlkGMem by decreasing degree), as one_levelGaussSeidel lays
+// them out in g_next.indices. wDegs and binOrder point into the stores
+// below or, on a cache hit, into the mapped entry; not meant to be copied.
+
+struct LevelZeroData {
+    const float* wDegs;
+    const int* binOrder;
+    unsigned int nbNodes; // 0: no level-0 data
+    int binSizes[NR_BINS];
+
+    std::vector<float> wDegStore;
+    std::vector<int> binOrderStore;
+    std::shared_ptr<const void> mapping;
+
+    LevelZeroData() : wDegs(NULL), binOrder(NULL), nbNodes(0) {
+    }
+};
+
+void computeLevelZero(const GraphHOST& graph, LevelZeroData& levelZero);
+
+// On-disk cache of input graphs with their level-0 data, one page-aligned
+// file per input and bin layout. Entries are keyed on the path, size and
+// modification time of the input files, so a hit does not read the input;
+// a file rewritten in place with the same size and time is not noticed.
+// A hit maps the entry and the graph and level-0 data use it in place.
+// The least recently used entries are evicted beyond the size limit.
+
+struct GraphCache {
+    std::string dir;
+    size_t limit; // bytes
+
+    GraphCache(const std::string& dir, size_t limit);
+
+    static unsigned long long key(const char* filename, const char* filename_w, int type);
+
+    // Loads from the cache or reads the input and stores it; true on a hit
+    bool fetch(const char* filename, const char* filename_w, int type,
+            GraphHOST& graph, LevelZeroData& levelZero);
+
+    bool load(unsigned long long key, GraphHOST& graph, LevelZeroData& levelZero);
+    void store(unsigned long long key, const GraphHOST& graph, const LevelZeroData& levelZero);
+    void evict(const std::string& keep);
+
+private:
+    std::string pathOf(unsigned long long key) const;
+};
+
+#endif	/* GRAPHCACHE_H */
@@ -21,6 +21,7 @@
     */
 
 #include "graphGPU.h"
+#include"logger.h"
 #include"thrust/extrema.h"
 #include"thrust/reduce.h"
 #include"thrust/execution_policy.h"
@@ -191,26 +192,14 @@ void GraphGPU::greedyColoring(unsigned int WARP_SIZE) {
     int nr_of_block = (nb_nodes + load_per_blk - 1) / load_per_blk;
     int size_of_shared_memory = (2 * CHUNK_PER_WARP + 1)*(NR_THREAD_PER_BLOCK / WARP_SIZE) * sizeof (int);
 
-    //print flag
-    int hostPrint = 1;
-
     //determine max degree
     thrust::device_vector<int> degree_per_node(nb_nodes);
     thrust::transform(thrust::device, indices.begin() + 1, indices.end(), indices.begin(),
             degree_per_node.begin(), thrust::minus<int>());
 
-    if (hostPrint) {
-        std::cout << "Degree per Node:" << std::endl;
-        //print_vector(degree_per_node);
-    }
-
-
     int MAX_DEGREE = *thrust::max_element(degree_per_node.begin(), degree_per_node.end());
 
-    if (hostPrint) {
-
-        std::cout << "Max_Degree: " << MAX_DEGREE << std::endl;
-    }
+    LOG(LOG_DEBUG, "Max_Degree: " << MAX_DEGREE);
     // available array to be used locally by each warp
     thrust::device_vector<bool> available;
     available.resize((MAX_DEGREE + 1) * nr_of_block * (NR_THREAD_PER_BLOCK / WARP_SIZE));
@@ -219,12 +208,6 @@ void GraphGPU::greedyColoring(unsigned int WARP_SIZE) {
     thrust::fill_n(thrust::device, colors.begin(), colors.size(), -1);
 
 
-    if (hostPrint) {
-        std::cout << std::endl << "Color:" << std::endl;
-        thrust::copy(colors.begin(), colors.end(), std::ostream_iterator<int>(std::cout, " "));
-        std::cout << std::endl;
-    }
-
     coloringKernel << < nr_of_block, NR_THREAD_PER_BLOCK, size_of_shared_memory >>>
             (thrust::raw_pointer_cast(indices.data()), thrust::raw_pointer_cast(links.data()),
             thrust::raw_pointer_cast(colors.data()), thrust::raw_pointer_cast(available.data()),
@@ -232,9 +215,9 @@ void GraphGPU::greedyColoring(unsigned int WARP_SIZE) {
 
     cudaDeviceSynchronize();
 
-    if (hostPrint) {
-        std::cout << std::endl << "Color:" << std::endl;
-        thrust::copy(colors.begin(), colors.end(), std::ostream_iterator<int>(std::cout, " "));
-        std::cout << std::endl;
+    if (LOG_ENABLED(LOG_TRACE)) {
+        std::ostringstream colorList;
+        thrust::copy(colors.begin(), colors.end(), std::ostream_iterator<int>(colorList, " "));
+        LOG(LOG_TRACE, "Color:\n" << colorList.str());
     }
 }
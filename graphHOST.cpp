@@ -2,6 +2,9 @@
 #include"fstream"
 #include "iostream"
 #include"vector"
+#include"time.h"
+#include"algorithm"
+#include"logger.h"
 using namespace std;
 
 GraphHOST::GraphHOST(char* filename, char* filename_w, int type) {
@@ -39,23 +42,46 @@ GraphHOST::GraphHOST(char* filename, char* filename_w, int type) {
     for (unsigned int i = 0; i < nb_nodes; i++) {
         total_weight += (double) weighted_degree(i);
     }
-    if (type == UNWEIGHTED) {
-        std::cout << std::endl << "UNWEIGHTED" << std::endl;
-    } else {
-        std::cout << std::endl << "WEIGHTED" << std::endl;
-    }
-    std::cout << " total_weight = " << total_weight << std::endl;
+    LOG(LOG_INFO, ((type == UNWEIGHTED) ? "UNWEIGHTED" : "WEIGHTED") << " total_weight = " << total_weight);
+    maxDegree = -1;
+    mappedDegrees = NULL;
+    mappedLinks = NULL;
+    mappedWeights = NULL;
 }
 
 GraphHOST::GraphHOST() {
     nb_nodes = 0;
     nb_links = 0;
     total_weight = 0;
+    maxDegree = -1;
+    mappedDegrees = NULL;
+    mappedLinks = NULL;
+    mappedWeights = NULL;
+}
+
+void
+GraphHOST::materialize() {
+
+    if (!mappedDegrees)
+        return;
+
+    degrees.assign(mappedDegrees, mappedDegrees + nb_nodes);
+    links.assign(mappedLinks, mappedLinks + nb_links);
+    if (mappedWeights)
+        weights.assign(mappedWeights, mappedWeights + nb_links);
+    else
+        weights.clear();
+
+    mappedDegrees = NULL;
+    mappedLinks = NULL;
+    mappedWeights = NULL;
+    mapping.reset();
 }
 
 void
 GraphHOST::display() {
 
+    materialize();
 
 
     for (unsigned int node = 0; node < nb_nodes; node++) {
@@ -68,16 +94,203 @@ GraphHOST::display() {
          if (node == 34693)
              cout << "node: " << node << " : nr_neighbor: " << nb_neighbors(node) << endl;
          */
-        cout << node << " : ";
+        ostringstream line;
+        line << node << " : ";
         for (unsigned int i = 0; i < nb_neighbors(node); i++) {
             if (true) {
                 if (weights.size() != 0)
-                    cout << " (" << *(p.first + i) << " " << *(p.second + i) << ")";
+                    line << " (" << *(p.first + i) << " " << *(p.second + i) << ")";
                 else
-                    cout << " " << *(p.first + i);
+                    line << " " << *(p.first + i);
             }
         }
-        cout << endl;
+        LOG(LOG_TRACE, line.str());
+
+    }
+}
+
+void
+GraphHOST::placeOnNumaNodes(const NumaTopology& topo) {
+
+    materialize();
+    nodeRanges = partitionByLinks(degrees, topo.nrNodes);
+
+    int nrBound = 0;
+    for (int node = 0; node < topo.nrNodes; node++) {
+
+        unsigned int first = nodeRanges[node], last = nodeRanges[node + 1];
+        if (first == last)
+            continue;
+
+        unsigned long firstLink = first ? degrees[first - 1] : 0;
+        unsigned long lastLink = degrees[last - 1];
+
+        nrBound += bindToNode(&degrees[first], (last - first) * sizeof (unsigned long), node);
+        nrBound += bindToNode(&links[firstLink], (lastLink - firstLink) * sizeof (unsigned int), node);
+        if (weights.size())
+            nrBound += bindToNode(&weights[firstLink], (lastLink - firstLink) * sizeof (float), node);
+    }
+
+    LOG(LOG_INFO, "Placed CSR on " << topo.nrNodes << " NUMA node(s), #bound ranges: " << nrBound);
+}
+
+void
+GraphHOST::reportLocality(const NumaTopology& topo) {
+
+    materialize();
+    std::vector<unsigned int> ranges = nodeRanges.size() ? nodeRanges : partitionByLinks(degrees, topo.nrNodes);
+
+    for (int node = 0; node < topo.nrNodes; node++) {
+
+        unsigned int first = ranges[node], last = ranges[node + 1];
+        if (first == last)
+            continue;
+
+        unsigned long firstLink = first ? degrees[first - 1] : 0;
+        unsigned long lastLink = degrees[last - 1];
+
+        std::ostringstream line;
+        line << "node " << node << " vertices [" << first << ", " << last << ")"
+                << " local(degrees): " << localPageRatio(&degrees[first], (last - first) * sizeof (unsigned long), node)
+                << " local(links): " << localPageRatio(&links[firstLink], (lastLink - firstLink) * sizeof (unsigned int), node);
+        if (weights.size())
+            line << " local(weights): " << localPageRatio(&weights[firstLink], (lastLink - firstLink) * sizeof (float), node);
+        LOG(LOG_SUMMARY, line.str());
+    }
+}
+
+void
+GraphHOST::benchmarkNumaScaling(const NumaTopology& topo, int maxWorkers) {
+
+    if (!nb_nodes)
+        return;
+
+    materialize();
+    std::vector<float> wDegs(nb_nodes);
+    for (unsigned int node = 0; node < nb_nodes; node++)
+        wDegs[node] = weighted_degree(node);
+
+    NumaReplica<float> replica;
+    replica.create(topo, &wDegs[0], nb_nodes);
+
+    std::vector<double> sums(maxWorkers);
+
+    LOG(LOG_SUMMARY, "#workers, time(single copy), time(replicated), speedup(replicated), local(wDegs)");
+
+    // 1, 2, 4, ... and finally all workers (spanning all sockets)
+    std::vector<int> nrWorkerList;
+    for (int n = 1; n < maxWorkers; n *= 2)
+        nrWorkerList.push_back(n);
+    nrWorkerList.push_back(maxWorkers);
+
+    double baseTime = 0;
+    for (size_t run = 0; run < nrWorkerList.size(); run++) {
+
+        int nrWorkers = nrWorkerList[run];
+        std::vector<unsigned int> bounds = partitionByLinks(degrees, nrWorkers);
+        double elapsed[2];
+
+        for (int replicated = 0; replicated < 2; replicated++) {
+
+            struct timespec begin, end;
+            clock_gettime(CLOCK_MONOTONIC, &begin);
+
+            runPinned(topo, nrWorkers, [&](int w) {
+                const float* wDegOf = replicated ? replica.of(topo.nodeOfWorker(w, nrWorkers)) : &wDegs[0];
+                double sum = 0;
+                for (unsigned int v = bounds[w]; v < bounds[w + 1]; v++) {
+                    unsigned long first = v ? degrees[v - 1] : 0;
+                    for (unsigned long e = first; e < degrees[v]; e++)
+                        sum += wDegOf[links[e]];
+                }
+                sums[w] = sum;
+            });
+
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            elapsed[replicated] = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1.0e9;
+        }
 
+        if (nrWorkers == 1)
+            baseTime = elapsed[1];
+
+        double ratio = 0;
+        for (int node = 0; node < topo.nrNodes; node++)
+            ratio += localPageRatio(replica.of(node), nb_nodes * sizeof (float), node);
+
+        LOG(LOG_SUMMARY, nrWorkers << ", " << elapsed[0] << ", " << elapsed[1] << ", "
+                << baseTime / elapsed[1] << ", " << ratio / topo.nrNodes);
     }
 }
+
+double
+GraphHOST::modularity(const std::vector<int>& n2c) const {
+
+    assert(n2c.size() == nb_nodes);
+
+    int nrComm = 0;
+    for (unsigned int node = 0; node < nb_nodes; node++)
+        nrComm = std::max(nrComm, n2c[node] + 1);
+
+    std::vector<double> in(nrComm, 0.0), tot(nrComm, 0.0);
+    const unsigned long* cumDegree = degreeData();
+    const unsigned int* adjacent = linkData();
+    const float* linkWeights = weightData();
+
+    for (unsigned int node = 0; node < nb_nodes; node++) {
+        unsigned long first = node ? cumDegree[node - 1] : 0;
+        for (unsigned long e = first; e < cumDegree[node]; e++) {
+            double w = linkWeights ? (double) linkWeights[e] : 1.0;
+            tot[n2c[node]] += w;
+            if (n2c[adjacent[e]] == n2c[node])
+                in[n2c[node]] += w;
+        }
+    }
+
+    double q = 0., m2 = total_weight;
+    for (int c = 0; c < nrComm; c++) {
+        if (tot[c] > 0)
+            q += in[c] / m2 - (tot[c] / m2)*(tot[c] / m2);
+    }
+    return q;
+}
+
+void
+GraphHOST::inducedSubgraph(const int* members, int nrMembers, const std::vector<int>& n2c,
+        const std::vector<int>& localId, GraphHOST& sub) const {
+
+    sub.nb_nodes = nrMembers;
+    sub.degrees.assign(nrMembers, 0);
+    sub.links.clear();
+    sub.weights.clear();
+    sub.total_weight = 0;
+
+    if (!nrMembers)
+        return;
+
+    int comm = n2c[members[0]];
+    const unsigned long* cumDegree = degreeData();
+    const unsigned int* adjacent = linkData();
+    const float* linkWeights = weightData();
+
+    for (int i = 0; i < nrMembers; i++) {
+
+        unsigned int node = members[i];
+        assert(localId[node] == i);
+
+        unsigned long first = node ? cumDegree[node - 1] : 0;
+        for (unsigned long e = first; e < cumDegree[node]; e++) {
+            if (n2c[adjacent[e]] != comm)
+                continue;
+            sub.links.push_back(localId[adjacent[e]]);
+            if (linkWeights) {
+                sub.weights.push_back(linkWeights[e]);
+                sub.total_weight += linkWeights[e];
+            } else {
+                sub.total_weight += 1.0;
+            }
+        }
+        sub.degrees[i] = sub.links.size();
+    }
+
+    sub.nb_links = sub.links.size();
+}
@@ -6,6 +6,8 @@
 #include"vector"
 #include"assert.h"
 #include"commonconstants.h"
+#include"numaHOST.h"
+#include"memory"
 class GraphHOST {
 public:
     unsigned int nb_nodes;
@@ -21,10 +23,49 @@ public:
     std::vector<unsigned int> links;
     std::vector<float> weights;
 
+    // A graph cache hit (graphCache.h) leaves the CSR in the mapped entry;
+    // these point into it and the vectors above stay empty. Code reading
+    // the CSR goes through degreeData() and co, which serve both cases;
+    // materialize() copies the entry for code that needs the vectors.
+    const unsigned long* mappedDegrees;
+    const unsigned int* mappedLinks;
+    const float* mappedWeights; // NULL if unweighted
+    std::shared_ptr<const void> mapping;
+
+    // Vertex range [nodeRanges[i], nodeRanges[i+1]) lives on NUMA node i;
+    // empty unless placeOnNumaNodes() was called
+    std::vector<unsigned int> nodeRanges;
+
+    // Degree statistics; maxDegree < 0 until a loader computed them
+    long maxDegree;
+    double avgDegree, stdDegree;
+
     GraphHOST();
 
     GraphHOST(char *filename, char *filename_w, int type);
 
+    // Reads the file in chunks on the calling thread while nrWorkers threads
+    // validate the chunks already read (ids < nb_nodes, non-decreasing
+    // degrees, symmetry) and compute total_weight and the degree statistics.
+    // Reports the achieved bandwidth next to that of the reads alone;
+    // returns false if the graph is invalid.
+    bool loadPipelined(const char* filename, const char* filename_w, int type, int nrWorkers);
+
+    const unsigned long* degreeData() const {
+        return mappedDegrees ? mappedDegrees : degrees.data();
+    }
+
+    const unsigned int* linkData() const {
+        return mappedDegrees ? mappedLinks : links.data();
+    }
+
+    // NULL if unweighted
+    const float* weightData() const {
+        return mappedDegrees ? mappedWeights : (weights.size() ? weights.data() : NULL);
+    }
+
+    void materialize();
+
     // return the weighted degree of the node
     inline double weighted_degree(unsigned int node);
 
@@ -36,6 +77,25 @@ public:
 
     void display();
 
+    // Modularity of a partition given as community id per vertex
+    double modularity(const std::vector<int>& n2c) const;
+
+    // Subgraph induced by members (all in community comm of n2c); vertex
+    // members[i] becomes vertex localId[members[i]] of sub
+    void inducedSubgraph(const int* members, int nrMembers, const std::vector<int>& n2c,
+            const std::vector<int>& localId, GraphHOST& sub) const;
+
+    // Move the CSR of each vertex range (balanced by #links) to its own
+    // node; only pays off for host reads of the CSR, not for a device copy
+    void placeOnNumaNodes(const NumaTopology& topo);
+
+    // Print fraction of pages of each range that are on the expected node
+    void reportLocality(const NumaTopology& topo);
+
+    // Pinned CSR sweeps with 1..maxWorkers threads reading wDegs of neighbors,
+    // once from a single copy and once from per-node replicas
+    void benchmarkNumaScaling(const NumaTopology& topo, int maxWorkers);
+
 };
 
 inline unsigned int
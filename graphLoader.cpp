@@ -0,0 +1,247 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"graphHOST.h"
+#include"hostconstants.h"
+#include"logger.h"
+#include"fstream"
+#include"deque"
+#include"mutex"
+#include"condition_variable"
+#include"thread"
+#include"algorithm"
+#include"cmath"
+#include"time.h"
+
+// Sections of the input in file order
+#define SECTION_DEGREES 0
+#define SECTION_LINKS 1
+#define SECTION_WEIGHTS 2
+
+struct LoadChunk {
+    int id;
+    int section;
+    unsigned long first, last; // element range
+};
+
+// Partial results of one chunk; summed in chunk order so that the totals
+// don't depend on which worker took which chunk
+struct ChunkResult {
+    int id;
+    long maxDegree;
+    double sumDegree, sumSquareDegree;
+    double weight;
+    unsigned long nrInvalid;
+    unsigned long long forward, backward; // hashes of (u,v) and (v,u)
+};
+
+static unsigned long long mixLink(unsigned long long u, unsigned long long v) {
+
+    unsigned long long x = (u << 32) ^ v;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static double secondsSince(const struct timespec& begin) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - begin.tv_sec) + (now.tv_nsec - begin.tv_nsec) / 1.0e9;
+}
+
+bool GraphHOST::loadPipelined(const char* filename, const char* filename_w, int type, int nrWorkers) {
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    std::deque<LoadChunk> queue;
+    std::vector<ChunkResult> results;
+    std::mutex lock;
+    std::condition_variable ready;
+    bool allRead = false;
+
+    auto work = [&]() {
+        while (true) {
+            LoadChunk chunk;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                ready.wait(guard, [&]() {
+                    return queue.size() || allRead;
+                });
+                if (!queue.size())
+                    return;
+                chunk = queue.front();
+                queue.pop_front();
+            }
+
+            ChunkResult result = {chunk.id, 0, 0, 0, 0, 0, 0, 0};
+
+            if (chunk.section == SECTION_DEGREES) {
+                for (unsigned long v = chunk.first; v < chunk.last; v++) {
+                    unsigned long previous = v ? degrees[v - 1] : 0;
+                    if (degrees[v] < previous) {
+                        result.nrInvalid++;
+                        continue;
+                    }
+                    long degree = degrees[v] - previous;
+                    result.maxDegree = std::max(result.maxDegree, degree);
+                    result.sumDegree += degree;
+                    result.sumSquareDegree += (double) degree * degree;
+                }
+            } else if (chunk.section == SECTION_LINKS) {
+                // source of the first link of the chunk
+                unsigned long u = std::upper_bound(degrees.begin(), degrees.end(), chunk.first) - degrees.begin();
+                for (unsigned long e = chunk.first; e < chunk.last; e++) {
+                    while (degrees[u] <= e)
+                        u++;
+                    if (links[e] >= nb_nodes) {
+                        result.nrInvalid++;
+                        continue;
+                    }
+                    result.forward += mixLink(u, links[e]);
+                    result.backward += mixLink(links[e], u);
+                }
+            } else {
+                for (unsigned long e = chunk.first; e < chunk.last; e++) {
+                    if (!std::isfinite(weights[e]))
+                        result.nrInvalid++;
+                    else
+                        result.weight += weights[e];
+                }
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            results.push_back(result);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < std::max(1, nrWorkers); w++)
+        workers.push_back(std::thread(work));
+
+    // I/O: each chunk is read straight into its final place and handed over
+    double readSeconds = 0, bytesRead = 0;
+    int nrChunks = 0;
+    bool readFailed = false;
+
+    auto readSection = [&](std::ifstream& input, int section, char* data, size_t elementSize, unsigned long nrElements) {
+        unsigned long perChunk = std::max((unsigned long) 1, ((unsigned long) GRAPH_LOAD_CHUNK_MB << 20) / elementSize);
+        for (unsigned long first = 0; first < nrElements && !readFailed; first += perChunk) {
+            unsigned long last = std::min(nrElements, first + perChunk);
+
+            struct timespec readBegin;
+            clock_gettime(CLOCK_MONOTONIC, &readBegin);
+            input.read(data + first * elementSize, (last - first) * elementSize);
+            readSeconds += secondsSince(readBegin);
+
+            if (!input) {
+                readFailed = true;
+                break;
+            }
+            bytesRead += (last - first) * elementSize;
+
+            LoadChunk chunk = {nrChunks++, section, first, last};
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                queue.push_back(chunk);
+            }
+            ready.notify_one();
+        }
+    };
+
+    std::ifstream finput(filename, std::fstream::in | std::fstream::binary);
+    nb_nodes = 0;
+    finput.read((char *) &nb_nodes, 4);
+    readFailed = !finput || !nb_nodes;
+
+    if (!readFailed) {
+        degrees.resize(nb_nodes);
+        readSection(finput, SECTION_DEGREES, (char *) &degrees[0], sizeof (unsigned long), nb_nodes);
+    }
+
+    // the link chunks need all of the degrees, which are read by now
+    nb_links = readFailed ? 0 : degrees[nb_nodes - 1];
+    links.resize(nb_links);
+    if (!readFailed && nb_links)
+        readSection(finput, SECTION_LINKS, (char *) &links[0], sizeof (unsigned int), nb_links);
+
+    weights.resize(0);
+    if (type == WEIGHTED && !readFailed && nb_links) {
+        std::ifstream finput_w(filename_w, std::fstream::in | std::fstream::binary);
+        weights.resize(nb_links);
+        readSection(finput_w, SECTION_WEIGHTS, (char *) &weights[0], sizeof (float), nb_links);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        allRead = true;
+    }
+    ready.notify_all();
+    for (unsigned int w = 0; w < workers.size(); w++)
+        workers[w].join();
+
+    std::sort(results.begin(), results.end(), [](const ChunkResult& a, const ChunkResult& b) {
+        return a.id < b.id;
+    });
+
+    double sumDegree = 0, sumSquareDegree = 0, weightSum = 0;
+    unsigned long nrInvalid = 0;
+    unsigned long long forward = 0, backward = 0;
+    maxDegree = 0;
+    for (unsigned int i = 0; i < results.size(); i++) {
+        maxDegree = std::max(maxDegree, results[i].maxDegree);
+        sumDegree += results[i].sumDegree;
+        sumSquareDegree += results[i].sumSquareDegree;
+        weightSum += results[i].weight;
+        nrInvalid += results[i].nrInvalid;
+        forward += results[i].forward;
+        backward += results[i].backward;
+    }
+
+    total_weight = (type == WEIGHTED) ? weightSum : (double) nb_links;
+    avgDegree = nb_nodes ? sumDegree / nb_nodes : 0;
+    stdDegree = nb_nodes ? sqrt(std::max(0.0, sumSquareDegree / nb_nodes - avgDegree * avgDegree)) : 0;
+
+    double seconds = secondsSince(begin);
+    LOG(LOG_INFO, ((type == UNWEIGHTED) ? "UNWEIGHTED" : "WEIGHTED") << " total_weight = " << total_weight);
+    LOG(LOG_SUMMARY, "Loaded " << bytesRead / 1.0e9 << " GB in " << nrChunks << " chunks, " << seconds << " sec: "
+            << (seconds > 0 ? bytesRead / 1.0e9 / seconds : 0) << " GB/s (reads alone "
+            << (readSeconds > 0 ? bytesRead / 1.0e9 / readSeconds : 0) << " GB/s)");
+
+    if (readFailed) {
+        LOG(LOG_ERROR, "Could not read " << filename << (type == WEIGHTED ? " or its weights" : ""));
+        return false;
+    }
+    if (nrInvalid) {
+        LOG(LOG_ERROR, filename << ": " << nrInvalid << " invalid entries (neighbor ids >= #nodes, "
+                << "decreasing cumulative degrees or non-finite weights)");
+        return false;
+    }
+    if (forward != backward)
+        LOG(LOG_WARN, filename << ": adjacency lists are not symmetric");
+
+    return true;
+}
@@ -0,0 +1,285 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+// Replays the neighborhoods of a graph through the same open-addressing
+// code the kernels use (openaddressing.h, host build) and reports probe
+// length and load per table class, for the table sizes used on the GPU or
+// for tables sized to a given target load factor in (0,1). Each row is
+// labeled with the load that was actually reached.
+//
+// --simd compares the move-phase decision of hashInsertGPU (host build, GPU
+// table sizes) with the SoA table of hashTableHOST.h and its SIMD gain
+// evaluation, for the first sweep of the first level (n2c = identity).
+//
+// usage: hashBench graph.bin [weight.bin] [--load=F1,F2,..] [--repeat=R] [--simd]
+
+#include"graphHOST.h"
+#include"hostconstants.h"
+#include"openaddressing.h"
+#include"hashstats.h"
+#include"hashTableHOST.h"
+#include"logger.h"
+
+#include"iostream"
+#include"sstream"
+#include"fstream"
+#include"string"
+#include"vector"
+#include"stdlib.h"
+#include"time.h"
+
+static unsigned int nextPrime(unsigned int n) {
+
+    for (n = (n < 2) ? 2 : n;; n++) {
+        bool isPrime = true;
+        for (unsigned int d = 2; d * d <= n && isPrime; d++)
+            isPrime = (n % d) != 0;
+        if (isPrime)
+            return n;
+    }
+}
+
+// Table size the move phase uses for a vertex with nrNeighbor neighbors
+static unsigned int gpuBucketSize(unsigned int nrNeighbor) {
+
+    int warpLimit = (WARP_TABLE_SIZE_1 * CAPACITY_FACTOR_NUMERATOR / CAPACITY_FACTOR_DENOMINATOR) - 1;
+    int blkSMemLimit = (SHARED_TABLE_SIZE * CAPACITY_FACTOR_NUMERATOR / CAPACITY_FACTOR_DENOMINATOR) - 1;
+
+    if (nrNeighbor <= 4) return 7;
+    if (nrNeighbor <= 8) return 17;
+    if (nrNeighbor <= 16) return 31;
+    if (nrNeighbor <= 32) return 61;
+    if ((int) nrNeighbor <= warpLimit) return WARP_TABLE_SIZE_1;
+    if ((int) nrNeighbor <= blkSMemLimit) return SHARED_TABLE_SIZE;
+    return nextPrime((nrNeighbor * 3) / 2);
+}
+
+// Fills one table per vertex with the communities of its neighbors and its
+// own (n2c = identity as in the first sweep); load <= 0 means GPU sizes
+static double replay(GraphHOST& g, double load, int nrRepeat, HashProbeStats& stats) {
+
+    std::vector<HashItem> table;
+    unsigned int nrAttempt = 0;
+    struct timespec t0, t1;
+
+    clearHashProbeStats(h_hashStats);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (int r = 0; r < nrRepeat; r++) {
+        for (unsigned int node = 0; node < g.nb_nodes; node++) {
+
+            unsigned int nrNeighbor = g.nb_neighbors(node);
+            if (!nrNeighbor)
+                continue;
+
+            unsigned int bucketSize = (load > 0) ?
+                    nextPrime((unsigned int) ((nrNeighbor + 1) / load) + 1) : gpuBucketSize(nrNeighbor);
+
+            if (table.size() < bucketSize)
+                table.resize(bucketSize);
+            for (unsigned int i = 0; i < bucketSize; i++) {
+                table[i].cId = FLAG_FREE;
+                table[i].gravity = 0.0;
+            }
+
+            std::pair<std::vector<unsigned int>::iterator, std::vector<float>::iterator> p = g.neighbors(node);
+            HashItem item;
+            int nrOccupied = 0;
+
+            for (unsigned int j = 0; j <= nrNeighbor; j++) {
+                item.cId = (j < nrNeighbor) ? *(p.first + j) : node;
+                item.gravity = (j < nrNeighbor && g.weights.size()) ? *(p.second + j) : 1.0;
+                nrOccupied += (hashInsertSimple(&table[0], bucketSize, &item) == (int) bucketSize);
+            }
+
+            item.cId = node;
+            hashSearchGPU(&table[0], &nrAttempt, bucketSize, &item);
+            HASH_STAT_LOAD(bucketSize, nrOccupied);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    stats = h_hashStats;
+
+    return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+// Best destination of every vertex through hashInsertGPU or, if simd, through
+// NeighborTableHOST; returns seconds
+static double replayMove(GraphHOST& g, bool simd, int nrRepeat, std::vector<int>& bestDest) {
+
+    std::vector<float> tot(g.nb_nodes);
+    for (unsigned int node = 0; node < g.nb_nodes; node++)
+        tot[node] = (float) g.weighted_degree(node);
+    float m2 = (float) g.total_weight;
+
+    std::vector<HashItem> table;
+    NeighborTableHOST simdTable;
+    unsigned int nrAttempt = 0;
+    struct timespec t0, t1;
+
+    bestDest.assign(g.nb_nodes, -1);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (int r = 0; r < nrRepeat; r++) {
+        for (unsigned int node = 0; node < g.nb_nodes; node++) {
+
+            unsigned int nrNeighbor = g.nb_neighbors(node);
+            if (!nrNeighbor)
+                continue;
+
+            std::pair<std::vector<unsigned int>::iterator, std::vector<float>::iterator> p = g.neighbors(node);
+            float wDeg = tot[node];
+            float bestGain = 0.0;
+            int dest = -1;
+
+            if (simd) {
+                simdTable.reset(nrNeighbor + 1);
+                for (unsigned int j = 0; j < nrNeighbor; j++)
+                    simdTable.insert(*(p.first + j), g.weights.size() ? *(p.second + j) : 1.0);
+                simdTable.insert(node, 0.0);
+                dest = simdTable.bestDestination(&tot[0], wDeg, m2, node, &bestGain);
+            } else {
+                unsigned int bucketSize = gpuBucketSize(nrNeighbor);
+                if (table.size() < bucketSize)
+                    table.resize(bucketSize);
+                for (unsigned int i = 0; i < bucketSize; i++) {
+                    table[i].cId = FLAG_FREE;
+                    table[i].gravity = 0.0;
+                }
+
+                HashItem item;
+                for (unsigned int j = 0; j <= nrNeighbor; j++) {
+                    item.cId = (j < nrNeighbor) ? *(p.first + j) : node;
+                    item.gravity = (j == nrNeighbor) ? 0.0 : (g.weights.size() ? *(p.second + j) : 1.0);
+                    hashInsertGPU(&table[0], &nrAttempt, bucketSize, &item, &tot[0], wDeg, m2, &bestGain, &dest, node);
+                }
+            }
+            bestDest[node] = dest;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+int main(int argc, char** argv) {
+
+    std::vector<char*> positionalArgs(1, argv[0]);
+    std::vector<double> loads(1, 0.0);
+    int nrRepeat = 1;
+    bool compareSimd = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 7, "--load=") == 0) {
+            std::stringstream ss(arg.substr(7));
+            std::string f;
+            while (std::getline(ss, f, ',')) {
+                double load = atof(f.c_str());
+                // a full table fails inserts and never ends a miss
+                if (load <= 0 || load >= 1) {
+                    LOG(LOG_ERROR, "--load: " << f << " is not in (0,1)");
+                    return 1;
+                }
+                loads.push_back(load);
+            }
+        } else if (arg.compare(0, 9, "--repeat=") == 0) {
+            nrRepeat = std::max(1, atoi(arg.c_str() + 9));
+        } else if (arg == "--simd") {
+            compareSimd = true;
+        } else {
+            positionalArgs.push_back(argv[i]);
+        }
+    }
+
+    if (positionalArgs.size() < 2) {
+        LOG(LOG_ERROR, "usage: " << argv[0] << " graph.bin [weight.bin] [--load=F1,F2,..] [--repeat=R] [--simd]");
+        return 1;
+    }
+
+    char* file_w = (positionalArgs.size() > 2) ? positionalArgs[2] : NULL;
+    GraphHOST g(positionalArgs[1], file_w, file_w ? WEIGHTED : UNWEIGHTED);
+
+    LOG(LOG_SUMMARY, "#nodes: " << g.nb_nodes << " #links: " << g.nb_links);
+
+    for (unsigned int c = 0; c < loads.size(); c++) {
+
+        HashProbeStats stats;
+        double seconds = replay(g, loads[c], nrRepeat, stats);
+
+        unsigned long long nrInserts = 0, nrOccupied = 0, nrSlots = 0;
+        for (int tc = 0; tc < NR_TABLE_CLASSES; tc++) {
+            nrInserts += stats.nrInserts[tc];
+            nrOccupied += stats.nrOccupied[tc];
+            nrSlots += stats.nrSlots[tc];
+        }
+
+        // the prime rounding and repeated neighbors keep the measured load
+        // below the target
+        std::stringstream label;
+        if (loads[c] > 0)
+            label << "load " << loads[c];
+        else
+            label << "gpu sizes";
+        label << " (measured " << (nrSlots ? (double) nrOccupied / nrSlots : 0.0) << ")";
+
+        printHashProbeStats(stats, label.str().c_str());
+        LOG(LOG_SUMMARY, "  time: " << seconds << " s, " << (nrInserts ? 1e9 * seconds / nrInserts : 0.0) << " ns/insert");
+
+        appendHashProbeStats(stats, "Log/louvain_method_gpu_hash_bench.csv", 0, label.str().c_str());
+    }
+
+    if (compareSimd) {
+
+        std::vector<int> scalarDest, simdDest;
+        double scalarSeconds = replayMove(g, false, nrRepeat, scalarDest);
+        double simdSeconds = replayMove(g, true, nrRepeat, simdDest);
+
+        // The GPU code computes gains in double, the SIMD table in float
+        unsigned int nrAgree = 0;
+        for (unsigned int node = 0; node < g.nb_nodes; node++)
+            nrAgree += (scalarDest[node] == simdDest[node]);
+
+        double nrVisited = (double) g.nb_nodes * nrRepeat;
+        double agreement = g.nb_nodes ? 100.0 * nrAgree / g.nb_nodes : 100.0;
+
+        LOG(LOG_SUMMARY, "move decision: hashInsertGPU " << 1e9 * scalarSeconds / nrVisited << " ns/vertex, "
+                << "SoA table (group " << HOST_TABLE_GROUP << ") " << 1e9 * simdSeconds / nrVisited << " ns/vertex, "
+                << "speedup " << (simdSeconds > 0 ? scalarSeconds / simdSeconds : 0.0)
+                << ", same destination " << agreement << "%");
+
+        std::string logName = "Log/louvain_method_gpu_hash_simd.csv";
+        std::ifstream infile(logName.c_str());
+        bool existing = infile.good();
+        std::ofstream log(logName.c_str(), std::ios_base::out | std::ios_base::app);
+        if (!existing)
+            log << "GraphName,Group,hashInsertGPU(ns/vertex),SoA(ns/vertex),Speedup,Agreement(%)" << std::endl;
+        log << positionalArgs[1] << "," << HOST_TABLE_GROUP << "," << 1e9 * scalarSeconds / nrVisited << ","
+                << 1e9 * simdSeconds / nrVisited << "," << (simdSeconds > 0 ? scalarSeconds / simdSeconds : 0.0) << ","
+                << agreement << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,249 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#ifndef HASHTABLEHOST_H
+#define	HASHTABLEHOST_H
+
+#include"devconstants.h"
+#include"hashstats.h"
+#include"vector"
+#include"string.h"
+#include"stdint.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include<immintrin.h>
+#endif
+
+// Neighbor-community table for the host. Keys (cId + 1, FLAG_FREE when
+// unused) and gravities live in separate arrays; the capacity is a power of
+// two and the home slot comes from multiplicative hashing, so a probe costs
+// a multiply and a shift instead of a division by a prime.
+//
+// Slots are probed a group of HOST_TABLE_GROUP keys at a time (16 with
+// AVX-512, 8 with AVX2 or in the scalar fallback). A key is stored in the
+// first group, from its home group on, that has a free slot; nothing is
+// ever removed, so a lookup can stop at the first group with a free slot.
+//
+// Benchmark-only prototype: hashBench --simd measures it against the
+// kernels' table code. LouvainHOST keeps its dense neighWeight array, which
+// needs no probing at all; the table is meant for a host engine whose
+// levels are too large for one dense array per thread.
+
+#if defined(__AVX512F__)
+#define HOST_TABLE_GROUP 16
+#else
+#define HOST_TABLE_GROUP 8
+#endif
+
+struct NeighborTableHOST {
+    std::vector<int> keys;
+    std::vector<float> gravities;
+    unsigned int capacity; // power of two, at least HOST_TABLE_GROUP
+    unsigned int shift; // 32 - log2(capacity)
+    unsigned int nrOccupied;
+
+    NeighborTableHOST() : capacity(0), shift(32), nrOccupied(0) {
+    }
+
+    // Empty table for up to nrKeys keys, at most half full
+    void reset(unsigned int nrKeys) {
+
+        capacity = HOST_TABLE_GROUP;
+        shift = 32;
+        for (unsigned int c = 1; c < HOST_TABLE_GROUP; c <<= 1)
+            shift--;
+        while (capacity < 2 * nrKeys) {
+            capacity <<= 1;
+            shift--;
+        }
+
+        if (keys.size() < capacity) {
+            keys.resize(capacity);
+            gravities.resize(capacity);
+        }
+        memset(&keys[0], 0, capacity * sizeof (int));
+        memset(&gravities[0], 0, capacity * sizeof (float));
+        nrOccupied = 0;
+    }
+
+    // First slot of the group holding the home slot of key
+    unsigned int homeGroup(int key) const {
+        return (((uint32_t) key * 2654435769u) >> shift) & ~(HOST_TABLE_GROUP - 1);
+    }
+
+    // Bit i is set if keys[group + i] == key
+    unsigned int matchGroup(unsigned int group, int key) const {
+
+#if defined(__AVX512F__)
+        __m512i k = _mm512_loadu_si512((const void*) &keys[group]);
+        return _mm512_cmpeq_epi32_mask(k, _mm512_set1_epi32(key));
+#elif defined(__AVX2__)
+        __m256i k = _mm256_loadu_si256((const __m256i*) &keys[group]);
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(k, _mm256_set1_epi32(key))));
+#else
+        unsigned int mask = 0;
+        for (int i = 0; i < HOST_TABLE_GROUP; i++)
+            mask |= (unsigned int) (keys[group + i] == key) << i;
+        return mask;
+#endif
+    }
+
+    // Adds gravity to community cId; returns its slot, -1 if the table is full
+    int insert(int cId, float gravity) {
+
+        int key = cId + 1;
+        unsigned int group = homeGroup(key);
+
+        for (unsigned int nrGroup = 1; nrGroup * HOST_TABLE_GROUP <= capacity; nrGroup++) {
+
+            unsigned int mask = matchGroup(group, key);
+            if (mask) {
+                unsigned int slot = group + __builtin_ctz(mask);
+                gravities[slot] += gravity;
+                HASH_STAT_INSERT(capacity, nrGroup);
+                return (int) slot;
+            }
+
+            mask = matchGroup(group, FLAG_FREE);
+            if (mask) {
+                unsigned int slot = group + __builtin_ctz(mask);
+                keys[slot] = key;
+                gravities[slot] = gravity;
+                nrOccupied++;
+                HASH_STAT_INSERT(capacity, nrGroup);
+                return (int) slot;
+            }
+            group = (group + HOST_TABLE_GROUP) & (capacity - 1);
+        }
+        HASH_STAT_INSERT(capacity, -1);
+        return -1;
+    }
+
+    // Slot of community cId, -1 if absent
+    int find(int cId) const {
+
+        int key = cId + 1;
+        unsigned int group = homeGroup(key);
+
+        for (unsigned int nrGroup = 1; nrGroup * HOST_TABLE_GROUP <= capacity; nrGroup++) {
+
+            unsigned int mask = matchGroup(group, key);
+            if (mask) {
+                HASH_STAT_SEARCH(capacity, nrGroup);
+                return (int) (group + __builtin_ctz(mask));
+            }
+            if (matchGroup(group, FLAG_FREE)) {
+                HASH_STAT_SEARCH(capacity, nrGroup);
+                return -1;
+            }
+            group = (group + HOST_TABLE_GROUP) & (capacity - 1);
+        }
+        return -1;
+    }
+
+    // Best destination for a vertex of weighted degree wDeg in community sCId
+    // using the gain of hashInsertGPU,
+    //   2 * gravity - 2 * wDeg * (tot[c] - tot[sCId] + wDeg) / m2   (0 for sCId),
+    // evaluated over all slots at once. As on the GPU only a positive gain
+    // makes a destination and ties go to the smaller community id.
+    // Returns -1 if no community has a positive gain.
+    int bestDestination(const float* tot, float wDeg, float m2, int sCId, float* bestGain) const {
+
+        float scale = 2.0f * wDeg / m2;
+        float base = tot[sCId] - wDeg;
+        float gain = 0.0f;
+        int dest = -1;
+        unsigned int slot = 0;
+
+#if defined(__AVX512F__)
+        __m512 vBest = _mm512_setzero_ps();
+        __m512i vDest = _mm512_set1_epi32(-1);
+        for (; slot < capacity; slot += 16) {
+            __m512i k = _mm512_loadu_si512((const void*) &keys[slot]);
+            __mmask16 occupied = _mm512_cmpneq_epi32_mask(k, _mm512_setzero_si512())
+                    & _mm512_cmpneq_epi32_mask(k, _mm512_set1_epi32(sCId + 1));
+            __m512i c = _mm512_sub_epi32(k, _mm512_set1_epi32(1));
+            __m512 t = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), occupied, c, tot, 4);
+            __m512 g = _mm512_sub_ps(_mm512_mul_ps(_mm512_set1_ps(2.0f), _mm512_loadu_ps(&gravities[slot])),
+                    _mm512_mul_ps(_mm512_set1_ps(scale), _mm512_sub_ps(t, _mm512_set1_ps(base))));
+            __mmask16 better = occupied & (_mm512_cmp_ps_mask(g, vBest, _CMP_GT_OQ)
+                    | (_mm512_cmp_ps_mask(g, vBest, _CMP_EQ_OQ) & _mm512_cmp_ps_mask(g, _mm512_setzero_ps(), _CMP_NEQ_OQ)
+                    & _mm512_cmplt_epi32_mask(c, vDest)));
+            vBest = _mm512_mask_blend_ps(better, vBest, g);
+            vDest = _mm512_mask_blend_epi32(better, vDest, c);
+        }
+        float laneGain[16];
+        int laneDest[16];
+        _mm512_storeu_ps(laneGain, vBest);
+        _mm512_storeu_si512((void*) laneDest, vDest);
+        for (int i = 0; i < 16; i++)
+            better(laneGain[i], laneDest[i], gain, dest);
+#elif defined(__AVX2__)
+        __m256 vBest = _mm256_setzero_ps();
+        __m256i vDest = _mm256_set1_epi32(-1);
+        for (; slot < capacity; slot += 8) {
+            __m256i k = _mm256_loadu_si256((const __m256i*) &keys[slot]);
+            __m256i unused = _mm256_or_si256(_mm256_cmpeq_epi32(k, _mm256_setzero_si256()),
+                    _mm256_cmpeq_epi32(k, _mm256_set1_epi32(sCId + 1)));
+            __m256 occupied = _mm256_castsi256_ps(_mm256_xor_si256(unused, _mm256_set1_epi32(-1)));
+            __m256i c = _mm256_sub_epi32(k, _mm256_set1_epi32(1));
+            __m256 t = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), tot, c, occupied, 4);
+            __m256 g = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(2.0f), _mm256_loadu_ps(&gravities[slot])),
+                    _mm256_mul_ps(_mm256_set1_ps(scale), _mm256_sub_ps(t, _mm256_set1_ps(base))));
+            __m256 tie = _mm256_and_ps(_mm256_cmp_ps(g, vBest, _CMP_EQ_OQ),
+                    _mm256_and_ps(_mm256_cmp_ps(g, _mm256_setzero_ps(), _CMP_NEQ_OQ),
+                    _mm256_castsi256_ps(_mm256_cmpgt_epi32(vDest, c))));
+            __m256 better = _mm256_and_ps(occupied, _mm256_or_ps(_mm256_cmp_ps(g, vBest, _CMP_GT_OQ), tie));
+            vBest = _mm256_blendv_ps(vBest, g, better);
+            vDest = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(vDest), _mm256_castsi256_ps(c), better));
+        }
+        float laneGain[8];
+        int laneDest[8];
+        _mm256_storeu_ps(laneGain, vBest);
+        _mm256_storeu_si256((__m256i*) laneDest, vDest);
+        for (int i = 0; i < 8; i++)
+            better(laneGain[i], laneDest[i], gain, dest);
+#endif
+        for (; slot < capacity; slot++) {
+            if (keys[slot] == FLAG_FREE || keys[slot] == sCId + 1)
+                continue;
+            int c = keys[slot] - 1;
+            better(2.0f * gravities[slot] - scale * (tot[c] - base), c, gain, dest);
+        }
+
+        *bestGain = gain;
+        return dest;
+    }
+
+private:
+
+    // Tie rule of hashInsertGPU
+    static void better(float g, int c, float& gain, int& dest) {
+        if (g > gain || (g == gain && g != 0 && c < dest)) {
+            gain = g;
+            dest = c;
+        }
+    }
+};
+
+#endif	/* HASHTABLEHOST_H */
@@ -29,9 +29,31 @@
 #ifndef HASHITEM_H
 #define	HASHITEM_H
 
+#include"stddef.h"
+
 struct HashItem {
     int cId;
     float gravity;
 };
+
+// Table slot of deterministic mode: the gravity is a 64-bit fixed-point sum
+// (see openaddressing.h). Default mode keeps the 8-byte HashItem.
+struct WideHashItem {
+    int cId;
+    long long fixedGravity;
+};
+
+// Bytes of a table slot in the given mode
+
+inline size_t tableItemSize(bool deterministic) {
+    return deterministic ? sizeof (WideHashItem) : sizeof (HashItem);
+}
+
+// Table memory is kept as long long words so one buffer serves both slot
+// types; zeroed words are free slots (FLAG_FREE == 0)
+
+inline size_t tableWords(size_t nrSlots, bool deterministic) {
+    return nrSlots * tableItemSize(deterministic) / sizeof (long long);
+}
 #endif	/* HASHITEM_H */
 
@@ -0,0 +1,102 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#include"hashstats.h"
+#include"string.h"
+#include"fstream"
+#include"iostream"
+#include"iomanip"
+#include"sstream"
+#include"logger.h"
+
+const char* tableClassNames[NR_TABLE_CLASSES] = {"leq4", "leq8", "leq16", "leq32", "Wrp", "BlkSMem", "BlkGMem"};
+
+void clearHashProbeStats(HashProbeStats& stats) {
+
+    memset(&stats, 0, sizeof (HashProbeStats));
+}
+
+void printHashProbeStats(const HashProbeStats& stats, const char* label) {
+
+    std::ostringstream report;
+    report << "Hash tables (" << label << "):";
+    report << std::fixed << std::setprecision(3);
+
+    for (int tc = 0; tc < NR_TABLE_CLASSES; tc++) {
+
+        if (!stats.nrInserts[tc] && !stats.nrTables[tc])
+            continue;
+
+        double avgProbe = stats.nrInserts[tc] ? (double) stats.nrInsertProbes[tc] / stats.nrInserts[tc] : 0.0;
+        double avgSearch = stats.nrSearches[tc] ? (double) stats.nrSearchProbes[tc] / stats.nrSearches[tc] : 0.0;
+        double avgLoad = stats.nrSlots[tc] ? (double) stats.nrOccupied[tc] / stats.nrSlots[tc] : 0.0;
+
+        unsigned long long maxBin = 0;
+        for (int b = 0; b < NR_PROBE_BINS; b++)
+            if (stats.probeHist[tc][b])
+                maxBin = b + 1;
+
+        report << "\n  " << std::setw(8) << tableClassNames[tc]
+                << " #insert: " << stats.nrInserts[tc]
+                << " probe/insert: " << avgProbe
+                << " maxProbe: " << (maxBin == NR_PROBE_BINS ? ">=" : "") << maxBin
+                << " probe/search: " << avgSearch
+                << " #table: " << stats.nrTables[tc]
+                << " load: " << avgLoad
+                << " #failed: " << stats.nrFailed[tc];
+    }
+    LOG(LOG_SUMMARY, report.str());
+}
+
+void appendHashProbeStats(const HashProbeStats& stats, const char* fileName,
+        int level, const char* phase) {
+
+    bool isNew = !std::ifstream(fileName).good();
+    std::ofstream out(fileName, std::ios::app);
+
+    if (isNew) {
+        out << "Level,Phase,Class,Inserts,InsertProbes,Failed,Searches,SearchProbes,Tables,Occupied,Slots";
+        for (int b = 1; b <= NR_PROBE_BINS; b++)
+            out << ",Probe" << b;
+        for (int b = 0; b < NR_LOAD_BINS; b++)
+            out << ",Load" << b;
+        out << "\n";
+    }
+
+    for (int tc = 0; tc < NR_TABLE_CLASSES; tc++) {
+
+        if (!stats.nrInserts[tc] && !stats.nrTables[tc])
+            continue;
+
+        out << level << "," << phase << "," << tableClassNames[tc] << ","
+                << stats.nrInserts[tc] << "," << stats.nrInsertProbes[tc] << ","
+                << stats.nrFailed[tc] << "," << stats.nrSearches[tc] << ","
+                << stats.nrSearchProbes[tc] << "," << stats.nrTables[tc] << ","
+                << stats.nrOccupied[tc] << "," << stats.nrSlots[tc];
+        for (int b = 0; b < NR_PROBE_BINS; b++)
+            out << "," << stats.probeHist[tc][b];
+        for (int b = 0; b < NR_LOAD_BINS; b++)
+            out << "," << stats.loadHist[tc][b];
+        out << "\n";
+    }
+}
@@ -0,0 +1,155 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#ifndef HASHSTATS_H
+#define	HASHSTATS_H
+
+#include"hostconstants.h"
+#include"stdio.h"
+
+// Probe statistics of the open-addressing tables, compiled in only with
+// -D HASH_PROBE_STATS (make HASHSTATS=1). Tables are grouped by the class
+// of the kernel that owns them; the class is recovered from the bucket size.
+
+#define NR_TABLE_CLASSES 7
+#define NR_PROBE_BINS 16 // 1, 2, .., 15 and >= 16 probes
+#define NR_LOAD_BINS 10 // load factor in steps of 0.1
+
+enum TableClass {
+    TBL_LEQ4, TBL_LEQ8, TBL_LEQ16, TBL_LEQ32, TBL_WARP, TBL_BLK_SHARED, TBL_BLK_GLOBAL
+};
+
+extern const char* tableClassNames[NR_TABLE_CLASSES];
+
+struct HashProbeStats {
+    unsigned long long nrInserts[NR_TABLE_CLASSES];
+    unsigned long long nrInsertProbes[NR_TABLE_CLASSES];
+    unsigned long long nrFailed[NR_TABLE_CLASSES]; // insert returned -1
+    unsigned long long probeHist[NR_TABLE_CLASSES][NR_PROBE_BINS];
+
+    unsigned long long nrSearches[NR_TABLE_CLASSES];
+    unsigned long long nrSearchProbes[NR_TABLE_CLASSES];
+
+    // One entry per filled table (vertex in move phase, community in contraction)
+    unsigned long long nrTables[NR_TABLE_CLASSES];
+    unsigned long long nrOccupied[NR_TABLE_CLASSES];
+    unsigned long long nrSlots[NR_TABLE_CLASSES];
+    unsigned long long loadHist[NR_TABLE_CLASSES][NR_LOAD_BINS];
+};
+
+// Bucket sizes in use: 7, 17, 31, 61, WARP_TABLE_SIZE_1, SHARED_TABLE_SIZE
+// and primes > 1.5 * degree for global tables. A global table of a vertex
+// with degree ~SHARED_TABLE_SIZE*2/3 can get SHARED_TABLE_SIZE itself and
+// is then counted as shared.
+#ifdef RUNONGPU
+__host__ __device__
+#endif
+inline int tableClassOf(unsigned int bucketSize) {
+    if (bucketSize <= 7) return TBL_LEQ4;
+    if (bucketSize <= 17) return TBL_LEQ8;
+    if (bucketSize <= 31) return TBL_LEQ16;
+    if (bucketSize <= 61) return TBL_LEQ32;
+    if (bucketSize <= WARP_TABLE_SIZE_1) return TBL_WARP;
+    if (bucketSize <= SHARED_TABLE_SIZE) return TBL_BLK_SHARED;
+    return TBL_BLK_GLOBAL;
+}
+
+void clearHashProbeStats(HashProbeStats& stats);
+
+// One line per table class with inserts
+void printHashProbeStats(const HashProbeStats& stats, const char* label);
+
+// Appends one row per table class; header written if file is new
+void appendHashProbeStats(const HashProbeStats& stats, const char* fileName,
+        int level, const char* phase);
+
+#ifdef HASH_PROBE_STATS
+
+#ifdef RUNONGPU
+// Every .cu including this gets its own copy; the hash kernels all live in
+// coreutility.cu, which also provides fetch/reset below
+static __device__ HashProbeStats d_hashStats;
+#define HASH_STAT_ADD(counter, value) atomicAdd(&(counter), (unsigned long long) (value))
+#define HASH_STATS d_hashStats
+#else
+// Host build of the table code (hashBench); single threaded
+static HashProbeStats h_hashStats;
+#define HASH_STAT_ADD(counter, value) ((counter) += (unsigned long long) (value))
+#define HASH_STATS h_hashStats
+#endif
+
+#ifdef RUNONGPU
+__device__
+#endif
+inline void recordInsert(unsigned int bucketSize, int nrProbe) {
+    int tc = tableClassOf(bucketSize);
+    if (nrProbe < 0) {
+        HASH_STAT_ADD(HASH_STATS.nrFailed[tc], 1);
+        nrProbe = bucketSize;
+    }
+    HASH_STAT_ADD(HASH_STATS.nrInserts[tc], 1);
+    HASH_STAT_ADD(HASH_STATS.nrInsertProbes[tc], nrProbe);
+    HASH_STAT_ADD(HASH_STATS.probeHist[tc][nrProbe < NR_PROBE_BINS ? nrProbe - 1 : NR_PROBE_BINS - 1], 1);
+}
+
+#ifdef RUNONGPU
+__device__
+#endif
+inline void recordSearch(unsigned int bucketSize, int nrProbe) {
+    int tc = tableClassOf(bucketSize);
+    HASH_STAT_ADD(HASH_STATS.nrSearches[tc], 1);
+    HASH_STAT_ADD(HASH_STATS.nrSearchProbes[tc], nrProbe);
+}
+
+// Called once per table when it is complete
+#ifdef RUNONGPU
+__device__
+#endif
+inline void recordLoad(unsigned int bucketSize, int nrOccupied) {
+    int tc = tableClassOf(bucketSize);
+    int bin = (nrOccupied * NR_LOAD_BINS) / (int) bucketSize;
+    HASH_STAT_ADD(HASH_STATS.nrTables[tc], 1);
+    HASH_STAT_ADD(HASH_STATS.nrOccupied[tc], nrOccupied);
+    HASH_STAT_ADD(HASH_STATS.nrSlots[tc], bucketSize);
+    HASH_STAT_ADD(HASH_STATS.loadHist[tc][bin < NR_LOAD_BINS ? bin : NR_LOAD_BINS - 1], 1);
+}
+
+#define HASH_STAT_INSERT(bucketSize, nrProbe) recordInsert(bucketSize, nrProbe)
+#define HASH_STAT_SEARCH(bucketSize, nrProbe) recordSearch(bucketSize, nrProbe)
+#define HASH_STAT_LOAD(bucketSize, nrOccupied) recordLoad(bucketSize, nrOccupied)
+
+// Host side access to the device counters (coreutility.cu)
+#ifdef RUNONGPU
+void fetchHashProbeStats(HashProbeStats& stats);
+void resetHashProbeStats();
+#endif
+
+#else
+
+#define HASH_STAT_INSERT(bucketSize, nrProbe)
+#define HASH_STAT_SEARCH(bucketSize, nrProbe)
+#define HASH_STAT_LOAD(bucketSize, nrOccupied)
+
+#endif
+
+#endif	/* HASHSTATS_H */
@@ -27,6 +27,53 @@
 #define SHARED_TABLE_SIZE 479 // Must be a Prime
 #define WARP_TABLE_SIZE_1 127 // Must be a Prime
 
+// Tables of the bins with at most 4, 8, 16 and 32 neighbors; Must be Primes
+#define LEQ4_TABLE_SIZE 7
+#define LEQ8_TABLE_SIZE 17
+#define LEQ16_TABLE_SIZE 31
+#define LEQ32_TABLE_SIZE 61
+
+// A row of the block bins accumulates into a dense table indexed by
+// community id when its degree is at least #communities / DENSE_TABLE_RATIO
+#define DENSE_TABLE_RATIO 32
+#define DENSE_TABLE_BUDGET_MB 256
+
+// Label propagation warm start: vertices with more neighbors keep their
+// label; rounds stop once fewer than 1/LABEL_PROP_STOP_RATIO of the vertices
+// moved in the last two rounds
+#define LABEL_PROP_MAX_DEGREE 32
+#define LABEL_PROP_STOP_RATIO 100
+
+// Levels with more links never run on the host engine in autotuned mode
+#define HOST_ENGINE_MAX_LINKS (1 << 24)
+
+// Connected components: cliques and trees up to COMPONENT_TINY_SIZE
+// vertices are settled as one community; the other components are packed
+// into solves of up to COMPONENT_BATCH_SIZE vertices
+#define COMPONENT_TINY_SIZE 32
+#define COMPONENT_BATCH_SIZE (1 << 20)
+
+// Size limit of the graph cache directory
+#define GRAPH_CACHE_LIMIT_MB 4096
+
+// Chunk size of the pipelined loader
+#define GRAPH_LOAD_CHUNK_MB 64
+
+// Autotuned mini-batches: at most MINI_BATCH_MAX per bin, and no batch
+// smaller than MINI_BATCH_MIN_SIZE vertices (keeps the device busy)
+#define MINI_BATCH_MAX 16
+#define MINI_BATCH_MIN_SIZE 8192
+
+// Anytime mode: predicted phase times are stretched by this factor before
+// they are checked against the deadline
+#define DEADLINE_MARGIN 1.25
+
+// Partition evaluator: per-thread community accumulators share this many MB
+#define EVAL_ACCUMULATOR_MB 4096
+
+// Host bucketing: at least this many items per thread
+#define HOST_BUCKET_GRAIN (1 << 16)
+
 #define CAPACITY_FACTOR_NUMERATOR 2
 #define CAPACITY_FACTOR_DENOMINATOR 3
 #define HALF_WARP 16
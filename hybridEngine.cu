@@ -0,0 +1,119 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"communityGPU.h"
+#include"louvainHOST.h"
+#include"hostconstants.h"
+#include"limits"
+
+static double levelTotalWeight(const GraphGPU& g, double globalTotalWeight) {
+
+    if (globalTotalWeight > 0)
+        return globalTotalWeight;
+    if (g.type == WEIGHTED)
+        return thrust::reduce(thrust::device, g.weights.begin(), g.weights.end(), (double) 0, thrust::plus<double>());
+    return (double) g.nb_links;
+}
+
+// Device CSR copied straight into the arrays of the host engine
+static void copyLevelToHost(const GraphGPU& g, LouvainHOST& engine) {
+
+    thrust::copy(g.indices.begin(), g.indices.end(), engine.offsets.begin());
+    thrust::copy(g.links.begin(), g.links.end(), engine.links.begin());
+    if (g.type == WEIGHTED)
+        thrust::copy(g.weights.begin(), g.weights.end(), engine.weights.begin());
+}
+
+// Seconds of one host sweep over the current level, per link
+
+double Community::hostTimePerLink() {
+
+    LouvainHOST engine(community_size, g.nb_links, g.type == WEIGHTED, levelTotalWeight(g, globalTotalWeight));
+    copyLevelToHost(g, engine);
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    // no gain reaches the threshold: the level ends after one sweep
+    engine.oneLevel(std::numeric_limits<double>::max());
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1.0e9;
+
+    return seconds / std::max(g.nb_links, (unsigned long) 1);
+}
+
+bool Community::levelOnHost(EngineCosts& costs) {
+
+    if (hostCutover > 0)
+        return g.nb_links <= (unsigned long) hostCutover;
+
+    // Autotuned: compare with the last device level, probing the host once
+    if (!hostCutover || !costs.deviceLevelLinks || g.nb_links > HOST_ENGINE_MAX_LINKS)
+        return false;
+
+    if (costs.hostTimePerLink < 0)
+        costs.hostTimePerLink = hostTimePerLink();
+
+    // A device level costs at least the launch and setup overhead seen in
+    // the shortest one; the host needs one more sweep for the contraction
+    double deviceTime = std::max(costs.deviceLevelFloor,
+            costs.deviceLevelTime * g.nb_links / costs.deviceLevelLinks);
+    double hostTime = costs.hostTimePerLink * g.nb_links * (costs.deviceLevelSweeps + 1);
+
+    LOG(LOG_DEBUG, "Level " << level << ": #E " << g.nb_links << " predicted device " << deviceTime
+            << " sec, host " << hostTime << " sec");
+
+    return hostTime < deviceTime;
+}
+
+// Remaining levels on the host engine, stopping between levels at the
+// deadline; returns the final modularity
+
+double Community::runOnHost(double threshold, int maxLevels) {
+
+    LouvainHOST engine(community_size, g.nb_links, g.type == WEIGHTED, levelTotalWeight(g, globalTotalWeight));
+    copyLevelToHost(g, engine);
+
+    // a budget of 0 is none; an exhausted one still runs the first level
+    double budget = 0;
+    if (deadline.limit > 0)
+        budget = std::max(deadline.limit - secondsSinceStart(), 1.0e-9);
+
+    double mod = engine.run(threshold, maxLevels, budget);
+    deadline.hit = deadline.hit || engine.budgetHit;
+
+    LOG(LOG_INFO, "Levels " << level << ".." << level + engine.levelModularity.size() - 1
+            << " on the host engine: #V " << community_size << " #E " << g.nb_links << " Modularity " << mod);
+
+    if (keepDendrogram) {
+        for (int l = 0; l < engine.dendrogram.nrLevels(); l++)
+            dendrogram.addLevel(engine.dendrogram.levels[l]);
+    }
+    level += engine.dendrogram.nrLevels();
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    modularityTrace.push_back(std::make_pair((now.tv_sec - runStart.tv_sec) + (now.tv_nsec - runStart.tv_nsec) / 1.0e9, mod));
+
+    return mod;
+}
@@ -257,22 +257,276 @@ void computeInternals(int *indices, unsigned int *links, float *weights, int *n2
 
         unsigned int startNbr = indices[vid];
         unsigned int endNbr = indices[vid + 1];
+        float toAdd = 0.0;
         for (unsigned int i = startNbr + laneId; i < endNbr; i = i + PHY_WRP_SZ) {
             unsigned int nbr = links[i];
             if (n2c[nbr] == n2c[vid]) {
 
-                float toAdd = 0.0;
-
                 if (graphType == UNWEIGHTED) {
-                    toAdd = 1.0;
+                    toAdd += 1.0;
                 } else {
-                    toAdd = weights[i];
+                    toAdd += weights[i];
                 }
-                atomicAdd(&in[vid], toAdd);
             }
         }
+
+        // Fixed-order reduction instead of atomics keeps in[] reproducible
+        for (int i = PHY_WRP_SZ / 2; i >= 1; i = i / 2)
+            toAdd += __shfl_xor(toAdd, i, PHY_WRP_SZ);
+
+        if (!laneId)
+            in[vid] += toAdd;
+
         vid = vid + (blockDim.x * gridDim.x) / PHY_WRP_SZ;
     }
 }
 
+// sums[keys[i]] += values[i] in fixed point (value * scale); integer adds
+// make the result independent of the order of the atomics
+
+__global__
+void accumulateFixedPoint(unsigned int nrElements, int* keys, float* values,
+        float scale, unsigned long long* sums) {
+
+    unsigned int tid = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (tid < nrElements) {
+        long long toAdd = __float2ll_rn(values[tid] * scale);
+        atomicAdd(&sums[keys[tid]], (unsigned long long) toAdd);
+        tid = tid + blockDim.x * gridDim.x;
+    }
+}
+
+__global__
+void fixedPointToFloat(unsigned int nrElements, unsigned long long* sums, float scale, float* values) {
+
+    unsigned int tid = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (tid < nrElements) {
+        values[tid] = (float) ((double) (long long) sums[tid] / scale);
+        tid = tid + blockDim.x * gridDim.x;
+    }
+}
+
+// Deterministic mode: the moves of one batch of candidates applied to the
+// fixed-point tot; the float tot of each community they touched is then
+// refreshed by refreshMovedTot, so the work follows the batch, not #comms
+
+__global__
+void moveFixedPoint(int nrCandidates, int* candidates, int* n2c, int* n2c_new,
+        float* wDegs, float scale, unsigned long long* totFixed) {
+
+    unsigned int tid = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (tid < nrCandidates) {
+        int node = candidates[tid];
+        int from = n2c[node], to = n2c_new[node];
+        if (from != to) {
+            long long toMove = __float2ll_rn(wDegs[node] * scale);
+            atomicAdd(&totFixed[from], (unsigned long long) (-toMove));
+            atomicAdd(&totFixed[to], (unsigned long long) toMove);
+        }
+        tid = tid + blockDim.x * gridDim.x;
+    }
+}
+
+__global__
+void refreshMovedTot(int nrCandidates, int* candidates, int* n2c, int* n2c_new,
+        unsigned long long* totFixed, float scale, float* tot_new) {
+
+    unsigned int tid = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (tid < nrCandidates) {
+        int node = candidates[tid];
+        int from = n2c[node], to = n2c_new[node];
+        if (from != to) {
+            tot_new[from] = (float) ((double) (long long) totFixed[from] / scale);
+            tot_new[to] = (float) ((double) (long long) totFixed[to] / scale);
+        }
+        tid = tid + blockDim.x * gridDim.x;
+    }
+}
+
+// One round of label propagation over the vertices of one parity class.
+// A vertex takes the neighboring label c maximizing
+// w(v,c) - wDegs[v] * tot[c] / total_weight, i.e. its links to c minus a
+// penalty growing with its degree and the volume of c, which keeps labels
+// from flooding the graph. Labels are read from n2c and written to n2c_new;
+// vertices with more than maxDegree neighbors keep their label.
+
+__global__
+void labelPropagationRound(int community_size, int* indices, unsigned int* links,
+        float* weights, int type, int* n2c, int* n2c_new, float* tot, float* wDegs,
+        int* cardinalityOfComms, double total_weight, unsigned int parity,
+        int maxDegree, int* nrMoves) {
+
+    int vid = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (vid < community_size) {
+
+        int own = n2c[vid];
+        n2c_new[vid] = own;
+
+        unsigned int startNbr = indices[vid];
+        unsigned int endNbr = indices[vid + 1];
+        unsigned int half = ((unsigned int) vid * 0x9E3779B9u) >> 31;
+
+        if (half == parity && endNbr > startNbr && (int) (endNbr - startNbr) <= maxDegree) {
+
+            float wDeg = wDegs[vid];
+
+            // links to the own community, self loops excluded
+            float toOwn = 0.0;
+            for (unsigned int i = startNbr; i < endNbr; i++) {
+                if (links[i] != (unsigned int) vid && n2c[links[i]] == own)
+                    toOwn += (type == WEIGHTED) ? weights[i] : 1.0;
+            }
+
+            int best = own;
+            double bestGain = toOwn - wDeg * (tot[own] - wDeg) / total_weight;
+
+            for (unsigned int i = startNbr; i < endNbr; i++) {
+
+                int comm = n2c[links[i]];
+                if (comm == own)
+                    continue;
+
+                // Two singletons merge only into the smaller label, so
+                // neighbors of the same class never swap
+                if (cardinalityOfComms[own] == 1 && cardinalityOfComms[comm] == 1 && comm > own)
+                    continue;
 
+                // each label is evaluated at its first link
+                bool seen = false;
+                for (unsigned int j = startNbr; j < i && !seen; j++)
+                    seen = (n2c[links[j]] == comm);
+                if (seen)
+                    continue;
+
+                float toComm = 0.0;
+                for (unsigned int j = i; j < endNbr; j++) {
+                    if (n2c[links[j]] == comm)
+                        toComm += (type == WEIGHTED) ? weights[j] : 1.0;
+                }
+
+                double gain = toComm - wDeg * tot[comm] / total_weight;
+                if (gain > bestGain || (gain == bestGain && best != own && comm < best)) {
+                    best = comm;
+                    bestGain = gain;
+                }
+            }
+
+            if (best != own) {
+                n2c_new[vid] = best;
+                atomicAdd(nrMoves, 1);
+            }
+        }
+        vid = vid + blockDim.x * gridDim.x;
+    }
+}
+
+__global__
+void countMembers(int nrNodes, int* n2c, int* cardinalityOfComms) {
+
+    unsigned int tid = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (tid < nrNodes) {
+        atomicAdd(&cardinalityOfComms[n2c[tid]], 1);
+        tid = tid + blockDim.x * gridDim.x;
+    }
+}
+
+// Min-label hooking for connected components: every vertex hooks the root
+// of its label under the smallest label among its neighbors. Together with
+// compressComponents, labels converge to the smallest vertex id of each
+// component.
+
+__global__
+void hookComponents(int nrNodes, int* indices, unsigned int* links, int* label, int* changed) {
+
+    int vid = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (vid < nrNodes) {
+
+        int own = label[vid];
+        int smallest = own;
+        for (int i = indices[vid]; i < indices[vid + 1]; i++)
+            smallest = min(smallest, label[links[i]]);
+
+        if (smallest < own) {
+            atomicMin(&label[own], smallest);
+            atomicMin(&label[vid], smallest);
+            *changed = 1;
+        }
+        vid = vid + blockDim.x * gridDim.x;
+    }
+}
+
+// Pointer jumping until every label points at a root
+__global__
+void compressComponents(int nrNodes, int* label) {
+
+    int vid = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (vid < nrNodes) {
+        int root = label[vid];
+        while (label[root] != root)
+            root = label[root];
+        label[vid] = root;
+        vid = vid + blockDim.x * gridDim.x;
+    }
+}
+
+// Moves of one launch, before their commit: counts[0] vertices that moved,
+// counts[1] of them with a neighbor that moved in the same launch (both
+// decided against the stale n2c and tot)
+
+__global__
+void countMoveConflicts(int* candidates, int nrCandidates, int* indices, unsigned int* links,
+        int* n2c, int* n2c_new, int* counts) {
+
+    int i = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (i < nrCandidates) {
+        int vid = candidates[i];
+        if (n2c_new[vid] != n2c[vid]) {
+            bool conflict = false;
+            for (int j = indices[vid]; j < indices[vid + 1] && !conflict; j++) {
+                unsigned int nbr = links[j];
+                conflict = ((int) nbr != vid) && (n2c_new[nbr] != n2c[nbr]);
+            }
+            atomicAdd(&counts[0], 1);
+            if (conflict)
+                atomicAdd(&counts[1], 1);
+        }
+        i = i + blockDim.x * gridDim.x;
+    }
+}
+
+// Vertices per bin of the move phase (BlkGMem, BlkSMem, Wrp, leq32, leq16,
+// leq8, leq4, None) from the neighbor counts
+
+__global__
+void degreeHistogram(int nrNodes, unsigned int* degrees, unsigned int warpLimit,
+        unsigned int blkSMemLimit, int* binSizes) {
+
+    __shared__ int blockSizes[NR_BINS];
+
+    if (threadIdx.x < NR_BINS)
+        blockSizes[threadIdx.x] = 0;
+    __syncthreads();
+
+    int vid = threadIdx.x + blockIdx.x * blockDim.x;
+
+    while (vid < nrNodes) {
+        unsigned int degree = degrees[vid];
+        int bin = (degree > blkSMemLimit) ? 0 : (degree > warpLimit) ? 1 : (degree > 32) ? 2 :
+                (degree > 16) ? 3 : (degree > 8) ? 4 : (degree > 4) ? 5 : (degree > 0) ? 6 : 7;
+        atomicAdd(&blockSizes[bin], 1);
+        vid = vid + blockDim.x * gridDim.x;
+    }
+    __syncthreads();
+
+    if (threadIdx.x < NR_BINS && blockSizes[threadIdx.x])
+        atomicAdd(&binSizes[threadIdx.x], blockSizes[threadIdx.x]);
+}
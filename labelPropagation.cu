@@ -0,0 +1,106 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"communityGPU.h"
+#include"hostconstants.h"
+
+// Level 0 warm start: bounded rounds of label propagation from the
+// singletons in n2c, alternating between two halves of the vertices so
+// neighbors rarely move at the same time. tot and cardinalityOfComms are
+// left consistent with the new n2c; returns its modularity.
+
+double Community::warmStart(thrust::device_vector<float>& wDegs, thrust::device_vector<float>& tot,
+        thrust::device_vector<int>& cardinalityOfComms) {
+
+    thrust::device_vector<int> n2c_next(community_size);
+    thrust::device_vector<int> nrMoves(1, 0);
+
+    // fixed point sums keep tot independent of the order of the atomics
+    thrust::device_vector<unsigned long long> totFixed(community_size);
+
+    int nr_of_block = (community_size + NR_THREAD_PER_BLOCK - 1) / NR_THREAD_PER_BLOCK;
+    int round = 0, prevMoves = community_size;
+
+    while (round < warmStartRounds) {
+
+        nrMoves[0] = 0;
+
+        labelPropagationRound << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+                thrust::raw_pointer_cast(g.indices.data()),
+                thrust::raw_pointer_cast(g.links.data()),
+                thrust::raw_pointer_cast(g.weights.data()), g.type,
+                thrust::raw_pointer_cast(n2c.data()),
+                thrust::raw_pointer_cast(n2c_next.data()),
+                thrust::raw_pointer_cast(tot.data()),
+                thrust::raw_pointer_cast(wDegs.data()),
+                thrust::raw_pointer_cast(cardinalityOfComms.data()),
+                g.total_weight, round % 2, LABEL_PROP_MAX_DEGREE,
+                thrust::raw_pointer_cast(nrMoves.data()));
+
+        n2c.swap(n2c_next);
+
+        thrust::fill(totFixed.begin(), totFixed.end(), 0);
+        accumulateFixedPoint << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+                thrust::raw_pointer_cast(n2c.data()),
+                thrust::raw_pointer_cast(wDegs.data()), gravityScale,
+                thrust::raw_pointer_cast(totFixed.data()));
+        fixedPointToFloat << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+                thrust::raw_pointer_cast(totFixed.data()), gravityScale,
+                thrust::raw_pointer_cast(tot.data()));
+
+        thrust::fill(cardinalityOfComms.begin(), cardinalityOfComms.end(), 0);
+        countMembers << <nr_of_block, NR_THREAD_PER_BLOCK>>>(community_size,
+                thrust::raw_pointer_cast(n2c.data()),
+                thrust::raw_pointer_cast(cardinalityOfComms.data()));
+
+        round++;
+
+        int moves = nrMoves[0];
+        LOG(LOG_DEBUG, "Label propagation round " << round << ": #moves " << moves);
+
+        if ((long long) (moves + prevMoves) * LABEL_PROP_STOP_RATIO < community_size)
+            break;
+        prevMoves = moves;
+    }
+
+    thrust::device_vector<float> in(community_size, 0.0);
+
+    int load_per_blk = CHUNK_PER_WARP * (NR_THREAD_PER_BLOCK / PHY_WRP_SZ);
+    nr_of_block = (community_size + load_per_blk - 1) / load_per_blk;
+
+    computeInternals << <nr_of_block, NR_THREAD_PER_BLOCK>>>(thrust::raw_pointer_cast(g.indices.data()),
+            thrust::raw_pointer_cast(g.links.data()),
+            thrust::raw_pointer_cast(g.weights.data()),
+            thrust::raw_pointer_cast(n2c.data()),
+            thrust::raw_pointer_cast(in.data()), community_size, g.type);
+
+    double mod = modularity(tot, in);
+
+    if (LOG_ENABLED(LOG_INFO)) {
+        int nrComms = thrust::count_if(cardinalityOfComms.begin(), cardinalityOfComms.end(),
+                IsGreaterThanZero<int>(0));
+        LOG(LOG_INFO, "Warm start: " << round << " rounds, #communities " << nrComms
+                << " Modularity " << mod);
+    }
+
+    return mod;
+}
@@ -0,0 +1,87 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#include"logger.h"
+#include"stdio.h"
+#include"mutex"
+
+int logRuntimeLevel = LOG_SUMMARY;
+
+// Lines are collected in memory and written in large chunks; nothing is
+// flushed per line
+struct LogSink {
+    std::string buffer;
+    std::mutex lock;
+
+    ~LogSink() {
+        writeOut();
+    }
+
+    void writeOut() {
+        if (buffer.size()) {
+            fwrite(buffer.data(), 1, buffer.size(), stdout);
+            fflush(stdout);
+            buffer.clear();
+        }
+    }
+};
+
+static LogSink sink;
+
+static const size_t LOG_BUFFER_LIMIT = 1 << 16;
+
+void setLogLevel(int level) {
+    logRuntimeLevel = level;
+}
+
+int parseLogLevel(const std::string& name) {
+
+    const char* names[] = {"trace", "debug", "info", "summary", "warn", "error"};
+    for (int level = LOG_TRACE; level <= LOG_ERROR; level++) {
+        if (name == names[level])
+            return level;
+    }
+    return -1;
+}
+
+void logWrite(int level, const std::string& line) {
+
+    std::lock_guard<std::mutex> guard(sink.lock);
+
+    if (level >= LOG_WARN) {
+        sink.writeOut();
+        fprintf(stderr, "%s\n", line.c_str());
+        return;
+    }
+
+    sink.buffer += line;
+    sink.buffer += '\n';
+    if (sink.buffer.size() > LOG_BUFFER_LIMIT)
+        sink.writeOut();
+}
+
+void logFlush() {
+
+    std::lock_guard<std::mutex> guard(sink.lock);
+    sink.writeOut();
+}
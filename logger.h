@@ -0,0 +1,72 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#ifndef LOGGER_H
+#define	LOGGER_H
+
+#include"sstream"
+#include"string"
+
+// Severity of a message; a message is printed if its level is at least the
+// runtime level (--log=) and it is compiled in at all if it is at least
+// LOG_MIN_LEVEL. The default run prints the summary of a run only.
+
+#define LOG_TRACE 0 // kernel timings and dumps of vectors
+#define LOG_DEBUG 1 // per sweep and per bin progress
+#define LOG_INFO 2 // per level progress and input statistics
+#define LOG_SUMMARY 3 // result of a run
+#define LOG_WARN 4
+#define LOG_ERROR 5
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_DEBUG
+#endif
+
+extern int logRuntimeLevel;
+
+void setLogLevel(int level);
+
+// "trace", "debug", "info", "summary", "warn" or "error"; -1 if unknown
+int parseLogLevel(const std::string& name);
+
+// Appends a line to the buffered sink; warnings and errors are written
+// through to stderr after the pending output
+void logWrite(int level, const std::string& line);
+
+// Writes the buffered output; also done when the program exits
+void logFlush();
+
+#define LOG_ENABLED(level) ((level) >= LOG_MIN_LEVEL && (level) >= logRuntimeLevel)
+
+// message is a stream expression, e.g. LOG(LOG_INFO, "#Nodes: " << n);
+// it is evaluated only if the level is enabled
+#define LOG(level, message)                                 \
+    do {                                                    \
+        if (LOG_ENABLED(level)) {                           \
+            std::ostringstream logLine;                     \
+            logLine << message;                             \
+            logWrite(level, logLine.str());                 \
+        }                                                   \
+    } while (0)
+
+#endif	/* LOGGER_H */
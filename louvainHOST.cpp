@@ -0,0 +1,378 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#include"louvainHOST.h"
+#include"iostream"
+#include"algorithm"
+#include"random"
+#include"time.h"
+#include"logger.h"
+
+SharedLevelHOST::SharedLevelHOST(const GraphHOST& input_graph) {
+
+    nb_nodes = input_graph.nb_nodes;
+    total_weight = input_graph.total_weight;
+    links = input_graph.linkData();
+    weights = input_graph.weightData();
+
+    const unsigned long* cumDegree = input_graph.degreeData();
+    offsets.assign(nb_nodes + 1, 0);
+    for (unsigned int node = 0; node < nb_nodes; node++)
+        offsets[node + 1] = cumDegree[node];
+
+    wDegs.assign(nb_nodes, 0);
+    selfLoops.assign(nb_nodes, 0);
+    for (unsigned int node = 0; node < nb_nodes; node++) {
+        for (unsigned long e = offsets[node]; e < offsets[node + 1]; e++) {
+            double w = weights ? weights[e] : 1.0;
+            wDegs[node] += w;
+            if (links[e] == node)
+                selfLoops[node] += w;
+        }
+    }
+}
+
+LouvainHOST::LouvainHOST(const GraphHOST& input_graph) {
+
+    nb_nodes = input_graph.nb_nodes;
+    total_weight = input_graph.total_weight;
+
+    const unsigned long* cumDegree = input_graph.degreeData();
+    offsets.assign(nb_nodes + 1, 0);
+    for (unsigned int node = 0; node < nb_nodes; node++)
+        offsets[node + 1] = cumDegree[node];
+
+    links.assign(input_graph.linkData(), input_graph.linkData() + input_graph.nb_links);
+    weighted = input_graph.weightData() != NULL;
+    if (weighted)
+        weights.assign(input_graph.weightData(), input_graph.weightData() + input_graph.nb_links);
+    else
+        weights.assign(links.size(), 1.0);
+
+    seed = 0;
+    budgetHit = false;
+    shared = NULL;
+    sharedWDegs = NULL;
+    allocateWork();
+    bindCurrent();
+}
+
+LouvainHOST::LouvainHOST(unsigned int nrNodes, unsigned long nrLinks, bool isWeighted, double totalWeight) {
+
+    nb_nodes = nrNodes;
+    total_weight = totalWeight;
+    weighted = isWeighted;
+
+    offsets.assign(nb_nodes + 1, 0);
+    links.resize(nrLinks);
+    weights.assign(nrLinks, 1.0);
+
+    seed = 0;
+    budgetHit = false;
+    shared = NULL;
+    sharedWDegs = NULL;
+    allocateWork();
+    bindCurrent();
+}
+
+LouvainHOST::LouvainHOST(const SharedLevelHOST& sharedLevel, unsigned int seed,
+        const double* levelWDegs) : seed(seed), budgetHit(false) {
+
+    nb_nodes = sharedLevel.nb_nodes;
+    total_weight = sharedLevel.total_weight;
+    weighted = sharedLevel.weights != NULL;
+    shared = &sharedLevel;
+    sharedWDegs = levelWDegs ? levelWDegs : sharedLevel.wDegs.data();
+
+    allocateWork();
+
+    curOffsets = sharedLevel.offsets.data();
+    curLinks = sharedLevel.links;
+    curWeights = sharedLevel.weights;
+}
+
+void LouvainHOST::bindCurrent() {
+
+    curOffsets = offsets.data();
+    curLinks = links.data();
+    curWeights = weights.data();
+}
+
+void LouvainHOST::allocateWork() {
+
+    // with a shared level 0 the links vectors are empty until the first
+    // contraction fills them
+    nextOffsets.resize(nb_nodes + 1);
+    nextLinks.reserve(links.size());
+    nextWeights.reserve(links.size());
+    order.resize(nb_nodes);
+
+    n2c.resize(nb_nodes);
+    tot.resize(nb_nodes);
+    in.resize(nb_nodes);
+    wDegs.resize(nb_nodes);
+    selfLoops.resize(nb_nodes);
+
+    neighWeight.assign(nb_nodes, -1.0);
+    touched.reserve(nb_nodes);
+}
+
+double LouvainHOST::modularity() const {
+
+    double q = 0., m2 = total_weight;
+    for (unsigned int c = 0; c < nb_nodes; c++) {
+        if (tot[c] > 0)
+            q += in[c] / m2 - (tot[c] / m2)*(tot[c] / m2);
+    }
+    return q;
+}
+
+template<bool IS_WEIGHTED>
+void LouvainHOST::gatherNeighborComms(unsigned int node) {
+
+    for (unsigned long e = curOffsets[node]; e < curOffsets[node + 1]; e++) {
+        unsigned int nbr = curLinks[e];
+        if (nbr == node)
+            continue;
+        int c = n2c[nbr];
+        if (neighWeight[c] < 0) {
+            neighWeight[c] = 0;
+            touched.push_back(c);
+        }
+        neighWeight[c] += IS_WEIGHTED ? curWeights[e] : 1.0;
+    }
+}
+
+void LouvainHOST::resetTouched() {
+
+    for (unsigned int i = 0; i < touched.size(); i++)
+        neighWeight[touched[i]] = -1.0;
+    touched.clear();
+}
+
+template<bool IS_WEIGHTED>
+long LouvainHOST::sweep() {
+
+    long nrMoves = 0;
+    double m2 = total_weight;
+
+    for (unsigned int i = 0; i < nb_nodes; i++) {
+
+        unsigned int node = seed ? order[i] : i;
+        int comm = n2c[node];
+        double wdeg = wDegs[node];
+
+        gatherNeighborComms<IS_WEIGHTED>(node);
+        double toOwn = neighWeight[comm] < 0 ? 0 : neighWeight[comm];
+
+        // remove node from its community
+        tot[comm] -= wdeg;
+        in[comm] -= 2 * toOwn + selfLoops[node];
+
+        int best = comm;
+        double bestGain = toOwn - tot[comm] * wdeg / m2;
+
+        for (unsigned int i = 0; i < touched.size(); i++) {
+            int c = touched[i];
+            double gain = neighWeight[c] - tot[c] * wdeg / m2;
+            if (gain > bestGain || (gain == bestGain && c < best)) {
+                bestGain = gain;
+                best = c;
+            }
+        }
+
+        double toBest = neighWeight[best] < 0 ? 0 : neighWeight[best];
+        tot[best] += wdeg;
+        in[best] += 2 * toBest + selfLoops[node];
+        n2c[node] = best;
+
+        nrMoves += (best != comm);
+        resetTouched();
+    }
+    return nrMoves;
+}
+
+long LouvainHOST::oneLevel(double threshold) {
+
+    for (unsigned int node = 0; node < nb_nodes; node++) {
+        double wdeg = 0, self = 0;
+        if (shared) {
+            wdeg = sharedWDegs[node];
+            self = shared->selfLoops[node];
+        } else {
+            for (unsigned long e = curOffsets[node]; e < curOffsets[node + 1]; e++) {
+                wdeg += curWeights[e];
+                if (curLinks[e] == node)
+                    self += curWeights[e];
+            }
+        }
+        n2c[node] = node;
+        wDegs[node] = tot[node] = wdeg;
+        selfLoops[node] = in[node] = self;
+    }
+
+    // A new visiting order for every level of a seeded instance
+    if (seed) {
+        for (unsigned int node = 0; node < nb_nodes; node++)
+            order[node] = node;
+        std::mt19937 rng(seed + levelModularity.size());
+        std::shuffle(order.begin(), order.begin() + nb_nodes, rng);
+    }
+
+    // Instance chosen once per level
+    long (LouvainHOST::*sweepOfLevel)() = weighted ? &LouvainHOST::sweep<true> : &LouvainHOST::sweep<false>;
+
+    double cur_mod = modularity(), new_mod = cur_mod;
+    long totalMoves = 0;
+    int nrSweeps = 0;
+
+    do {
+        cur_mod = new_mod;
+        nrSweeps++;
+
+        long nrMoves = (this->*sweepOfLevel)();
+
+        totalMoves += nrMoves;
+        new_mod = modularity();
+
+        if (!nrMoves)
+            break;
+    } while (new_mod - cur_mod > threshold);
+
+    levelModularity.push_back(new_mod);
+    levelSweeps.push_back(nrSweeps);
+    levelMoves.push_back(totalMoves);
+
+    return totalMoves;
+}
+
+void LouvainHOST::contract() {
+
+    // Renumber communities and bucket vertices by community (counting sort)
+    std::vector<int>& renumber = touched; // free between sweeps
+    renumber.assign(nb_nodes, -1);
+    int nrComm = 0;
+    for (unsigned int node = 0; node < nb_nodes; node++) {
+        if (renumber[n2c[node]] < 0)
+            renumber[n2c[node]] = nrComm++;
+    }
+
+    nextOffsets.resize(nb_nodes + 1);
+    std::vector<unsigned long>& commStart = nextOffsets;
+    std::fill(commStart.begin(), commStart.begin() + nrComm + 1, 0);
+    for (unsigned int node = 0; node < nb_nodes; node++) {
+        n2c[node] = renumber[n2c[node]];
+        commStart[n2c[node] + 1]++;
+    }
+    for (int c = 0; c < nrComm; c++)
+        commStart[c + 1] += commStart[c];
+    for (unsigned int node = 0; node < nb_nodes; node++)
+        order[commStart[n2c[node]]++] = node;
+
+    dendrogram.addLevel(std::vector<int>(n2c.begin(), n2c.begin() + nb_nodes));
+    touched.clear();
+
+    // One neighborhood per community, merged through the dense array; the
+    // buffers keep their capacity, so only a shared level 0 makes them grow
+    nextLinks.clear();
+    nextWeights.clear();
+    unsigned long nrLinks = 0;
+    unsigned int pos = 0;
+    for (int c = 0; c < nrComm; c++) {
+
+        nextOffsets[c] = nrLinks;
+        for (; pos < nb_nodes && n2c[order[pos]] == c; pos++) {
+            unsigned int node = order[pos];
+            for (unsigned long e = curOffsets[node]; e < curOffsets[node + 1]; e++) {
+                int nc = n2c[curLinks[e]];
+                if (neighWeight[nc] < 0) {
+                    neighWeight[nc] = 0;
+                    touched.push_back(nc);
+                }
+                neighWeight[nc] += curWeights ? curWeights[e] : 1.0f;
+            }
+        }
+
+        for (unsigned int i = 0; i < touched.size(); i++) {
+            nextLinks.push_back(touched[i]);
+            nextWeights.push_back((float) neighWeight[touched[i]]);
+            nrLinks++;
+        }
+        resetTouched();
+    }
+    nextOffsets[nrComm] = nrLinks;
+
+    nb_nodes = nrComm;
+    weighted = true;
+    offsets.swap(nextOffsets);
+    links.swap(nextLinks);
+    weights.swap(nextWeights);
+
+    shared = NULL;
+    bindCurrent();
+}
+
+static double secondsSince(const struct timespec& begin) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - begin.tv_sec) + (now.tv_nsec - begin.tv_nsec) / 1.0e9;
+}
+
+double LouvainHOST::run(double threshold, int maxLevels, double budget) {
+
+    double prev_mod = -1.0;
+    double secondsPerLink = 0;
+    struct timespec runStart;
+    clock_gettime(CLOCK_MONOTONIC, &runStart);
+    budgetHit = false;
+
+    for (int level = 0; level < maxLevels; level++) {
+
+        double levelBegin = secondsSince(runStart);
+        unsigned long nrLinks = curOffsets[nb_nodes];
+
+        if (budget > 0 && level > 0 && levelBegin + secondsPerLink * nrLinks > budget) {
+            budgetHit = true;
+            LOG(LOG_INFO, "Reference level " << level << ": stopped for the budget of " << budget << " sec");
+            return prev_mod;
+        }
+
+        long nrMoves = oneLevel(threshold);
+        double cur_mod = levelModularity.back();
+
+        LOG(LOG_INFO, "Reference level " << level << ": #V " << nb_nodes << " #E " << curOffsets[nb_nodes]
+                << " Modularity " << cur_mod << " #Sweeps " << levelSweeps.back() << " #Moves " << nrMoves);
+
+        if (!nrMoves)
+            return cur_mod;
+
+        contract();
+        secondsPerLink = (secondsSince(runStart) - levelBegin) / std::max(nrLinks, 1UL);
+
+        if (cur_mod - prev_mod <= threshold)
+            return cur_mod;
+        prev_mod = cur_mod;
+    }
+    return prev_mod;
+}
@@ -0,0 +1,125 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#ifndef LOUVAINHOST_H
+#define	LOUVAINHOST_H
+
+#include"graphHOST.h"
+#include"dendrogramHOST.h"
+#include"vector"
+
+// Level 0 shared by the instances of an ensemble: the input CSR, read in
+// place, with the weighted degrees and self-loops computed once
+
+struct SharedLevelHOST {
+    unsigned int nb_nodes;
+    std::vector<unsigned long> offsets; // nb_nodes + 1
+    const unsigned int* links;
+    const float* weights; // NULL: unweighted input
+    std::vector<double> wDegs, selfLoops;
+    double total_weight;
+
+    SharedLevelHOST(const GraphHOST& input_graph);
+};
+
+// Single-threaded Louvain on a GraphHOST, as reference result and as
+// baseline for speedups. Weights from a vertex to its neighboring
+// communities are gathered in a dense array that is reset through the list
+// of touched entries; each level is contracted into the CSR buffers
+// allocated for the input, so no allocation happens after construction.
+
+struct LouvainHOST {
+    // Graph of the current level; self-loops hold the internal weight
+    unsigned int nb_nodes;
+    std::vector<unsigned long> offsets; // nb_nodes + 1
+    std::vector<unsigned int> links;
+    std::vector<float> weights;
+    double total_weight;
+    bool weighted; // false only for the first level of an unweighted input
+
+    std::vector<int> n2c;
+    std::vector<double> tot, in, wDegs, selfLoops;
+
+    // Per level: modularity at the end, #sweeps and #moves
+    std::vector<double> levelModularity;
+    std::vector<int> levelSweeps;
+    std::vector<long> levelMoves;
+
+    Dendrogram dendrogram;
+
+    LouvainHOST(const GraphHOST& input_graph);
+
+    // Empty CSR of the given size, filled in place by the caller (e.g. a
+    // level handed over by the device); links of an unweighted graph
+    // weigh 1
+    LouvainHOST(unsigned int nrNodes, unsigned long nrLinks, bool isWeighted, double totalWeight);
+
+    // Instance of an ensemble: level 0 is read from shared, only the state
+    // and the contracted levels are its own (their buffers grow during the
+    // first contraction). A non-zero seed visits the vertices of each level
+    // in a random order drawn from it. levelWDegs is a copy of
+    // shared.wDegs to read instead (e.g. the replica of the worker's NUMA
+    // node); NULL: shared.wDegs
+    LouvainHOST(const SharedLevelHOST& shared, unsigned int seed, const double* levelWDegs = NULL);
+    unsigned int seed; // 0: natural order
+
+    double modularity() const;
+
+    // Local moving until a sweep gains less than threshold; returns #moves
+    long oneLevel(double threshold);
+
+    // Replace the graph by its community graph and record the level
+    void contract();
+
+    // Returns the final modularity. With a budget (seconds, 0: none) no
+    // level is started that would end after it, predicted from the time per
+    // link of the last level; the contracted levels so far are the result
+    double run(double threshold, int maxLevels, double budget = 0);
+    bool budgetHit; // the last run() gave up a level for its budget
+
+private:
+    // CSR the sweeps read: the vectors above, or the shared level 0
+    const unsigned long* curOffsets;
+    const unsigned int* curLinks;
+    const float* curWeights; // NULL: all links weigh 1
+    const SharedLevelHOST* shared; // NULL once contracted
+    const double* sharedWDegs; // weighted degrees of the shared level 0
+
+    std::vector<double> neighWeight; // < 0: untouched
+    std::vector<int> touched;
+
+    // Contraction target, swapped with the current graph
+    std::vector<unsigned long> nextOffsets;
+    std::vector<unsigned int> nextLinks;
+    std::vector<float> nextWeights;
+    std::vector<int> order;
+
+    // Unweighted instances never read weights
+    template<bool IS_WEIGHTED> void gatherNeighborComms(unsigned int node);
+    template<bool IS_WEIGHTED> long sweep();
+    void resetTouched();
+    void allocateWork();
+    void bindCurrent();
+};
+
+#endif	/* LOUVAINHOST_H */
@@ -36,15 +36,72 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cmath>
 
 #include"fstream"
 #include "iostream"
 #include "graphHOST.h"
 #include "graphGPU.h"
 #include "communityGPU.h"
+#include "louvainHOST.h"
+#include "ensembleHOST.h"
 #include"list"
 
 using namespace std;
+
+// Seconds until the modularity in trace first reaches target, -1 if never
+static double timeToReach(const std::vector<std::pair<double, double> >& trace, double target) {
+	for (unsigned int i = 0; i < trace.size(); i++) {
+		if (trace[i].second >= target)
+			return trace[i].first;
+	}
+	return -1;
+}
+
+// Kernel time per processed vertex of bins [firstBin, lastBin] in a baseline
+// and the timed run; both runs may take a different number of sweeps
+static void compareBinTimes(const string& logName, const string& graph, int weighted,
+		const string& baseLabel, const string& newLabel,
+		const Telemetry& baseline, const Telemetry& timed, int firstBin, int lastBin) {
+
+	ofstream binLog;
+	ifstream binInfile(logName);
+	bool existingBinLog = binInfile.good();
+	binLog.open(logName, ios_base::out | ios_base::app | ios_base::ate);
+	if (!existingBinLog) {
+		binLog << "GraphName,Weighted,Bin," << baseLabel << " Time(ms)," << baseLabel << " Vertices,"
+			<< newLabel << " Time(ms)," << newLabel << " Vertices,Gain(%)" << std::endl;
+	}
+
+	for (int bin = firstBin; bin <= lastBin; bin++) {
+		double baseMs = 0, newMs = 0;
+		long baseVertices = 0, newVertices = 0;
+		for (size_t i = 0; i < baseline.bins.size(); i++) {
+			if (baseline.bins[i].bin != bin)
+				continue;
+			baseMs += baseline.bins[i].milliseconds;
+			baseVertices += baseline.bins[i].nrVertices;
+		}
+		for (size_t i = 0; i < timed.bins.size(); i++) {
+			if (timed.bins[i].bin != bin)
+				continue;
+			newMs += timed.bins[i].milliseconds;
+			newVertices += timed.bins[i].nrVertices;
+		}
+		if (!baseVertices || !newVertices)
+			continue;
+
+		double gain = 100.0 * (1.0 - (newMs / newVertices) / (baseMs / baseVertices));
+
+		binLog << graph << "," << weighted << "," << binNames[bin] << "," << baseMs << "," << baseVertices << ","
+			<< newMs << "," << newVertices << "," << gain << std::endl;
+
+		LOG(LOG_SUMMARY, "Bin " << binNames[bin] << ": " << baseLabel << " " << baseMs << " ms / " << baseVertices
+			<< " vertices, " << newLabel << " " << newMs << " ms / " << newVertices
+			<< " vertices, gain " << gain << "%");
+	}
+}
+
 int main(int argc, char** argv) {
 
 
@@ -59,30 +116,190 @@ int main(int argc, char** argv) {
 	if (!existing_file) {
 		logFile << "GraphName" << "," << "Total Time" << "," << "Modularity" << std::endl;
 	}
+
+	// Options of the form --name[=value] may appear anywhere; the remaining
+	// arguments keep their positional meaning
+	bool numaPlacement = false, numaReport = false;
+	int nrHostThreads = 0;
+	int reclusterSize = 0, reclusterJobs = 4;
+	double sampleFraction = 1.0, sampleBudget = 0.5;
+	bool sampleByDegree = false, sampleCompare = false;
+	unsigned int sampleSeed = 0;
+	int sampleLevels = 1;
+	string telemetryPrefix;
+	bool deterministic = false, deterministicCompare = false;
+	bool runReference = false;
+	bool genericKernels = false, specializeCompare = false;
+	bool registerKernels = true, registerCompare = false;
+	int denseBudgetMB = DENSE_TABLE_BUDGET_MB;
+	int warmStartRounds = 0;
+	bool warmStartContract = false, warmStartCompare = false;
+	long hostCutover = 0;
+	size_t memoryBudgetMB = 0;
+	bool memoryReport = false;
+	bool componentSolve = false;
+	int componentTiny = COMPONENT_TINY_SIZE, componentBatch = COMPONENT_BATCH_SIZE, componentJobs = 4;
+	string cacheDir;
+	size_t cacheLimitMB = GRAPH_CACHE_LIMIT_MB;
+	bool pipelinedLoad = false;
+	int miniBatches = 1;
+	bool jacobi = false;
+	std::vector<int> batchCompare;
+	bool bucketCompare = false;
+	double deadlineSeconds = 0;
+	std::vector<double> deadlineCurve;
+	int ensembleRuns = 0;
+	string ensemblePrefix, coAssociationFile;
+	bool ensembleScaling = false;
+	std::vector<char*> positionalArgs(1, argv[0]);
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--numa")
+			numaPlacement = true;
+		else if (arg == "--numa-report")
+			numaReport = true;
+		else if (arg.compare(0, 10, "--threads=") == 0)
+			nrHostThreads = atoi(arg.c_str() + 10);
+		else if (arg.compare(0, 12, "--recluster=") == 0)
+			reclusterSize = atoi(arg.c_str() + 12);
+		else if (arg.compare(0, 17, "--recluster-jobs=") == 0)
+			reclusterJobs = atoi(arg.c_str() + 17);
+		else if (arg.compare(0, 9, "--sample=") == 0)
+			sampleFraction = atof(arg.c_str() + 9);
+		else if (arg == "--sample-degree")
+			sampleByDegree = true;
+		else if (arg.compare(0, 14, "--sample-seed=") == 0)
+			sampleSeed = strtoul(arg.c_str() + 14, NULL, 10);
+		else if (arg.compare(0, 16, "--sample-levels=") == 0)
+			sampleLevels = atoi(arg.c_str() + 16);
+		else if (arg.compare(0, 16, "--sample-budget=") == 0)
+			sampleBudget = atof(arg.c_str() + 16);
+		else if (arg == "--sample-compare")
+			sampleCompare = true;
+		else if (arg.compare(0, 12, "--telemetry=") == 0)
+			telemetryPrefix = arg.substr(12);
+		else if (arg == "--deterministic")
+			deterministic = true;
+		else if (arg == "--deterministic-compare")
+			deterministic = deterministicCompare = true;
+		else if (arg == "--reference")
+			runReference = true;
+		else if (arg == "--generic-kernels")
+			genericKernels = true;
+		else if (arg == "--specialize-compare")
+			specializeCompare = true;
+		else if (arg == "--table-kernels")
+			registerKernels = false;
+		else if (arg == "--register-compare")
+			registerCompare = true;
+		else if (arg.compare(0, 15, "--dense-budget=") == 0)
+			denseBudgetMB = atoi(arg.c_str() + 15);
+		else if (arg.compare(0, 13, "--warm-start=") == 0)
+			warmStartRounds = atoi(arg.c_str() + 13);
+		else if (arg == "--warm-contract")
+			warmStartContract = true;
+		else if (arg == "--warm-compare")
+			warmStartCompare = true;
+		else if (arg == "--hybrid")
+			hostCutover = -1;
+		else if (arg.compare(0, 15, "--host-cutover=") == 0)
+			hostCutover = atol(arg.c_str() + 15);
+		else if (arg.compare(0, 16, "--memory-budget=") == 0)
+			memoryBudgetMB = strtoul(arg.c_str() + 16, NULL, 10);
+		else if (arg == "--memory-report")
+			memoryReport = true;
+		else if (arg == "--components")
+			componentSolve = true;
+		else if (arg.compare(0, 17, "--component-tiny=") == 0)
+			componentTiny = atoi(arg.c_str() + 17);
+		else if (arg.compare(0, 18, "--component-batch=") == 0)
+			componentBatch = atoi(arg.c_str() + 18);
+		else if (arg.compare(0, 17, "--component-jobs=") == 0)
+			componentJobs = atoi(arg.c_str() + 17);
+		else if (arg.compare(0, 8, "--cache=") == 0)
+			cacheDir = arg.substr(8);
+		else if (arg.compare(0, 14, "--cache-limit=") == 0)
+			cacheLimitMB = strtoul(arg.c_str() + 14, NULL, 10);
+		else if (arg == "--pipelined-load")
+			pipelinedLoad = true;
+		else if (arg.compare(0, 10, "--batches=") == 0)
+			miniBatches = (arg.substr(10) == "auto") ? 0 : std::max(1, atoi(arg.c_str() + 10));
+		else if (arg == "--jacobi")
+			jacobi = true;
+		else if (arg.compare(0, 16, "--batch-compare=") == 0) {
+			// e.g. 1,2,4,auto
+			std::stringstream counts(arg.substr(16));
+			string count;
+			while (std::getline(counts, count, ','))
+				if (count.size())
+					batchCompare.push_back(count == "auto" ? 0 : std::max(1, atoi(count.c_str())));
+		}
+		else if (arg == "--bucket-compare")
+			bucketCompare = true;
+		else if (arg.compare(0, 11, "--ensemble=") == 0)
+			ensembleRuns = std::max(0, atoi(arg.c_str() + 11));
+		else if (arg.compare(0, 15, "--ensemble-out=") == 0)
+			ensemblePrefix = arg.substr(15);
+		else if (arg.compare(0, 17, "--co-association=") == 0)
+			coAssociationFile = arg.substr(17);
+		else if (arg == "--ensemble-scaling")
+			ensembleScaling = true;
+		else if (arg.compare(0, 11, "--deadline=") == 0)
+			deadlineSeconds = std::max(0.0, atof(arg.c_str() + 11));
+		else if (arg.compare(0, 17, "--deadline-curve=") == 0) {
+			// deadlines in seconds, e.g. 0.05,0.1,0.5
+			std::stringstream limits(arg.substr(17));
+			string limit;
+			while (std::getline(limits, limit, ','))
+				if (limit.size())
+					deadlineCurve.push_back(atof(limit.c_str()));
+		}
+		else if (arg.compare(0, 6, "--log=") == 0 && parseLogLevel(arg.substr(6)) >= 0)
+			setLogLevel(parseLogLevel(arg.substr(6)));
+		else
+			positionalArgs.push_back(argv[i]);
+	}
+	argc = positionalArgs.size();
+	argv = &positionalArgs[0];
+
 	string graphName = argv[1];
 
 
-	std::cout << "#Args: " << argc << std::endl;
+	LOG(LOG_DEBUG, "#Args: " << argc);
 	for (int i = 0; i < argc; i++) {
-		std::cout << i << " : " << argv[i] << std::endl;
+		LOG(LOG_DEBUG, i << " : " << argv[i]);
 	}
 
 	if (argc == 3) {
 		file_w = argv[2];
 		type = WEIGHTED;
 		if (type == WEIGHTED)
-			std::cout << "Weighted Graph \n";
+			LOG(LOG_INFO, "Weighted Graph ");
 	}
 
 	if (file_w)
-		std::cout << "inputGraph: " << argv[1] << " Corresponding Weight: " << file_w << std::endl;
+		LOG(LOG_INFO, "inputGraph: " << argv[1] << " Corresponding Weight: " << file_w);
 	else if (argc==2)
-		std::cout << "inputGraph: " << argv[1] << std::endl;
+		LOG(LOG_INFO, "inputGraph: " << argv[1]);
 	else 
-		std::cout<<"No input graph provided, creating a sample graph"<<std::endl;
-
-	// Read Graph in  host memory
-	GraphHOST input_graph(argv[1], file_w, type);
+		LOG(LOG_INFO, "No input graph provided, creating a sample graph");
+
+	// Read Graph in  host memory, or map it with its level-0 bins from the cache
+	GraphHOST input_graph;
+	LevelZeroData levelZero;
+
+	if (cacheDir.size()) {
+		GraphCache cache(cacheDir, cacheLimitMB << 20);
+		bool hit = cache.fetch(argv[1], file_w, type, input_graph, levelZero);
+		LOG(LOG_INFO, "Graph cache " << (hit ? "hit" : "miss") << " in " << cacheDir);
+	} else if (pipelinedLoad) {
+		int nrLoadWorkers = nrHostThreads > 0 ? nrHostThreads : std::max(1, (int) std::thread::hardware_concurrency() - 1);
+		if (!input_graph.loadPipelined(argv[1], file_w, type, nrLoadWorkers))
+			return 1;
+	} else {
+		input_graph = GraphHOST(argv[1], file_w, type);
+	}
 
 	//Create a graph in host memory
 	/*GraphHOST input_graph; // Sample graph
@@ -100,23 +317,121 @@ int main(int argc, char** argv) {
 
 	}*/
 
-	input_graph.display();
+	// Prints every adjacency list
+	if (LOG_ENABLED(LOG_TRACE))
+		input_graph.display();
+
+	// --numa places the CSR on the nodes of the host workers that read it;
+	// an ensemble also pins its workers per node, each reading the weighted
+	// degrees from the replica of its node. Placement is skipped when the
+	// CSR is only copied to the device.
+	bool hostReadsGraph = numaReport || ensembleRuns > 0 || runReference;
+
+	NumaTopology topo;
+	if (numaPlacement || numaReport) {
+		topo.display();
+		if (numaPlacement && hostReadsGraph)
+			input_graph.placeOnNumaNodes(topo);
+		else if (numaPlacement)
+			LOG(LOG_WARN, "--numa: the graph only goes to the device, placement skipped");
+		if (numaReport) {
+			input_graph.reportLocality(topo);
+			input_graph.benchmarkNumaScaling(topo, nrHostThreads > 0 ? nrHostThreads : topo.nrCpus());
+		}
+	}
 
 	double threshold = 0.000001;
 	if(argc==4) threshold = atof(argv[2]);
 	double binThreshold = 0.01;
 	if(argc==4) binThreshold=atof(argv[3]);
 	//binThreshold=threshold;
+
+	// Ensemble mode: seeded host runs on the loaded CSR, nothing goes to
+	// the device
+	if (ensembleRuns > 0) {
+
+		EnsembleHOST ensemble(input_graph);
+		ensemble.partitionPrefix = ensemblePrefix;
+		ensemble.coAssociate = coAssociationFile.size() > 0;
+		if (numaPlacement)
+			ensemble.topo = &topo;
+
+		int cores = std::max(1, (int) std::thread::hardware_concurrency());
+		int nrJobs = std::min(nrHostThreads > 0 ? nrHostThreads : cores, ensemble.maxJobs(0));
+		LOG(LOG_INFO, "Ensemble: " << ensembleRuns << " runs on " << nrJobs << " threads");
+
+		ofstream ensembleLog;
+		string ensembleLogName = "Log/louvain_method_gpu_ensemble.csv";
+		ifstream ensembleInfile(ensembleLogName);
+		bool existingEnsembleLog = ensembleInfile.good();
+		ensembleLog.open(ensembleLogName, ios_base::out | ios_base::app | ios_base::ate);
+		if (!existingEnsembleLog)
+			ensembleLog << "GraphName,Runs,Jobs,Time,Runs Per Sec,Mean Modularity,Best Modularity" << std::endl;
+
+		// One wave of j concurrent runs per j = 1, 2, 4, ..; then the ensemble
+		std::vector<int> waves;
+		for (int j = 1; ensembleScaling && j < nrJobs; j *= 2)
+			waves.push_back(j);
+		waves.push_back(nrJobs);
+
+		for (size_t w = 0; w < waves.size(); w++) {
+
+			bool last = (w + 1 == waves.size());
+			int nrRuns = last ? ensembleRuns : waves[w];
+			ensemble.coAssociate = last && coAssociationFile.size();
+			double seconds = ensemble.run(nrRuns, waves[w], 1, threshold, 33);
+
+			double meanMod = 0;
+			for (int r = 0; r < nrRuns; r++)
+				meanMod += ensemble.modularity[r] / nrRuns;
+			double bestMod = *std::max_element(ensemble.modularity.begin(), ensemble.modularity.end());
+
+			ensembleLog << graphName.substr (6, (graphName.length() - 10)) << "," << nrRuns << "," << waves[w]
+				<< "," << 1000 * seconds << "," << nrRuns / seconds << "," << meanMod << "," << bestMod << std::endl;
+
+			LOG(LOG_SUMMARY, "Ensemble " << nrRuns << " runs, " << waves[w] << " threads: Time(ms): "
+				<< 1000 * seconds << " Runs/sec: " << nrRuns / seconds
+				<< " Modularity mean: " << meanMod << " best: " << bestMod);
+		}
+
+		if (coAssociationFile.size()) {
+			double meanAgreement = ensemble.writeCoAssociation(coAssociationFile);
+			LOG(LOG_SUMMARY, "Co-association of " << ensembleRuns << " runs written to " << coAssociationFile
+				<< ", mean over links: " << meanAgreement);
+		}
+		return 0;
+	}
+
 	//Copy Graph to Device
 	Community dev_community(input_graph, -1, threshold);
-	double cur_mod = -1.0, prev_mod = 1.0;
-	bool improvement = false;
+	if (levelZero.nbNodes)
+		dev_community.levelZero = &levelZero;
+	double prev_mod = 1.0;
 
-	std::cout << "threshold: " << threshold << " binThreshold: " << binThreshold << std::endl;
+	LOG(LOG_INFO, "threshold: " << threshold << " binThreshold: " << binThreshold);
 
 	//Read Prime numbers
 	dev_community.readPrimes("fewprimes.txt");
 
+	// Settings of the timed run; the comparison runs below start from them
+	// (configureLike) and change only the setting they measure
+	dev_community.deadline.limit = deadlineSeconds;
+	dev_community.deterministic = deterministic;
+	dev_community.genericKernels = genericKernels && !specializeCompare;
+	dev_community.registerKernels = registerKernels || registerCompare;
+	dev_community.denseTableBudget = (size_t) denseBudgetMB << 20;
+	dev_community.warmStartRounds = warmStartRounds;
+	dev_community.warmStartContract = warmStartContract;
+	dev_community.hostCutover = hostCutover;
+	dev_community.memory.budget = memoryBudgetMB << 20;
+	dev_community.miniBatches = miniBatches;
+
+	dev_community.sampleFraction = sampleFraction;
+	dev_community.sampleByDegree = sampleByDegree;
+	dev_community.sampleSeed = sampleSeed;
+	dev_community.sampleLevels = sampleLevels;
+	dev_community.sampleBudget = sampleBudget;
+
 	cudaStream_t *streams = NULL;
 	int n_streams = 8;
 
@@ -128,7 +443,7 @@ int main(int argc, char** argv) {
 	std::vector<clock_t> clkList_decision;
 	std::vector<clock_t> clkList_contration;
 
-	clock_t t1, t2, t3;
+	clock_t t1, t2;
 	t1 = clock();
 
 	time_t time_begin, time_end;
@@ -142,84 +457,221 @@ int main(int argc, char** argv) {
 				dev_community.compute_next_graph();
 				dev_community.set_new_graph_as_current();
 	 */
-	bool TEPS = true;
-	bool islastRound = false;
 	int szSmallComm = 100000;
-	bool isGauss =true;// false;
+	bool isGauss = !jacobi;
 
 	if(isGauss)
-		std::cout<<"\n Update method:  Gauss–Seidel (in batch) \n";
+		LOG(LOG_INFO, " Update method:  Gauss–Seidel (in batch) ");
 	else
-		std::cout<<"\n Update method: Jacobi\n";
+		LOG(LOG_INFO, " Update method: Jacobi");
+
+	if (isGauss && miniBatches != 1)
+		LOG(LOG_INFO, " Mini-batches per bin: " << (miniBatches ? std::to_string(miniBatches) : string("auto")));
 
-	int stepID = 1;
 	int max_iteration = 33;
 
-	do {
+	// Sequential run on the same loaded graph: baseline for the speedup and
+	// reference modularity
+	double referenceMod = 0, referenceTime = 0;
+
+	if (runReference) {
+		clock_gettime(CLOCK_MONOTONIC, &start_comm);
+		LouvainHOST reference(input_graph);
+		referenceMod = reference.run(threshold, max_iteration);
+
+		clock_gettime(CLOCK_MONOTONIC, &end_comm);
+		referenceTime = ((end_comm.tv_sec*1000 + (end_comm.tv_nsec/1.0e6)) - (start_comm.tv_sec*1000 + (start_comm.tv_nsec/1.0e6)));
+
+		LOG(LOG_SUMMARY, "Reference: #Levels " << reference.dendrogram.nrLevels() << " #Communities "
+			<< reference.dendrogram.nrCommunities() << " Modularity " << referenceMod
+			<< " Time(ms): " << referenceTime);
+
+		clock_gettime(CLOCK_MONOTONIC, &start_comm);
+	}
+
+	// Full-sweep reference run for the sampling benchmark
+	std::vector<std::pair<double, double> > baselineTrace;
+	double baselineMod = 0, baselineTime = 0;
+
+	if (sampleCompare && sampleFraction < 1.0) {
+		Community baseline(input_graph, -1, threshold);
+		baseline.configureLike(dev_community);
+		baseline.sampleFraction = 1.0;
 
-		std::cout << "---------------Calling method for modularity optimization------------- \n";
-		t2 = clock();
-		prev_mod = cur_mod;
+		std::vector<clock_t> clkBaseDecision, clkBaseContraction;
+		baselineMod = baseline.run(threshold, binThreshold, szSmallComm, isGauss,
+				max_iteration, streams, n_streams, start, stop,
+				clkBaseDecision, clkBaseContraction);
 
-		cur_mod = dev_community.one_levelGaussSeidel(cur_mod, islastRound,
-				szSmallComm, binThreshold, isGauss &&(dev_community.community_size > szSmallComm),
-				streams, n_streams, start, stop);
+		baselineTrace = baseline.modularityTrace;
 
-		t2 = clock() - t2;
+		clock_gettime(CLOCK_MONOTONIC, &end_comm);
+		baselineTime = ((end_comm.tv_sec*1000 + (end_comm.tv_nsec/1.0e6)) - (start_comm.tv_sec*1000 + (start_comm.tv_nsec/1.0e6)));
 
-		clkList_decision.push_back(t2); // push the clock for the decision
+		clock_gettime(CLOCK_MONOTONIC, &start_comm);
+	}
 
-		std::cout<< "step: " <<stepID <<", Time for modularity optimization: " << ((float) t2) / CLOCKS_PER_SEC << std::endl;
-		stepID++;
-		if (TEPS == true) {
-			std::cout<<binThreshold<<"_"<<threshold<< " #E:" <<  dev_community.g.nb_links << "  TEPS: " << dev_community.g.nb_links / (((float) t2) / CLOCKS_PER_SEC) << std::endl;
-			TEPS = false;
+	// Default-mode run for the overhead, and a second deterministic run whose
+	// partition must match the one of the timed run below
+	double defaultMod = 0, defaultTime = 0, repeatMod = 0;
+	std::vector<int> repeatPartition;
+
+	if (deterministicCompare) {
+		for (int mode = 0; mode < 2; mode++) {
+			Community reference(input_graph, -1, threshold);
+			reference.configureLike(dev_community);
+			reference.keepDendrogram = true;
+			reference.deterministic = (mode == 1);
+
+			std::vector<clock_t> clkRefDecision, clkRefContraction;
+			double mod = reference.run(threshold, binThreshold, szSmallComm, isGauss,
+					max_iteration, streams, n_streams, start, stop,
+					clkRefDecision, clkRefContraction);
+
+			clock_gettime(CLOCK_MONOTONIC, &end_comm);
+			if (mode == 0) {
+				defaultMod = mod;
+				defaultTime = ((end_comm.tv_sec*1000 + (end_comm.tv_nsec/1.0e6)) - (start_comm.tv_sec*1000 + (start_comm.tv_nsec/1.0e6)));
+			} else {
+				repeatMod = mod;
+				repeatPartition = reference.dendrogram.flatten();
+			}
+			clock_gettime(CLOCK_MONOTONIC, &start_comm);
 		}
+	}
+
+	// Run with the generic kernels; its per-bin kernel times are compared
+	// with those of the specialized timed run below
+	Telemetry genericTelemetry;
 
-		//break;
-		std::cout << "Computed modularity: " << cur_mod << " ( init_mod = " << prev_mod << " ) " << std::endl;
+	if (specializeCompare) {
+		Community reference(input_graph, -1, threshold);
+		reference.configureLike(dev_community);
+		reference.genericKernels = true;
+		reference.telemetry = &genericTelemetry;
 
-		if ((cur_mod - prev_mod) > threshold && stepID<=max_iteration) {
+		std::vector<clock_t> clkRefDecision, clkRefContraction;
+		reference.run(threshold, binThreshold, szSmallComm, isGauss,
+				max_iteration, streams, n_streams, start, stop,
+				clkRefDecision, clkRefContraction);
 
-			t2 = clock();   
-			t3 = t2;
-			dev_community.gatherStatistics();
-			t2 = clock() - t2;
-			//std::cout << "T_gatherStatistics: " << ((float) t2) / CLOCKS_PER_SEC << std::endl;
+		clock_gettime(CLOCK_MONOTONIC, &start_comm);
+	}
 
-			t2 = clock();
-			dev_community.compute_next_graph(streams, n_streams, start, stop);
-			t2 = clock() - t2;
-			std::cout << "Time to compute next graph: " << ((float) t2) / CLOCKS_PER_SEC << std::endl;
+	// Run with the table kernels in the bins of at most 8 neighbors, against
+	// the register kernels of the timed run below
+	Telemetry tableTelemetry;
 
-			//clkList_contration.push_back(t2); // push the clock for the contraction
+	if (registerCompare) {
+		Community reference(input_graph, -1, threshold);
+		reference.configureLike(dev_community);
+		reference.registerKernels = false;
+		reference.telemetry = &tableTelemetry;
 
-			t2 = clock();
-			dev_community.set_new_graph_as_current();
-			t2 = clock() - t2;
-			t3 = clock() -t3;
+		std::vector<clock_t> clkRefDecision, clkRefContraction;
+		reference.run(threshold, binThreshold, szSmallComm, isGauss,
+				max_iteration, streams, n_streams, start, stop,
+				clkRefDecision, clkRefContraction);
 
-			clkList_contration.push_back(t3); // push the clock for the contraction
+		clock_gettime(CLOCK_MONOTONIC, &start_comm);
+	}
 
-			//std::cout << "T_new_graph_as_current: " << ((float) t2) / CLOCKS_PER_SEC << std::endl;
-			// break;
+	// Cold start (singletons) against the warm start of the timed run below
+	double coldMod = 0, coldTime = 0;
 
-			//std::cout << "\n Back to Main \n";
-			//int sc;
-			//std::cin>>sc;
+	if (warmStartCompare && warmStartRounds > 0) {
+		Community cold(input_graph, -1, threshold);
+		cold.configureLike(dev_community);
+		cold.warmStartRounds = 0;
 
+		std::vector<clock_t> clkColdDecision, clkColdContraction;
+		coldMod = cold.run(threshold, binThreshold, szSmallComm, isGauss,
+				max_iteration, streams, n_streams, start, stop,
+				clkColdDecision, clkColdContraction);
 
-		} else {
-			if (islastRound == false) {
-				islastRound = true;
-			} else {
-				break;
-			}
-		}
-		//improvement = false;
-	} while (true);
+		clock_gettime(CLOCK_MONOTONIC, &end_comm);
+		coldTime = ((end_comm.tv_sec*1000 + (end_comm.tv_nsec/1.0e6)) - (start_comm.tv_sec*1000 + (start_comm.tv_nsec/1.0e6)));
+
+		clock_gettime(CLOCK_MONOTONIC, &start_comm);
+	}
+
+	// One run per mini-batch count; sweeps and time to convergence are
+	// compared with those of the timed run below
+	std::vector<int> batchSweeps;
+	std::vector<double> batchMods, batchTimes;
+
+	for (size_t c = 0; c < batchCompare.size(); c++) {
+		Community batched(input_graph, -1, threshold);
+		batched.configureLike(dev_community);
+		batched.miniBatches = batchCompare[c];
+
+		std::vector<clock_t> clkBatchDecision, clkBatchContraction;
+		batchMods.push_back(batched.run(threshold, binThreshold, szSmallComm, isGauss,
+				max_iteration, streams, n_streams, start, stop,
+				clkBatchDecision, clkBatchContraction));
+		batchSweeps.push_back(batched.nrSweeps);
+
+		clock_gettime(CLOCK_MONOTONIC, &end_comm);
+		batchTimes.push_back((end_comm.tv_sec*1000 + (end_comm.tv_nsec/1.0e6)) - (start_comm.tv_sec*1000 + (start_comm.tv_nsec/1.0e6)));
+
+		clock_gettime(CLOCK_MONOTONIC, &start_comm);
+	}
+
+	// One run per deadline: latency against modularity, next to the timed
+	// run below
+	std::vector<double> curveMods, curveTimes;
+	std::vector<int> curveLevels;
+	std::vector<bool> curveStopped;
 
-	std::cout<< "#phase: "<<stepID<<std::endl;
+	for (size_t d = 0; d < deadlineCurve.size(); d++) {
+		Community bounded(input_graph, -1, threshold);
+		bounded.configureLike(dev_community);
+		bounded.deadline.limit = deadlineCurve[d];
+
+		std::vector<clock_t> clkBoundedDecision, clkBoundedContraction;
+		curveMods.push_back(bounded.run(threshold, binThreshold, szSmallComm, isGauss,
+				max_iteration, streams, n_streams, start, stop,
+				clkBoundedDecision, clkBoundedContraction));
+		curveLevels.push_back(clkBoundedContraction.size() + 1);
+		curveStopped.push_back(bounded.deadline.hit);
+
+		clock_gettime(CLOCK_MONOTONIC, &end_comm);
+		curveTimes.push_back((end_comm.tv_sec*1000 + (end_comm.tv_nsec/1.0e6)) - (start_comm.tv_sec*1000 + (start_comm.tv_nsec/1.0e6)));
+
+		clock_gettime(CLOCK_MONOTONIC, &start_comm);
+	}
+
+	dev_community.keepDendrogram = (reclusterSize > 0) || deterministicCompare;
+	dev_community.keepDendrogram = dev_community.keepDendrogram || (deadlineSeconds > 0);
+	dev_community.bucketCompare = bucketCompare;
+
+	Telemetry telemetry;
+	if (telemetryPrefix.size() || specializeCompare || registerCompare)
+		dev_community.telemetry = &telemetry;
+
+	if (componentSolve) {
+		// components are solved on their own; the merged dendrogram stands
+		// for the levels of the whole graph
+		dev_community.dendrogram = clusterComponents(input_graph, dev_community, componentTiny,
+				componentBatch, componentJobs, threshold, binThreshold, szSmallComm, isGauss);
+		prev_mod = input_graph.modularity(dev_community.dendrogram.flatten());
+		LOG(LOG_SUMMARY, "Components: #Levels " << dev_community.dendrogram.nrLevels() << " #Communities "
+			<< dev_community.dendrogram.nrCommunities() << " Modularity " << prev_mod);
+	} else {
+		prev_mod = dev_community.run(threshold, binThreshold, szSmallComm, isGauss,
+				max_iteration, streams, n_streams, start, stop,
+				clkList_decision, clkList_contration);
+	}
+
+	int stepID = clkList_decision.size() + 1;
+
+	LOG(LOG_INFO, "#phase: "<<stepID);
+
+	if (telemetryPrefix.size()) {
+		telemetry.writeCSV(telemetryPrefix);
+		telemetry.writeJSON(telemetryPrefix + ".json");
+		LOG(LOG_SUMMARY, "Telemetry: " << telemetry.sweeps.size() << " sweeps written to " << telemetryPrefix << "_*.csv");
+	}
 
 	clock_gettime(CLOCK_MONOTONIC, &end_comm);
 	double elapsed_time = ((end_comm.tv_sec*1000 + (end_comm.tv_nsec/1.0e6)) - (start_comm.tv_sec*1000 + (start_comm.tv_nsec/1.0e6)));
@@ -227,22 +679,249 @@ int main(int argc, char** argv) {
 	time(&time_end);
 	logFile<<graphName.substr (6, (graphName.length() - 10))<<","<<elapsed_time<<","<<prev_mod<<std::endl;
 
+	if (sampleFraction < 1.0) {
+
+		// Time to get within 0.5% of the final modularity of the full-sweep
+		// run (or of this run if there is no reference)
+		double referenceMod = sampleCompare ? baselineMod : prev_mod;
+		double target = referenceMod - 0.005 * fabs(referenceMod);
+
+		ofstream sampleLog;
+		string sampleLogName = "Log/louvain_method_gpu_sampling.csv";
+		ifstream sampleInfile(sampleLogName);
+		bool existingSampleLog = sampleInfile.good();
+		sampleLog.open(sampleLogName, ios_base::out | ios_base::app | ios_base::ate);
+		if (!existingSampleLog) {
+			sampleLog << "GraphName,Fraction,ByDegree,Seed,Levels,Budget,Total Time,Modularity,"
+				<< "Time To 0.5%,Full Total Time,Full Modularity,Full Time To 0.5%" << std::endl;
+		}
+		sampleLog << graphName.substr (6, (graphName.length() - 10)) << "," << sampleFraction << ","
+			<< sampleByDegree << "," << sampleSeed << "," << sampleLevels << "," << sampleBudget << ","
+			<< elapsed_time << "," << prev_mod << "," << 1000 * timeToReach(dev_community.modularityTrace, target) << ",";
+		if (sampleCompare)
+			sampleLog << baselineTime << "," << baselineMod << "," << 1000 * timeToReach(baselineTrace, target) << std::endl;
+		else
+			sampleLog << ",," << std::endl;
+
+		std::ostringstream line;
+		line << "Sampled(" << sampleFraction << ") Modularity: " << prev_mod
+			<< " Time to within 0.5%: " << timeToReach(dev_community.modularityTrace, target) << " sec";
+		if (sampleCompare)
+			line << " | Full sweeps Modularity: " << baselineMod
+				<< " Time to within 0.5%: " << timeToReach(baselineTrace, target) << " sec";
+		LOG(LOG_SUMMARY, line.str());
+	}
+
+	if (runReference) {
+
+		string backend = "gpu";
+		if (deterministic)
+			backend += "-deterministic";
+		if (sampleFraction < 1.0)
+			backend += "-sampled";
+
+		double speedup = elapsed_time > 0 ? referenceTime / elapsed_time : 0;
+
+		ofstream refLog;
+		string refLogName = "Log/louvain_method_gpu_reference.csv";
+		ifstream refInfile(refLogName);
+		bool existingRefLog = refInfile.good();
+		refLog.open(refLogName, ios_base::out | ios_base::app | ios_base::ate);
+		if (!existingRefLog) {
+			refLog << "GraphName,Backend,Reference Time,Reference Modularity,Total Time,Modularity,"
+				<< "Speedup,Delta Modularity" << std::endl;
+		}
+		refLog << graphName.substr (6, (graphName.length() - 10)) << "," << backend << ","
+			<< referenceTime << "," << referenceMod << "," << elapsed_time << "," << prev_mod << ","
+			<< speedup << "," << prev_mod - referenceMod << std::endl;
+
+		LOG(LOG_SUMMARY, "Speedup(" << backend << " vs sequential): " << speedup
+			<< " Modularity: " << prev_mod << " - " << referenceMod << " = " << prev_mod - referenceMod);
+	}
+
+	if (memoryReport) {
+		dev_community.memory.appendCSV("Log/louvain_method_gpu_memory.csv", graphName.substr (6, (graphName.length() - 10)));
+		LOG(LOG_SUMMARY, "Memory: " << dev_community.memory.records.size() << " phases written to Log/louvain_method_gpu_memory.csv");
+	}
+
+	if (specializeCompare)
+		compareBinTimes("Log/louvain_method_gpu_specialize.csv", graphName.substr (6, (graphName.length() - 10)),
+				type == WEIGHTED, "Generic", "Specialized", genericTelemetry, telemetry, 0, NR_BINS - 2);
+
+	if (registerCompare)
+		compareBinTimes("Log/louvain_method_gpu_register.csv", graphName.substr (6, (graphName.length() - 10)),
+				type == WEIGHTED, "Table", "Register", tableTelemetry, telemetry, 5, 6);
+
+	if (warmStartCompare && warmStartRounds > 0) {
+
+		ofstream warmLog;
+		string warmLogName = "Log/louvain_method_gpu_warm_start.csv";
+		ifstream warmInfile(warmLogName);
+		bool existingWarmLog = warmInfile.good();
+		warmLog.open(warmLogName, ios_base::out | ios_base::app | ios_base::ate);
+		if (!existingWarmLog) {
+			warmLog << "GraphName,Rounds,Contract,Cold Time,Cold Modularity,Warm Time,Warm Modularity,"
+				<< "Speedup,Delta Modularity" << std::endl;
+		}
+		double speedup = elapsed_time > 0 ? coldTime / elapsed_time : 0;
+		warmLog << graphName.substr (6, (graphName.length() - 10)) << "," << warmStartRounds << ","
+			<< warmStartContract << "," << coldTime << "," << coldMod << "," << elapsed_time << ","
+			<< prev_mod << "," << speedup << "," << prev_mod - coldMod << std::endl;
+
+		LOG(LOG_SUMMARY, "Warm start(" << warmStartRounds << (warmStartContract ? ", contract" : "")
+			<< ") Modularity: " << prev_mod << " Time(ms): " << elapsed_time
+			<< " | Cold Modularity: " << coldMod << " Time(ms): " << coldTime
+			<< " | Speedup: " << speedup);
+	}
+
+	if (batchCompare.size()) {
+
+		ofstream batchLog;
+		string batchLogName = "Log/louvain_method_gpu_minibatch.csv";
+		ifstream batchInfile(batchLogName);
+		bool existingBatchLog = batchInfile.good();
+		batchLog.open(batchLogName, ios_base::out | ios_base::app | ios_base::ate);
+		if (!existingBatchLog)
+			batchLog << "GraphName,Update,Batches,Sweeps,Time,Modularity" << std::endl;
+
+		// the timed run comes last; batches 0 stands for autotuned
+		batchCompare.push_back(miniBatches);
+		batchSweeps.push_back(dev_community.nrSweeps);
+		batchTimes.push_back(elapsed_time);
+		batchMods.push_back(prev_mod);
+
+		for (size_t c = 0; c < batchCompare.size(); c++) {
+			batchLog << graphName.substr (6, (graphName.length() - 10)) << "," << (isGauss ? "Gauss-Seidel" : "Jacobi")
+				<< "," << batchCompare[c] << "," << batchSweeps[c] << "," << batchTimes[c] << "," << batchMods[c] << std::endl;
+
+			LOG(LOG_SUMMARY, "Mini-batches " << (batchCompare[c] ? std::to_string(batchCompare[c]) : string("auto"))
+				<< ": #Sweeps " << batchSweeps[c] << " Time(ms): " << batchTimes[c] << " Modularity: " << batchMods[c]);
+		}
+	}
+
+	if (deadlineSeconds > 0) {
+		// what the run hands back is the flattened dendrogram
+		double flatMod = input_graph.modularity(dev_community.dendrogram.flatten());
+		LOG(LOG_SUMMARY, "Deadline " << deadlineSeconds << " sec: Time(ms): " << elapsed_time
+			<< " Modularity: " << prev_mod << " (flattened partition " << flatMod << ")"
+			<< (dev_community.deadline.hit ? " stopped early" : " converged"));
+	}
+
+	if (deadlineCurve.size()) {
+
+		ofstream curveLog;
+		string curveLogName = "Log/louvain_method_gpu_deadline.csv";
+		ifstream curveInfile(curveLogName);
+		bool existingCurveLog = curveInfile.good();
+		curveLog.open(curveLogName, ios_base::out | ios_base::app | ios_base::ate);
+		if (!existingCurveLog)
+			curveLog << "GraphName,Deadline,Time,Modularity,Levels,Stopped" << std::endl;
+
+		// the timed run comes last; deadline 0 stands for none
+		deadlineCurve.push_back(deadlineSeconds);
+		curveTimes.push_back(elapsed_time);
+		curveMods.push_back(prev_mod);
+		curveLevels.push_back(clkList_contration.size() + 1);
+		curveStopped.push_back(dev_community.deadline.hit);
+
+		for (size_t d = 0; d < deadlineCurve.size(); d++) {
+			curveLog << graphName.substr (6, (graphName.length() - 10)) << "," << deadlineCurve[d] << ","
+				<< curveTimes[d] << "," << curveMods[d] << "," << curveLevels[d] << "," << curveStopped[d] << std::endl;
+
+			LOG(LOG_SUMMARY, "Deadline " << deadlineCurve[d] << " sec: #Levels " << curveLevels[d]
+				<< " Time(ms): " << curveTimes[d] << " Modularity: " << curveMods[d]
+				<< (curveStopped[d] ? " (stopped early)" : ""));
+		}
+	}
+
+	if (bucketCompare) {
+
+		ofstream bucketLog;
+		string bucketLogName = "Log/louvain_method_gpu_bucketing.csv";
+		ifstream bucketInfile(bucketLogName);
+		bool existingBucketLog = bucketInfile.good();
+		bucketLog.open(bucketLogName, ios_base::out | ios_base::app | ios_base::ate);
+		if (!existingBucketLog)
+			bucketLog << "GraphName,Level,Chain Time,Primitive Time,Speedup" << std::endl;
+
+		float chainTotal = 0, primitiveTotal = 0;
+		for (size_t l = 0; l < dev_community.bucketTimes.size(); l++) {
+			float chainMs = dev_community.bucketTimes[l].first;
+			float primitiveMs = dev_community.bucketTimes[l].second;
+			bucketLog << graphName.substr (6, (graphName.length() - 10)) << "," << l << "," << chainMs << ","
+				<< primitiveMs << "," << (primitiveMs > 0 ? chainMs / primitiveMs : 0) << std::endl;
+			chainTotal += chainMs;
+			primitiveTotal += primitiveMs;
+		}
+
+		LOG(LOG_SUMMARY, "Renumber and group, all levels: chain Time(ms): " << chainTotal
+			<< " | bucketByKey Time(ms): " << primitiveTotal
+			<< " | Speedup: " << (primitiveTotal > 0 ? chainTotal / primitiveTotal : 0));
+	}
+
+	if (deterministicCompare) {
+
+		bool identical = (prev_mod == repeatMod) && (dev_community.dendrogram.flatten() == repeatPartition);
+		double overhead = defaultTime > 0 ? 100.0 * (elapsed_time - defaultTime) / defaultTime : 0;
+
+		ofstream detLog;
+		string detLogName = "Log/louvain_method_gpu_deterministic.csv";
+		ifstream detInfile(detLogName);
+		bool existingDetLog = detInfile.good();
+		detLog.open(detLogName, ios_base::out | ios_base::app | ios_base::ate);
+		if (!existingDetLog) {
+			detLog << "GraphName,Default Time,Default Modularity,Deterministic Time,"
+				<< "Deterministic Modularity,Overhead(%),Identical" << std::endl;
+		}
+		detLog << graphName.substr (6, (graphName.length() - 10)) << "," << defaultTime << ","
+			<< defaultMod << "," << elapsed_time << "," << prev_mod << "," << overhead << ","
+			<< identical << std::endl;
+
+		LOG(LOG_SUMMARY, "Deterministic Modularity: " << prev_mod << " Time(ms): " << elapsed_time
+			<< " | Default Modularity: " << defaultMod << " Time(ms): " << defaultTime
+			<< " | Overhead: " << overhead << "% Repeat identical: " << (identical ? "yes" : "NO"));
+	}
+
+	if (reclusterSize > 0) {
+
+		struct timespec start_recluster, end_recluster;
+		clock_gettime(CLOCK_MONOTONIC, &start_recluster);
+
+		Dendrogram refined = reclusterLargeCommunities(input_graph, dev_community.dendrogram,
+				dev_community, reclusterSize, reclusterJobs, threshold, binThreshold,
+				szSmallComm, isGauss);
+
+		clock_gettime(CLOCK_MONOTONIC, &end_recluster);
+		double recluster_time = ((end_recluster.tv_sec*1000 + (end_recluster.tv_nsec/1.0e6)) - (start_recluster.tv_sec*1000 + (start_recluster.tv_nsec/1.0e6)));
+
+		// the refinement replaces the levels of the run: vertex -> refined
+		// community -> community of the run, and the refined level is the result
+		int nrCommunities = dev_community.dendrogram.nrCommunities();
+		double runMod = input_graph.modularity(dev_community.dendrogram.flatten());
+		dev_community.dendrogram = refined;
+		prev_mod = input_graph.modularity(dev_community.dendrogram.flatten(1));
+
+		LOG(LOG_SUMMARY, "Recluster(> " << reclusterSize << "): #Communities " << nrCommunities
+			<< " -> " << dev_community.dendrogram.nrCommunities(1) << " Modularity " << runMod
+			<< " -> " << prev_mod << " Time(ms): " << recluster_time);
+	}
+
 	t2 = clock();
 	float diff = ((float) t2 - (float) t1);
 	float seconds = diff / CLOCKS_PER_SEC;
 
 	if( argc ==1){
-		std::cout <<  binThreshold<<"_"<<threshold<<" Running Time: " << seconds << " ;  Final Modularity: "
-			<< prev_mod  << std::endl;
+		LOG(LOG_SUMMARY, binThreshold<<"_"<<threshold<<" Running Time: " << seconds << " ;  Final Modularity: "
+			<< prev_mod);
 	}else{
 
-		std::cout <<  binThreshold<<"_"<<threshold<<" Running Time: " << seconds << " ;  Final Modularity: "
-			<< prev_mod << " inputGraph: " << argv[1] << std::endl;
+		LOG(LOG_SUMMARY, binThreshold<<"_"<<threshold<<" Running Time: " << seconds << " ;  Final Modularity: "
+			<< prev_mod << " inputGraph: " << argv[1]);
 	}
 
 
-	std::cout << "#Record(clk_optimization): " << clkList_decision.size()
-		<< " #Record(clk_contraction):" << clkList_contration.size() << std::endl;
+	LOG(LOG_DEBUG, "#Record(clk_optimization): " << clkList_decision.size()
+		<< " #Record(clk_contraction):" << clkList_contration.size());
 
 	int nrPhase = std::min(clkList_decision.size(), clkList_contration.size());
 
@@ -271,7 +950,7 @@ int main(int argc, char** argv) {
 
 		t_decision += (float) clkList_decision[i] / CLOCKS_PER_SEC;
 		if(i<nrPhase) ofs<< (float) clkList_decision[i] / CLOCKS_PER_SEC<<" ";
-		else std::cout<<  (float) clkList_decision[i] / CLOCKS_PER_SEC<<" -> "<<std::endl;
+		else LOG(LOG_DEBUG, (float) clkList_decision[i] / CLOCKS_PER_SEC<<" -> ");
 
 	}
 
@@ -286,8 +965,8 @@ int main(int argc, char** argv) {
 	ofs<<"\n";
 	ofs.close();
 
-	std::cout<< " Optimization and contraction time  ratio:"
-		<< (100 * t_decision)/(t_decision + t_contraction) << " " << (100 * t_contraction)/(t_decision+t_contraction) << std::endl;
+	LOG(LOG_INFO, " Optimization and contraction time  ratio:"
+		<< (100 * t_decision)/(t_decision + t_contraction) << " " << (100 * t_contraction)/(t_decision+t_contraction));
 
 
 	/*
@@ -298,8 +977,8 @@ int main(int argc, char** argv) {
 	   }
 	 */
 
-	std::cout << "(graph):      #V  " << dev_community.g.nb_nodes << " #E   " << dev_community.g.nb_links << std::endl;
-	std::cout << "(new graph)  #V  " << dev_community.g_next.nb_nodes << " #E  " << dev_community.g_next.nb_links << std::endl;
+	LOG(LOG_DEBUG, "(graph):      #V  " << dev_community.g.nb_nodes << " #E   " << dev_community.g.nb_links);
+	LOG(LOG_DEBUG, "(new graph)  #V  " << dev_community.g_next.nb_nodes << " #E  " << dev_community.g_next.nb_links);
 	/* 
 	   for (int i = 0; i < n_streams; i++) {
 	//CHECK(cudaStreamDestroy(streams[i]));
@@ -310,6 +989,7 @@ int main(int argc, char** argv) {
 	cudaEventDestroy(stop);
 	//free(streams);
 
+	logFlush();
 	return 0;
 }
 
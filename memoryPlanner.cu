@@ -0,0 +1,143 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"memoryPlanner.h"
+#include"hashitem.h"
+#include"logger.h"
+#include"cuda_runtime_api.h"
+#include"fstream"
+#include"algorithm"
+
+const char* memoryStrategyNames[3] = {"default", "fewer-blocks", "chunked"};
+
+static size_t deviceBytesInUse(size_t* total = NULL) {
+
+    size_t freeBytes = 0, totalBytes = 0;
+    cudaMemGetInfo(&freeBytes, &totalBytes);
+    if (total)
+        *total = totalBytes;
+    return totalBytes - freeBytes;
+}
+
+MemoryPlanner::MemoryPlanner() : budget(0), level(0), phaseBase(0), phasePeak(0) {
+}
+
+void MemoryPlanner::beginPhase(int level, const char* phase) {
+
+    this->level = level;
+    this->phase = phase;
+    phaseBase = phasePeak = deviceBytesInUse();
+}
+
+void MemoryPlanner::sample() {
+
+    phasePeak = std::max(phasePeak, deviceBytesInUse());
+}
+
+size_t MemoryPlanner::available() const {
+
+    size_t total = 0;
+    deviceBytesInUse(&total);
+    size_t limit = budget ? std::min(budget, total) : total;
+    return limit > phaseBase ? limit - phaseBase : 0;
+}
+
+void MemoryPlanner::endPhase(int strategy, int nrBlocks, int nrChunks, size_t predicted) {
+
+    sample();
+
+    MemoryRecord record;
+    record.level = level;
+    record.phase = phase;
+    record.strategy = strategy;
+    record.nrBlocks = nrBlocks;
+    record.nrChunks = nrChunks;
+    record.predicted = predicted;
+    record.actual = phasePeak - phaseBase;
+    records.push_back(record);
+
+    LOG(LOG_INFO, "Memory(level " << level << ", " << phase << "): " << memoryStrategyNames[strategy]
+            << " #blocks " << nrBlocks << " #chunks " << nrChunks << " predicted "
+            << (predicted >> 20) << " MB actual " << (record.actual >> 20) << " MB");
+}
+
+void MemoryPlanner::appendCSV(const std::string& fileName, const std::string& graphName) const {
+
+    std::ifstream existing(fileName.c_str());
+    bool hasHeader = existing.good();
+    existing.close();
+
+    std::ofstream file(fileName.c_str(), std::ios_base::out | std::ios_base::app);
+    if (!hasHeader)
+        file << "GraphName,Budget(MB),Level,Phase,Strategy,Blocks,Chunks,Predicted(MB),Actual(MB)\n";
+
+    for (unsigned int i = 0; i < records.size(); i++) {
+        const MemoryRecord& r = records[i];
+        file << graphName << "," << (budget >> 20) << "," << r.level << "," << r.phase << ","
+                << memoryStrategyNames[r.strategy] << "," << r.nrBlocks << "," << r.nrChunks << ","
+                << r.predicted / 1048576.0 << "," << r.actual / 1048576.0 << "\n";
+    }
+}
+
+size_t predictMovePeak(size_t nrNodes, size_t tableItems, int nrDenseTables,
+        bool deterministic, bool sampled) {
+
+    // 12 arrays of 4 bytes per vertex (sizesOfNhoods, bin order and sizes
+    // in g_next.indices and g_next.links, n2c, n2c_new, n2c_old, tot,
+    // tot_new, in, wDegs, cardinalityOfComms and its _new) and about 2 more
+    // for the thrust temporaries of the bin filters and the bin sort
+    size_t bytes = (12 + 2) * 4 * nrNodes;
+
+    if (deterministic)
+        bytes += 8 * nrNodes;
+    if (sampled)
+        bytes += 4 * 4 * nrNodes;
+
+    // the global table holds two slots per neighbor
+    bytes += 2 * tableItems * tableItemSize(deterministic);
+    bytes += (size_t) nrDenseTables * nrNodes * tableItemSize(deterministic);
+
+    return bytes;
+}
+
+size_t predictContractPeak(size_t nrNodes, size_t nrNewNodes, size_t tableItems,
+        int nrDenseTables, size_t listItems, size_t outputItems, bool chunked, bool keepDendrogram,
+        bool deterministic) {
+
+    // comm_nodes, super node pointers, bounds, member counts, degrees and
+    // the candidate lists in g_next
+    size_t bytes = 4 * nrNodes + 6 * 4 * nrNewNodes;
+
+    if (keepDendrogram)
+        bytes += 4 * nrNodes;
+
+    bytes += (size_t) nrDenseTables * nrNewNodes * tableItemSize(deterministic);
+
+    // the tables are released before the lists are copied to the next graph,
+    // unless chunks are written into it while the tables are still in use
+    size_t lists = (4 + 4) * listItems;
+    size_t output = (4 + 4) * outputItems;
+    size_t tables = tableItems * tableItemSize(deterministic);
+    bytes += lists + (chunked ? tables + output : std::max(tables, output));
+
+    return bytes;
+}
@@ -0,0 +1,88 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#ifndef MEMORYPLANNER_H
+#define	MEMORYPLANNER_H
+
+#include"vector"
+#include"string"
+#include"stddef.h"
+
+// Strategies of a phase, from the fastest to the leanest
+#define MEM_DEFAULT 0 // all tables and upper-bound sized buffers at once
+#define MEM_FEWER_BLOCKS 1 // no dense tables, fewer concurrent blocks (smaller global tables)
+#define MEM_CHUNKED 2 // contraction in chunks of new communities after a counting pass
+
+extern const char* memoryStrategyNames[3];
+
+struct MemoryRecord {
+    int level;
+    std::string phase; // move or contract
+    int strategy;
+    int nrBlocks; // blocks of the block bins
+    int nrChunks;
+    size_t predicted; // peak bytes on top of what was resident when the phase began
+    size_t actual;
+};
+
+// Device memory of each phase of a level is predicted from sizes known
+// before its large allocations and checked against the budget; the phase
+// then picks the first strategy that fits. The measured peak is sampled
+// right after the large allocations.
+
+struct MemoryPlanner {
+    size_t budget; // bytes the run may hold on the device, 0: all device memory
+    std::vector<MemoryRecord> records;
+
+    MemoryPlanner();
+
+    void beginPhase(int level, const char* phase);
+    void sample();
+    void endPhase(int strategy, int nrBlocks, int nrChunks, size_t predicted);
+
+    // Bytes the current phase may allocate
+    size_t available() const;
+
+    bool fits(size_t bytes) const {
+        return bytes <= available();
+    }
+
+    void appendCSV(const std::string& fileName, const std::string& graphName) const;
+
+private:
+    int level;
+    std::string phase;
+    size_t phaseBase, phasePeak;
+};
+
+// Bytes allocated by one_levelGaussSeidel for nrNodes vertices, with
+// tableItems slots of global hash table and nrDenseTables dense tables
+size_t predictMovePeak(size_t nrNodes, size_t tableItems, int nrDenseTables,
+        bool deterministic, bool sampled);
+
+// Bytes allocated by compute_next_graph: listItems slots for the new
+// neighbor lists (per chunk) next to outputItems links of the next graph
+size_t predictContractPeak(size_t nrNodes, size_t nrNewNodes, size_t tableItems,
+        int nrDenseTables, size_t listItems, size_t outputItems, bool chunked, bool keepDendrogram,
+        bool deterministic);
+
+#endif	/* MEMORYPLANNER_H */
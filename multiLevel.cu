@@ -0,0 +1,167 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#include <iostream>
+#include <algorithm>
+#include "communityGPU.h"
+
+#ifdef HASH_PROBE_STATS
+#include <sstream>
+
+// Counters cover all tables filled since the last reset
+static void dumpHashProbeStats(int level, const char* phase) {
+
+	HashProbeStats stats;
+	fetchHashProbeStats(stats);
+
+	std::stringstream label;
+	label << "level " << level << ", " << phase;
+	printHashProbeStats(stats, label.str().c_str());
+	appendHashProbeStats(stats, "Log/louvain_method_gpu_hash_stats.csv", level, phase);
+
+	resetHashProbeStats();
+}
+#endif
+
+double Community::secondsSinceStart() const {
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - runStart.tv_sec) + (now.tv_nsec - runStart.tv_nsec) / 1.0e9;
+}
+
+double Community::run(double threshold, double binThreshold, int szSmallComm, bool isGauss,
+		int maxLevels, cudaStream_t *streams, int nrStreams, cudaEvent_t &start,
+		cudaEvent_t &stop, std::vector<clock_t> &clkList_decision,
+		std::vector<clock_t> &clkList_contration) {
+
+	double cur_mod = -1.0, prev_mod = 1.0;
+
+	clock_t t2, t3;
+
+	bool TEPS = true;
+	bool islastRound = false;
+
+	int stepID = 1;
+
+	modularityTrace.clear();
+	nrSweeps = 0;
+	clock_gettime(CLOCK_MONOTONIC, &runStart);
+
+	double limit = deadline.limit;
+	deadline = DeadlineCosts();
+	deadline.limit = limit;
+
+	EngineCosts costs;
+	struct timespec levelStart, levelEnd;
+
+#ifdef HASH_PROBE_STATS
+	resetHashProbeStats();
+#endif
+
+	do {
+
+		// The contracted graph is a valid answer; keep it if a sweep and a
+		// contraction of this level would not end before the deadline
+		if (stepID > 1 && !deadline.fits(secondsSinceStart(),
+					deadline.predictSweep(g.nb_links) + deadline.predictContraction(g.nb_links))) {
+			deadline.hit = true;
+			LOG(LOG_INFO, "Deadline: stop before level " << level << " at " << secondsSinceStart() << " sec");
+			return cur_mod;
+		}
+
+		// Small levels skip the fixed cost of the device pipeline; the host
+		// engine gets what is left of the deadline
+		if (hostCutover && stepID <= maxLevels && levelOnHost(costs)) {
+			t2 = clock();
+			double hostMod = runOnHost(threshold, maxLevels - stepID + 1);
+			clkList_decision.push_back(clock() - t2);
+			return hostMod;
+		}
+
+		LOG(LOG_DEBUG, "---------------Calling method for modularity optimization-------------");
+		t2 = clock();
+		prev_mod = cur_mod;
+		clock_gettime(CLOCK_MONOTONIC, &levelStart);
+		size_t nrTraced = modularityTrace.size();
+		unsigned long nrLinks = g.nb_links;
+
+		cur_mod = one_levelGaussSeidel(cur_mod, islastRound,
+				szSmallComm, binThreshold, isGauss &&(community_size > szSmallComm),
+				streams, nrStreams, start, stop);
+
+		t2 = clock() - t2;
+
+#ifdef HASH_PROBE_STATS
+		dumpHashProbeStats(level, "move");
+#endif
+
+		clkList_decision.push_back(t2); // push the clock for the decision
+
+		LOG(LOG_INFO, "step: " <<stepID <<", Time for modularity optimization: " << ((float) t2) / CLOCKS_PER_SEC);
+		stepID++;
+		if (TEPS == true) {
+			LOG(LOG_INFO, binThreshold<<"_"<<threshold<< " #E:" <<  g.nb_links << "  TEPS: " << g.nb_links / (((float) t2) / CLOCKS_PER_SEC));
+			TEPS = false;
+		}
+
+		LOG(LOG_INFO, "Computed modularity: " << cur_mod << " ( init_mod = " << prev_mod << " ) ");
+
+		if ((cur_mod - prev_mod) > threshold && stepID<=maxLevels) {
+
+			t3 = clock();
+			struct timespec contractStart;
+			clock_gettime(CLOCK_MONOTONIC, &contractStart);
+			gatherStatistics();
+
+			t2 = clock();
+			compute_next_graph(streams, nrStreams, start, stop);
+			t2 = clock() - t2;
+#ifdef HASH_PROBE_STATS
+			dumpHashProbeStats(level, "contract");
+#endif
+			LOG(LOG_INFO, "Time to compute next graph: " << ((float) t2) / CLOCKS_PER_SEC);
+
+			set_new_graph_as_current();
+			t3 = clock() -t3;
+
+			clkList_contration.push_back(t3); // push the clock for the contraction
+
+			clock_gettime(CLOCK_MONOTONIC, &levelEnd);
+			deadline.recordContraction((levelEnd.tv_sec - contractStart.tv_sec) + (levelEnd.tv_nsec - contractStart.tv_nsec) / 1.0e9, nrLinks);
+			costs.deviceLevelTime = (levelEnd.tv_sec - levelStart.tv_sec) + (levelEnd.tv_nsec - levelStart.tv_nsec) / 1.0e9;
+			costs.deviceLevelFloor = costs.deviceLevelLinks ? std::min(costs.deviceLevelFloor, costs.deviceLevelTime) : costs.deviceLevelTime;
+			costs.deviceLevelLinks = nrLinks;
+			costs.deviceLevelSweeps = modularityTrace.size() - nrTraced + 1;
+
+		} else {
+			if (islastRound == false && !deadline.hit) {
+				islastRound = true;
+			} else {
+				break;
+			}
+		}
+	} while (true);
+
+	return prev_mod;
+}
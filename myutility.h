@@ -71,6 +71,7 @@ float compute_weight_of_slef_loops_of_a_node(int node, int laneId, int nr_neigho
         unsigned int* neighbors, float* weights_of_links_to_neighbors, int type);
 
 
+template<unsigned int GROUP_SIZE = 0, int GRAPH_TYPE = ANY_GRAPH>
 #ifdef RUNONGPU
 __device__
 #endif
@@ -114,8 +115,13 @@ void compute_neighboring_communites(int node, int laneId, int nr_neighbor,
         float *in_new, float* tot_new, int* n2c_new, float weight_of_self_loops,
         HashItem* shashTable, unsigned int bucketSize);
 
-#ifdef RUNONGPU
+// The move and contraction kernels are templates over the group width, the
+// size of the per-group table and the graph type. The instance <0, 0,
+// ANY_GRAPH> reads them from the runtime arguments (generic kernels). ITEM
+// is the table slot: HashItem, or WideHashItem in deterministic mode.
 
+template<unsigned int GROUP_SIZE, unsigned int TABLE_SIZE, int GRAPH_TYPE, typename ITEM>
+#ifdef RUNONGPU
 __global__
 #endif
 void neigh_comm(int community_size, int* indices, unsigned int* links,
@@ -126,6 +132,34 @@ void neigh_comm(int community_size, int* indices, unsigned int* links,
         int* cardinalityOfComms_old, int* cardinalityOfComms_new,
         unsigned int wrpSz, float *wDegs);
 
+typedef void (*NeighCommKernel)(int, int*, unsigned int*, float*, int*,
+        float*, float*, int, int*, float*, int*, double, unsigned int, int*,
+        int, int*, int, int*, int*, unsigned int, float*);
+
+typedef void (*BlockMoveKernel)(int*, unsigned int*, float*, int*, float*,
+        float*, int, int*, float*, float*, int*, double, int*, int, void*,
+        int*, int*, int, unsigned int, int*, int*, float*, void*, int, int);
+
+typedef void (*BlockContractKernel)(int*, float*, unsigned int*,
+        unsigned int*, int*, float*, unsigned int*, int*, int, int*, int*,
+        int*, int, unsigned int, int*, int, void*, int*, int*, int,
+        unsigned int, void*, int);
+
+typedef void (*WarpContractKernel)(int*, float*, unsigned int*,
+        unsigned int*, int*, float*, unsigned int*, int*, int, int*, int*,
+        int*, int, unsigned int, int*, int, unsigned int);
+
+// Instance for a bin, chosen once per level; combinations without a
+// specialization (and generic == true) get the generic kernel. The block
+// kernels take the table memory untyped; deterministic picks its slot type
+NeighCommKernel selectNeighComm(unsigned int wrpSz, unsigned int bucketSize, int type, bool generic, bool deterministic);
+// Table-free kernels of the bins with at most 4 and 8 neighbors; NULL for
+// other group widths
+NeighCommKernel selectNeighCommInRegisters(unsigned int wrpSz, int type);
+BlockMoveKernel selectLookAtNeigboringComms(int type, bool generic, bool deterministic);
+BlockContractKernel selectFindNewNeighodByBlock(int type, bool generic, bool deterministic);
+WarpContractKernel selectDetermineNewNeighborhood(unsigned int wrpSz, unsigned int bucketSize, int type, bool generic, bool deterministic);
+
 __global__
 void get_size_of_communities(int* renumber, int* n2c, int* locks, int nr_nodes);
 
@@ -173,6 +207,7 @@ void determine_neighbors_of_new_comms(int* super_node_ptrs, float* new_weights,
         float* weights, unsigned int* links, int* comms_nodes, int new_nb_comm,
         int* n2c, int* renumber, int* start_locations, int type);
 
+template<unsigned int GROUP_SIZE, unsigned int TABLE_SIZE, int GRAPH_TYPE, typename ITEM>
 __global__
 void determineNewNeighborhood(int* super_node_ptrs, float* new_weights,
         unsigned int* new_links, unsigned int* new_member_counts, int* indices,
@@ -190,24 +225,27 @@ void get_size_of_communities_NEW(int* renumber, int* n2c, int nr_nodes, int* ind
 
 __global__
 void get_size_of_communities(int* renumber, int* n2c, int nr_nodes);
+template<int GRAPH_TYPE, typename ITEM>
 __global__
 void findNewNeighodByBlock(int* super_node_ptrs, float* newWeights,
         unsigned int* newLinks, unsigned int* nrNeighborsOfNewComms,
         int* indices, float* weights, unsigned int* links, int* comms_nodes,
         int new_nb_comm, int* n2c, int* renumber, int* start_locations,
         int graphType, unsigned int bucketSize, int* candidateComms,
-        int nrCandidateComms, HashItem* gblTable, int* glbTblPtrs,
-        int* primes, int nrPrime, unsigned int wrpSz);
+        int nrCandidateComms, void* gblTableMem, int* glbTblPtrs,
+        int* primes, int nrPrime, unsigned int wrpSz, void* denseTableMem,
+        int nrDenseTables);
+template<int GRAPH_TYPE, typename ITEM>
 #ifdef RUNONGPU
-
 __global__
 #endif
 void lookAtNeigboringComms(int* indices, unsigned int* links, float* weights,
         int *n2c, float *in, float* tot, int type, int *n2c_new, float *in_new,
         float* tot_new, int* movement_record, double total_weight,
-        int* candidateComms, int nrCandidateComms, HashItem* gblTable,
+        int* candidateComms, int nrCandidateComms, void* gblTableMem,
         int* glbTblPtrs, int* primes, int nrPrime, unsigned int wrpSz,
-        int* cardinalityOfComms_old, int* cardinalityOfComms_new, float *wDegs);
+        int* cardinalityOfComms_old, int* cardinalityOfComms_new, float *wDegs,
+        void* denseTableMem, int nrDenseTables, int nrComms);
 
 #ifdef RUNONGPU
 __global__
@@ -255,5 +293,73 @@ __global__
 void update(unsigned int nrComm, float* tot, float* tot_new,
         int* n2c, int* n2c_new, int* cardinalityOfComms,
         int* cardinalityOfComms_new);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void accumulateFixedPoint(unsigned int nrElements, int* keys, float* values,
+        float scale, unsigned long long* sums);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void fixedPointToFloat(unsigned int nrElements, unsigned long long* sums, float scale, float* values);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void moveFixedPoint(int nrCandidates, int* candidates, int* n2c, int* n2c_new,
+        float* wDegs, float scale, unsigned long long* totFixed);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void refreshMovedTot(int nrCandidates, int* candidates, int* n2c, int* n2c_new,
+        unsigned long long* totFixed, float scale, float* tot_new);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void labelPropagationRound(int community_size, int* indices, unsigned int* links,
+        float* weights, int type, int* n2c, int* n2c_new, float* tot, float* wDegs,
+        int* cardinalityOfComms, double total_weight, unsigned int parity,
+        int maxDegree, int* nrMoves);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void countMembers(int nrNodes, int* n2c, int* cardinalityOfComms);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void hookComponents(int nrNodes, int* indices, unsigned int* links, int* label, int* changed);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void compressComponents(int nrNodes, int* label);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void countMoveConflicts(int* candidates, int nrCandidates, int* indices, unsigned int* links,
+        int* n2c, int* n2c_new, int* counts);
+
+#ifdef RUNONGPU
+
+__global__
+#endif
+void degreeHistogram(int nrNodes, unsigned int* degrees, unsigned int warpLimit,
+        unsigned int blkSMemLimit, int* binSizes);
 #endif	/* MYUTILITY_H */
 
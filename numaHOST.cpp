@@ -0,0 +1,228 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"numaHOST.h"
+#include"fstream"
+#include"sstream"
+#include"iostream"
+#include"thread"
+#include"string"
+#include"logger.h"
+
+#include<sched.h>
+#include<pthread.h>
+#include<unistd.h>
+#include<sys/syscall.h>
+
+// From <numaif.h>; we call the syscalls directly to avoid linking libnuma
+#define NUMA_MPOL_BIND 2
+#define NUMA_MPOL_MF_MOVE (1<<1)
+
+static std::vector<int> parseCpuList(const std::string& cpuList) {
+
+    // e.g. "0-7,16-23"
+    std::vector<int> cpus;
+    std::stringstream ss(cpuList);
+    std::string range;
+
+    while (std::getline(ss, range, ',')) {
+        if (range.empty())
+            continue;
+        size_t dash = range.find('-');
+        int first = atoi(range.c_str());
+        int last = (dash == std::string::npos) ? first : atoi(range.c_str() + dash + 1);
+        for (int c = first; c <= last; c++)
+            cpus.push_back(c);
+    }
+    return cpus;
+}
+
+NumaTopology::NumaTopology() {
+
+    nrNodes = 0;
+
+    for (int node = 0;; node++) {
+
+        std::stringstream path;
+        path << "/sys/devices/system/node/node" << node << "/cpulist";
+        std::ifstream cpuFile(path.str().c_str());
+
+        if (!cpuFile.is_open())
+            break;
+
+        std::string cpuList;
+        std::getline(cpuFile, cpuList);
+        std::vector<int> cpus = parseCpuList(cpuList);
+
+        if (cpus.size()) {
+            cpusOfNode.push_back(cpus);
+            nrNodes++;
+        }
+    }
+
+    if (!nrNodes) {
+        int nrOnline = std::max(1, (int) std::thread::hardware_concurrency());
+        cpusOfNode.resize(1);
+        for (int c = 0; c < nrOnline; c++)
+            cpusOfNode[0].push_back(c);
+        nrNodes = 1;
+    }
+}
+
+int NumaTopology::nrCpus() const {
+
+    int total = 0;
+    for (int node = 0; node < nrNodes; node++)
+        total += cpusOfNode[node].size();
+    return total;
+}
+
+int NumaTopology::nodeOfWorker(int workerId, int nrWorkers) const {
+
+    // Workers are distributed over nodes proportional to #cpus per node
+    long long before = 0;
+    int total = nrCpus();
+    for (int node = 0; node < nrNodes; node++) {
+        before += cpusOfNode[node].size();
+        if ((long long) workerId * total < before * nrWorkers)
+            return node;
+    }
+    return nrNodes - 1;
+}
+
+int NumaTopology::cpuOfWorker(int workerId, int nrWorkers) const {
+
+    int node = nodeOfWorker(workerId, nrWorkers);
+
+    int firstOfNode = workerId;
+    while (firstOfNode > 0 && nodeOfWorker(firstOfNode - 1, nrWorkers) == node)
+        firstOfNode--;
+
+    const std::vector<int>& cpus = cpusOfNode[node];
+    return cpus[(workerId - firstOfNode) % cpus.size()];
+}
+
+void NumaTopology::display() const {
+
+    LOG(LOG_INFO, "#NUMA nodes: " << nrNodes << " #cpus: " << nrCpus());
+    for (int node = 0; node < nrNodes; node++)
+        LOG(LOG_INFO, "  node " << node << ": " << cpusOfNode[node].size() << " cpus");
+}
+
+bool pinCurrentThread(int cpu) {
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof (cpu_set_t), &cpuSet) == 0;
+}
+
+void runPinned(const NumaTopology& topo, int nrWorkers, std::function<void(int) > fn) {
+
+    std::vector<std::thread> workers;
+    workers.reserve(nrWorkers);
+
+    for (int w = 0; w < nrWorkers; w++) {
+        int cpu = topo.cpuOfWorker(w, nrWorkers);
+        workers.push_back(std::thread([&fn, w, cpu]() {
+            pinCurrentThread(cpu);
+            fn(w);
+        }));
+    }
+
+    for (int w = 0; w < nrWorkers; w++)
+        workers[w].join();
+}
+
+std::vector<unsigned int> partitionByLinks(const std::vector<unsigned long>& cumDegrees, int nrParts) {
+
+    unsigned int nbNodes = cumDegrees.size();
+    unsigned long nbLinks = nbNodes ? cumDegrees[nbNodes - 1] : 0;
+
+    std::vector<unsigned int> bounds(nrParts + 1, nbNodes);
+    bounds[0] = 0;
+
+    for (int p = 1; p < nrParts; p++) {
+        // first vertex whose list starts at or after p-th share of links
+        unsigned long target = (nbLinks * p) / nrParts;
+        bounds[p] = std::upper_bound(cumDegrees.begin(), cumDegrees.end(), target) - cumDegrees.begin();
+        bounds[p] = std::max(bounds[p], bounds[p - 1]);
+    }
+    return bounds;
+}
+
+bool bindToNode(const void* addr, size_t bytes, int node) {
+
+    if (!bytes || node < 0 || node >= (int) (8 * sizeof (unsigned long)))
+        return false;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+
+    // mbind works on whole pages; only bind pages fully inside the range so
+    // that neighbor ranges on other nodes are not dragged along
+    unsigned long start = ((unsigned long) addr + pageSize - 1) & ~(pageSize - 1);
+    unsigned long end = ((unsigned long) addr + bytes) & ~(pageSize - 1);
+
+    if (end <= start)
+        return false;
+
+    unsigned long nodeMask = 1UL << node;
+
+    long status = syscall(SYS_mbind, start, end - start, NUMA_MPOL_BIND,
+            &nodeMask, 8 * sizeof (unsigned long), NUMA_MPOL_MF_MOVE);
+
+    return status == 0;
+}
+
+int nodeOfPage(const void* addr) {
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    void* page = (void*) ((unsigned long) addr & ~(pageSize - 1));
+    int status = -1;
+
+    // move_pages with NULL target nodes only queries the location
+    if (syscall(SYS_move_pages, 0, 1, &page, NULL, &status, 0) != 0)
+        return -1;
+
+    return status >= 0 ? status : -1;
+}
+
+double localPageRatio(const void* addr, size_t bytes, int node, int maxSamples) {
+
+    if (!bytes)
+        return 1.0;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    size_t nrPages = (bytes + pageSize - 1) / pageSize;
+    size_t stride = std::max((size_t) 1, nrPages / maxSamples);
+
+    int nrLocal = 0, nrSampled = 0;
+    for (size_t p = 0; p < nrPages; p += stride) {
+        int where = nodeOfPage((const char*) addr + p * pageSize);
+        if (where < 0)
+            continue;
+        nrSampled++;
+        nrLocal += (where == node);
+    }
+
+    return nrSampled ? (double) nrLocal / nrSampled : -1.0;
+}
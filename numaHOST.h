@@ -0,0 +1,109 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#ifndef NUMAHOST_H
+#define	NUMAHOST_H
+
+#include"vector"
+#include"functional"
+#include"thread"
+#include"algorithm"
+#include"stddef.h"
+
+// Sockets (NUMA nodes) and the cpus attached to them, read from sysfs.
+// Falls back to a single node holding all online cpus.
+
+struct NumaTopology {
+    int nrNodes;
+    std::vector<std::vector<int> > cpusOfNode;
+
+    NumaTopology();
+
+    int nrCpus() const;
+
+    // Workers are spread node by node: worker 0.. go to node 0, the next
+    // group to node 1 and so on, so contiguous vertex ranges stay on one node
+    int nodeOfWorker(int workerId, int nrWorkers) const;
+    int cpuOfWorker(int workerId, int nrWorkers) const;
+
+    void display() const;
+};
+
+bool pinCurrentThread(int cpu);
+
+// Runs fn(workerId) on nrWorkers threads, each pinned to cpuOfWorker()
+void runPinned(const NumaTopology& topo, int nrWorkers, std::function<void(int) > fn);
+
+// Splits vertices of a CSR (cumulative degrees as in GraphHOST) into nrParts
+// consecutive ranges with (almost) equal number of links;
+// part p owns vertices [bounds[p], bounds[p+1])
+std::vector<unsigned int> partitionByLinks(const std::vector<unsigned long>& cumDegrees, int nrParts);
+
+// Binds pages of [addr, addr+bytes) to node and migrates those already touched
+bool bindToNode(const void* addr, size_t bytes, int node);
+
+// Node holding the page of addr, -1 if unknown
+int nodeOfPage(const void* addr);
+
+// Fraction of (sampled) pages of [addr, addr+bytes) that reside on node
+double localPageRatio(const void* addr, size_t bytes, int node, int maxSamples = 256);
+
+// One copy of a read-mostly array per NUMA node. Workers read the copy of
+// their own node; the owner publishes updates. The ensemble replicates the
+// weighted degrees of level 0 (--numa); GraphHOST::benchmarkNumaScaling
+// measures the effect (--numa-report).
+
+template<typename T>
+struct NumaReplica {
+    std::vector<std::vector<T> > copies;
+
+    void create(const NumaTopology& topo, const T* src, size_t n) {
+        copies.resize(topo.nrNodes);
+        for (int node = 0; node < topo.nrNodes; node++) {
+            copies[node].resize(n);
+            bindToNode(copies[node].data(), n * sizeof (T), node);
+        }
+        publish(topo, src, n);
+    }
+
+    // Copy master data into every replica; each copy is written by a thread
+    // of its own node
+    void publish(const NumaTopology& topo, const T* src, size_t n) {
+        if (!n) return;
+        std::vector<std::thread> writers;
+        for (int node = 0; node < topo.nrNodes; node++) {
+            int cpu = topo.cpusOfNode[node][0];
+            writers.push_back(std::thread([this, src, n, node, cpu]() {
+                pinCurrentThread(cpu);
+                std::copy(src, src + n, copies[node].begin());
+            }));
+        }
+        for (size_t i = 0; i < writers.size(); i++)
+            writers[i].join();
+    }
+
+    const T* of(int node) const {
+        return copies[node].data();
+    }
+};
+
+#endif	/* NUMAHOST_H */
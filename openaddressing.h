@@ -25,6 +25,8 @@
 
 #include "hashitem.h"
 #include"devconstants.h"
+#include"hashstats.h"
+#include"math.h"
 
 #ifdef RUNONGPU
 
@@ -43,14 +45,266 @@ inline unsigned int H2GPU(unsigned int key, unsigned int bucketSize) {
 }
 
 #ifdef RUNONGPU
+#define TABLE_CAS(address, compare, val) atomicCAS(address, compare, val)
+#define TABLE_ADD(address, val) atomicAdd(address, val)
+#else
+
+// Host build of the table code (e.g. hashBench); a table is filled by one thread
+
+inline int hostTableCAS(int* address, int compare, int val) {
+    int old = *address;
+    if (old == compare)
+        *address = val;
+    return old;
+}
+
+inline float hostTableAdd(float* address, float val) {
+    float old = *address;
+    *address = old + val;
+    return old;
+}
+
+#define TABLE_CAS(address, compare, val) hostTableCAS(address, compare, val)
+#define TABLE_ADD(address, val) hostTableAdd(address, val)
+#endif
+
+// Deterministic mode: the tables hold WideHashItem slots whose gravities are
+// accumulated as 64-bit fixed-point integers (gravity * scale), so the sums
+// do not depend on the order of the atomics. The scale is set per phase
+// from the largest sum a slot can reach (fixedPointScale). It is a single
+// device symbol, so deterministic solves must not run concurrently. Like the
+// probe counters, the hash kernels use the copy of coreutility.cu, which
+// also defines setTableGravityScale(). HashItem slots of the default mode
+// keep float atomics and never read the scale.
+
+void setTableGravityScale(float scale);
+
+// Largest power of two keeping maxSum * scale below 2^62
+
+inline float fixedPointScale(double maxSum) {
+
+    int exponent = 0;
+    frexp(maxSum > 1.0 ? maxSum : 1.0, &exponent);
+    return (float) ldexp(1.0, 62 - exponent);
+}
+
+// Adds value to the gravity of item; returns the new gravity
+
+#ifdef RUNONGPU
+
+__device__
+#endif
+inline float tableAddGravity(HashItem* item, float value) {
+    return TABLE_ADD(&item->gravity, value) + value;
+}
+
+#ifdef RUNONGPU
+
+__device__
+#endif
+inline float tableGravity(const HashItem& item) {
+    return item.gravity;
+}
+
+#ifdef RUNONGPU
+
+__device__
+#endif
+inline void tableClearGravity(HashItem& item) {
+    item.gravity = 0.0;
+}
+
+#ifdef RUNONGPU
+
+static __device__ float d_gravityScale;
+
+__device__
+inline float tableAddGravity(WideHashItem* item, float value) {
+
+    long long added = __float2ll_rn(value * d_gravityScale);
+    long long prev = (long long) atomicAdd((unsigned long long*) &item->fixedGravity, (unsigned long long) added);
+    return (float) ((double) (prev + added) / d_gravityScale);
+}
+
+__device__
+inline float tableGravity(const WideHashItem& item) {
+    return (float) ((double) item.fixedGravity / d_gravityScale);
+}
+
 __device__
+inline void tableClearGravity(WideHashItem& item) {
+    item.fixedGravity = 0;
+}
 #endif
-int hashInsertGPU(HashItem* Table, unsigned int* totNrAttempt, unsigned int bucketSize, HashItem *dataItem, float* tot, float wDegNode, float m2, float* bestGain, int* bestDest);
 
+/**
+ * Returns bucketSize if inserted new record in the table else position of record 
+ * @param Table
+ * @param bucketSize
+ * @param dataItem
+ * @return 
+ */
+template<typename ITEM>
 #ifdef RUNONGPU
 __device__
 #endif
-int hashSearchGPU(HashItem* Table, unsigned int* totNrAttempt, unsigned int bucketSize, HashItem *dataItem);
+inline int hashInsertSimple(ITEM* Table, unsigned int bucketSize, HashItem *dataItem) {
+
+
+    unsigned int i = 0, j = 0;
+    unsigned int h1 = H1GPU(dataItem->cId, bucketSize); // h1
+    unsigned int h2 = H2GPU(dataItem->cId, bucketSize);
+
+
+    do {
+
+        j = (h1 + i * h2) % bucketSize;
+
+        //NOTE: HashTable stores (cid+1)
+        int currCId = TABLE_CAS((int*) &Table[j].cId, FLAG_FREE, (1 + dataItem->cId));
+
+        if (currCId == FLAG_FREE) { // new cId @ location j;  exactly ONE winner
+
+            //printf("\nCame with %d \n", dataItem->cId);
+
+            tableAddGravity(&Table[j], dataItem->gravity);
+            HASH_STAT_INSERT(bucketSize, i + 1);
+            //return (int) i;
+            return (int) bucketSize; // returns bucketSize to indicate new in table
+
+        } else if (currCId == (1 + dataItem->cId)) {
+
+            tableAddGravity(&Table[j], dataItem->gravity);
+            HASH_STAT_INSERT(bucketSize, i + 1);
+            return (int) i;
+
+        } else {
+            i = i + 1;
+        }
+
+    } while (i < bucketSize);
+
+    HASH_STAT_INSERT(bucketSize, -1);
+    return -1;
+}
+
+template<typename ITEM>
+#ifdef RUNONGPU
+__device__
+#endif
+inline int hashInsertGPU(ITEM* Table, unsigned int* totNrAttempt,
+        unsigned int bucketSize, HashItem *dataItem, float* tot, float wDegNode,
+        float m2, float* bestGain, int *bestDest, int sCId) {
+
+    //unsigned int wid = threadIdx.x / WARP_SIZE;
+    //unsigned int laneId = threadIdx.x % WARP_SIZE; // id in the warp
+    float addedValue = 0.0, prevValue = 0.0;
+    unsigned int i = 0, j = 0;
+
+    unsigned int h1 = H1GPU(dataItem->cId, bucketSize); // h1
+
+
+    unsigned int h2 = H2GPU(dataItem->cId, bucketSize);
+    do {
+
+        j = (h1 + i * h2) % bucketSize;
+
+        int currCId = TABLE_CAS((int*) &Table[j].cId, FLAG_FREE, (1 + dataItem->cId)); //NOTE: HashTable stores (cid+1)
+
+        // the winner might be sleeping  while the losers might run and succeed else if () test !!!!!!!!!
+
+        if (currCId == FLAG_FREE) { // new cId @ location j;  exactly ONE winner
+
+            addedValue = dataItem->gravity;
+
+            prevValue = tableAddGravity(&Table[j], addedValue);
+
+            //if (prevValue > 0.0)printf("\nUnexpected value in HashTable\n");
+
+            //float gain = (prevValue * m2 - tot[dataItem->cId] * wDegNode);
+
+            double dgain = 0.0;
+            if (dataItem->cId != sCId)
+                //dgain =  2.0 *  prevValue - 2.0 *  wDegNode * (tot[dataItem->cId] -  tot[sCId] +  wDegNode)*  (1.0 / (double) m2);
+                dgain = (double) (2.0 * (double) prevValue - 2.0 * (double) wDegNode * ((double) tot[dataItem->cId] - (double) tot[sCId] + (double) wDegNode)* (1.0 / (double) m2));
+
+            float gain = (float) dgain;
+
+            //if(dataItem->cId == 97)
+            //printf("\npcId= %d gpc= %f tot[pc]= %f wDeg= %f sCId= %d tot[sCId]= %f m2= %f gain= %f\n",dataItem->cId, prevValue, tot[dataItem->cId], wDegNode, sCId, tot[sCId], m2, gain);
+
+            if ((gain > *bestGain) || (gain == *bestGain && gain != 0 && dataItem->cId < *bestDest)) {
+
+                *bestGain = gain;
+                *bestDest = dataItem->cId;
+            }
+
+            //*totNrAttempt = *totNrAttempt + (i + 1);
+            HASH_STAT_INSERT(bucketSize, i + 1);
+            return (int) i;
+
+        } else if (currCId == (1 + dataItem->cId)) { //existing cId; what if multiple losers came with same currCId !!!!!!!!!!!!!!!
+
+            addedValue = dataItem->gravity;
+
+            prevValue = tableAddGravity(&Table[j], addedValue); //Table[j].gravity += dataItem->gravity;
+
+            //float gain = (prevValue * m2 - tot[dataItem->cId] * wDegNode);
+
+            // double  dgain= (double)(2.0* (double)prevValue  - 2.0*(double)tot[dataItem->cId] * (double)wDegNode * (double)(1.0/(double)m2));
+            double dgain = 0.0;
+            if (dataItem->cId != sCId)
+                dgain = (double) (2.0 * (double) prevValue - 2.0 * (double) wDegNode * ((double) tot[dataItem->cId] - (double) tot[sCId] + (double) wDegNode)* (double) (1.0 / (double) m2));
+
+            float gain = (float) dgain;
+
+            //if(dataItem->cId == 97)
+            //printf("\npcId= %d gpc= %f tot[pc]= %f wDeg= %f sCId= %d tot[sCId]= %f m2= %f\n",dataItem->cId, prevValue, tot[dataItem->cId], wDegNode, sCId, tot[sCId], m2);
+
+            if ((gain > *bestGain) || (gain == *bestGain && gain != 0 && dataItem->cId < *bestDest)) {
+
+                *bestGain = gain;
+                *bestDest = dataItem->cId;
+            }
+            //*totNrAttempt = *totNrAttempt + (i + 1);
+            HASH_STAT_INSERT(bucketSize, i + 1);
+            return (int) i;
+
+        } else {
+            i = i + 1;
+        }
+
+    } while (i < bucketSize);
+    HASH_STAT_INSERT(bucketSize, -1);
+    return -1;
+}
+
+template<typename ITEM>
+#ifdef RUNONGPU
+__device__
+#endif
+inline int hashSearchGPU(ITEM* Table, unsigned int* totNrAttempt, unsigned int bucketSize, HashItem *dataItem) {
+
+    unsigned int i = 0, j = 0;
+
+    unsigned int h1 = H1GPU(dataItem->cId, bucketSize); // h1
+    unsigned int h2 = H2GPU(dataItem->cId, bucketSize);
+
+    do {
+
+        j = (h1 + i * h2) % bucketSize;
+
+        if (Table[j].cId == (1 + dataItem->cId)) {
+            *totNrAttempt = *totNrAttempt + (i + 1);
+            HASH_STAT_SEARCH(bucketSize, i + 1);
+            return (int) j; // returning the index where the  key is found
+        } else {
+            i = i + 1;
+        }
+    } while (i < bucketSize && Table[j].cId != FLAG_FREE);
+    HASH_STAT_SEARCH(bucketSize, i);
+    return -1;
+}
 
 #endif	/* OPENADDRESSING_H */
 
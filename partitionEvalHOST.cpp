@@ -0,0 +1,322 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#include"partitionEvalHOST.h"
+#include"hostconstants.h"
+#include"logger.h"
+#include"thread"
+#include"algorithm"
+#include"unordered_map"
+#include"string.h"
+#include"stdlib.h"
+
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+
+static void* mapFile(const char* filename, size_t& bytes) {
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !info.st_size) {
+        close(fd);
+        return NULL;
+    }
+
+    void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return NULL;
+
+    // the scan reads the links once, front to back
+    madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+    bytes = info.st_size;
+    return mapped;
+}
+
+MappedCSR::MappedCSR() {
+
+    nb_nodes = 0;
+    nb_links = 0;
+    links = NULL;
+    weights = NULL;
+    degrees = NULL;
+    graphMap = weightMap = NULL;
+    graphBytes = weightBytes = 0;
+}
+
+MappedCSR::~MappedCSR() {
+
+    if (graphMap)
+        munmap(graphMap, graphBytes);
+    if (weightMap)
+        munmap(weightMap, weightBytes);
+}
+
+bool MappedCSR::map(const char* filename, const char* filename_w) {
+
+    graphMap = mapFile(filename, graphBytes);
+    if (!graphMap || graphBytes < 4)
+        return false;
+
+    const char* base = (const char*) graphMap;
+    memcpy(&nb_nodes, base, 4);
+    degrees = base + 4;
+
+    if (graphBytes < 4 + (size_t) nb_nodes * 8)
+        return false;
+
+    nb_links = nb_nodes ? cumDegree(nb_nodes - 1) : 0;
+    if (graphBytes < 4 + (size_t) nb_nodes * 8 + nb_links * 4)
+        return false;
+    links = (const unsigned int*) (degrees + (size_t) nb_nodes * 8);
+
+    if (filename_w) {
+        weightMap = mapFile(filename_w, weightBytes);
+        if (!weightMap || weightBytes < nb_links * 4)
+            return false;
+        weights = (const float*) weightMap;
+    }
+    return true;
+}
+
+unsigned long MappedCSR::cumDegree(unsigned int node) const {
+
+    unsigned long degree;
+    memcpy(&degree, degrees + (size_t) node * 8, 8);
+    return degree;
+}
+
+bool readPartition(const char* fileName, unsigned int nbNodes, std::vector<int>& n2c, int& nrCommunities) {
+
+    size_t bytes = 0;
+    char* text = (char*) mapFile(fileName, bytes);
+    if (!text)
+        return false;
+
+    // raw ids first: one per line, or the second of "vertex id"
+    std::vector<long> ids(nbNodes, -1);
+    long maxId = -1;
+    unsigned int next = 0;
+    bool valid = true;
+
+    const char* p = text;
+    const char* end = text + bytes;
+    while (p < end && valid) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            p++;
+        if (p == end)
+            break;
+
+        long first = 0, second = -1;
+        bool hasSecond = false;
+        const char* q = p;
+        while (q < end && *q >= '0' && *q <= '9')
+            first = 10 * first + (*q++ - '0');
+        if (q == p) {
+            valid = false;
+            break;
+        }
+        while (q < end && (*q == ' ' || *q == '\t'))
+            q++;
+        if (q < end && *q >= '0' && *q <= '9') {
+            second = 0;
+            hasSecond = true;
+            while (q < end && *q >= '0' && *q <= '9')
+                second = 10 * second + (*q++ - '0');
+        }
+        p = q;
+
+        unsigned long vertex = hasSecond ? first : next++;
+        long id = hasSecond ? second : first;
+        if (vertex >= nbNodes || id > 0x7fffffffL) {
+            valid = false;
+            break;
+        }
+        ids[vertex] = id;
+        maxId = std::max(maxId, id);
+    }
+    munmap(text, bytes);
+
+    for (unsigned int v = 0; v < nbNodes && valid; v++)
+        valid = ids[v] >= 0;
+    if (!valid)
+        return false;
+
+    // dense ids through a table, sparse ones through a hash map
+    n2c.resize(nbNodes);
+    nrCommunities = 0;
+    if (maxId < 4L * nbNodes + 1) {
+        std::vector<int> renumber(maxId + 1, -1);
+        for (unsigned int v = 0; v < nbNodes; v++) {
+            int& to = renumber[ids[v]];
+            if (to < 0)
+                to = nrCommunities++;
+            n2c[v] = to;
+        }
+    } else {
+        std::unordered_map<long, int> renumber;
+        for (unsigned int v = 0; v < nbNodes; v++) {
+            std::unordered_map<long, int>::iterator it = renumber.find(ids[v]);
+            if (it == renumber.end())
+                it = renumber.insert(std::make_pair(ids[v], nrCommunities++)).first;
+            n2c[v] = it->second;
+        }
+    }
+    return true;
+}
+
+// Accumulators of one thread
+struct ScanPart {
+    std::vector<double> in, tot;
+    std::vector<unsigned int> sizes;
+    unsigned long intraLinks, interLinks;
+};
+
+template<bool IS_WEIGHTED>
+static void scanRange(const MappedCSR& g, const int* n2c, unsigned int first, unsigned int last, ScanPart& part) {
+
+    unsigned long e = first ? g.cumDegree(first - 1) : 0;
+    unsigned long intra = 0, inter = 0;
+
+    for (unsigned int node = first; node < last; node++) {
+
+        int comm = n2c[node];
+        unsigned long end = g.cumDegree(node);
+        double wdeg = 0, inside = 0;
+
+        for (; e < end; e++) {
+            unsigned int nbr = g.links[e];
+            double w = IS_WEIGHTED ? g.weights[e] : 1.0;
+            wdeg += w;
+            if (n2c[nbr] == comm) {
+                inside += w;
+                intra += (nbr != node);
+            } else {
+                inter++;
+            }
+        }
+        part.tot[comm] += wdeg;
+        part.in[comm] += inside;
+        part.sizes[comm]++;
+    }
+    part.intraLinks = intra;
+    part.interLinks = inter;
+}
+
+void scorePartition(const MappedCSR& g, const std::vector<int>& n2c, int nrCommunities,
+        int nrThreads, PartitionScore& score) {
+
+    size_t partBytes = (size_t) nrCommunities * (2 * sizeof (double) + sizeof (unsigned int));
+    size_t fitting = ((size_t) EVAL_ACCUMULATOR_MB << 20) / std::max(partBytes, (size_t) 1);
+    nrThreads = std::max(1, (int) std::min((size_t) nrThreads, fitting));
+    nrThreads = std::min(nrThreads, (int) std::max(1U, g.nb_nodes));
+    score.nrThreads = nrThreads;
+
+    // Vertex ranges with about the same number of links
+    std::vector<unsigned int> bounds(nrThreads + 1, g.nb_nodes);
+    bounds[0] = 0;
+    for (int t = 1; t < nrThreads; t++) {
+        unsigned long target = (g.nb_links * t) / nrThreads;
+        unsigned int lo = bounds[t - 1], hi = g.nb_nodes;
+        while (lo < hi) {
+            unsigned int mid = lo + (hi - lo) / 2;
+            if (g.cumDegree(mid) <= target)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        bounds[t] = lo;
+    }
+
+    std::vector<ScanPart> parts(nrThreads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < nrThreads; t++) {
+        workers.push_back(std::thread([&, t]() {
+            ScanPart& part = parts[t];
+            part.in.assign(nrCommunities, 0);
+            part.tot.assign(nrCommunities, 0);
+            part.sizes.assign(nrCommunities, 0);
+            if (g.weights)
+                scanRange<true>(g, n2c.data(), bounds[t], bounds[t + 1], part);
+            else
+                scanRange<false>(g, n2c.data(), bounds[t], bounds[t + 1], part);
+        }));
+    }
+    for (int t = 0; t < nrThreads; t++)
+        workers[t].join();
+    workers.clear();
+
+    // Sum the accumulators, each thread over its own range of communities
+    score.in.assign(nrCommunities, 0);
+    score.tot.assign(nrCommunities, 0);
+    score.sizes.assign(nrCommunities, 0);
+    score.contribution.assign(nrCommunities, 0);
+
+    for (int t = 0; t < nrThreads; t++) {
+        workers.push_back(std::thread([&, t]() {
+            int first = (int) ((long) nrCommunities * t / nrThreads);
+            int last = (int) ((long) nrCommunities * (t + 1) / nrThreads);
+            for (int p = 0; p < nrThreads; p++) {
+                for (int c = first; c < last; c++) {
+                    score.in[c] += parts[p].in[c];
+                    score.tot[c] += parts[p].tot[c];
+                    score.sizes[c] += parts[p].sizes[c];
+                }
+            }
+        }));
+    }
+    for (int t = 0; t < nrThreads; t++)
+        workers[t].join();
+
+    score.intraLinks = score.interLinks = 0;
+    for (int t = 0; t < nrThreads; t++) {
+        score.intraLinks += parts[t].intraLinks;
+        score.interLinks += parts[t].interLinks;
+    }
+    score.intraLinks /= 2;
+    score.interLinks /= 2;
+
+    double m2 = 0, inside = 0, pairsInside = 0;
+    for (int c = 0; c < nrCommunities; c++) {
+        m2 += score.tot[c];
+        inside += score.in[c];
+        pairsInside += 0.5 * score.sizes[c] * (score.sizes[c] - 1.0);
+    }
+    score.totalWeight = m2;
+
+    score.modularity = 0;
+    for (int c = 0; c < nrCommunities; c++) {
+        score.contribution[c] = m2 > 0 ? score.in[c] / m2 - (score.tot[c] / m2) * (score.tot[c] / m2) : 0;
+        score.modularity += score.contribution[c];
+    }
+    score.coverage = m2 > 0 ? inside / m2 : 0;
+
+    // Right: links inside communities and vertex pairs without a link across them
+    double pairs = 0.5 * g.nb_nodes * (g.nb_nodes - 1.0);
+    double pairsAcross = pairs - pairsInside;
+    score.performance = pairs > 0 ? (score.intraLinks + pairsAcross - score.interLinks) / pairs : 0;
+}
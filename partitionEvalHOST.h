@@ -0,0 +1,79 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#ifndef PARTITIONEVALHOST_H
+#define	PARTITIONEVALHOST_H
+
+#include"vector"
+#include"string"
+#include"stddef.h"
+
+// Read-only view of a graph in the .bin format GraphHOST reads (#nodes,
+// cumulative degrees, links; weights in their own file), mapped in place
+
+struct MappedCSR {
+    unsigned int nb_nodes;
+    unsigned long nb_links;
+    const unsigned int* links;
+    const float* weights; // NULL: unweighted
+
+    MappedCSR();
+    ~MappedCSR();
+
+    bool map(const char* filename, const char* filename_w);
+
+    // Cumulative degree of node; the degrees of the file are not 8-byte aligned
+    unsigned long cumDegree(unsigned int node) const;
+
+private:
+    const char* degrees;
+    void* graphMap;
+    void* weightMap;
+    size_t graphBytes, weightBytes;
+};
+
+// Community id per vertex, one id per line or "vertex id" per line; ids
+// are renumbered 0..nrCommunities-1 in order of first appearance.
+// Returns false on a malformed file or a vertex without id.
+bool readPartition(const char* fileName, unsigned int nbNodes, std::vector<int>& n2c, int& nrCommunities);
+
+struct PartitionScore {
+    double modularity;
+    double coverage; // fraction of the link weight inside communities
+    double performance; // fraction of vertex pairs classified right (intra links, inter non-links)
+    double totalWeight;
+    unsigned long intraLinks, interLinks; // undirected, without self-loops
+    std::vector<double> in, tot; // per community, links counted from both ends
+    std::vector<double> contribution; // in/m2 - (tot/m2)^2
+    std::vector<unsigned int> sizes;
+    int nrThreads;
+};
+
+// One parallel scan over the links: each thread takes a range of vertices
+// with about the same number of links and accumulates in, tot and the link
+// counts of its range on its own; the accumulators are then summed per
+// community range. nrThreads is lowered so that the accumulators fit in
+// EVAL_ACCUMULATOR_MB.
+void scorePartition(const MappedCSR& g, const std::vector<int>& n2c, int nrCommunities,
+        int nrThreads, PartitionScore& score);
+
+#endif	/* PARTITIONEVALHOST_H */
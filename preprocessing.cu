@@ -42,7 +42,7 @@ void Community::preProcess() {
     int nrC_SNL_1 = thrust::count_if(thrust::device, sizesOfNhoods.begin(),
             sizesOfNhoods.end(), filter_SNL_1);
 
-    std::cout << "#vertices (SNL=1):" << nrC_SNL_1 << std::endl;
+    LOG(LOG_DEBUG, "#vertices (SNL=1):" << nrC_SNL_1);
 
     //Lets copy Identities of all communities  in g_next.links
 
@@ -100,16 +100,16 @@ void Community::preProcess() {
      */
 
 
-    if (0) {
+    if (LOG_ENABLED(LOG_TRACE)) {
         thrust::host_vector<int> uniDegVertices = g_next.indices;
-        std::cout << std::endl;
+        std::ostringstream vertexList;
         for (int i = 0; i < nrC_SNL_1; i++) {
-            std::cout << uniDegVertices[i] << " ";
+            vertexList << uniDegVertices[i] << " ";
         }
-        std::cout << std::endl;
+        LOG(LOG_TRACE, vertexList.str());
     }
 
-    if (0) {
+    if (LOG_ENABLED(LOG_TRACE)) {
         thrust::host_vector<unsigned int> gnlinks = g.links;
         thrust::host_vector<int> gnIndices = g.indices;
         thrust::device_vector<float> gnWeights = g.weights;
@@ -120,16 +120,17 @@ void Community::preProcess() {
             //thrust::sort(gnlinks.begin() + startNbr, gnlinks.begin() + endNbr);
 
            if(i<10){
-	    std::cout << i << ":";
+	    std::ostringstream line;
+	    line << i << ":";
 
             for (unsigned int j = startNbr; j < endNbr; j++) {
 
                 float edgeWt = 1;
                 if (g.type == WEIGHTED)
                     edgeWt = gnWeights[j];
-                std::cout << " " << gnlinks[j] << "(" << edgeWt << ")";
+                line << " " << gnlinks[j] << "(" << edgeWt << ")";
             }
-            std::cout << std::endl;
+            LOG(LOG_TRACE, line.str());
 	    }
         }
     }
@@ -0,0 +1,147 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include "communityGPU.h"
+#include "bucketingHOST.h"
+
+Dendrogram reclusterLargeCommunities(const GraphHOST& input_graph,
+		const Dendrogram& dendrogram, const Community& parent, int minCommSize,
+		int nrJobs, double threshold, double binThreshold, int szSmallComm, bool isGauss) {
+
+	std::vector<int> n2c = dendrogram.flatten();
+	if (!n2c.size()) {
+		n2c.resize(input_graph.nb_nodes);
+		for (unsigned int v = 0; v < input_graph.nb_nodes; v++)
+			n2c[v] = v;
+	}
+
+	int nrComm = *std::max_element(n2c.begin(), n2c.end()) + 1;
+
+	// Group vertices by community; members of c are
+	// members[commPtr[c]..commPtr[c+1]) and localId is their position there
+	std::vector<int> commPtr, members, unusedMap;
+	bucketByKeyHOST(n2c.data(), n2c.size(), nrComm, false, std::thread::hardware_concurrency(),
+			unusedMap, commPtr, members);
+
+	std::vector<int> localId(n2c.size());
+	for (int c = 0; c < nrComm; c++)
+		for (int i = commPtr[c]; i < commPtr[c + 1]; i++)
+			localId[members[i]] = i - commPtr[c];
+
+	// Largest first so that the long solves start early
+	std::vector<int> selected;
+	for (int c = 0; c < nrComm; c++) {
+		if (commPtr[c + 1] - commPtr[c] > minCommSize)
+			selected.push_back(c);
+	}
+	std::sort(selected.begin(), selected.end(), [&](int a, int b) {
+		return (commPtr[a + 1] - commPtr[a]) > (commPtr[b + 1] - commPtr[b]);
+	});
+
+	LOG(LOG_INFO, "#Communities to recluster: " << selected.size());
+
+	// Community ids of the members of selected[k] within their own subgraph
+	std::vector<std::vector<int> > subN2c(selected.size());
+	std::atomic<int> nextJob(0);
+
+	nrJobs = std::max(1, std::min(nrJobs, (int) selected.size()));
+	// The table scale of deterministic mode is one device symbol, set by each
+	// phase; concurrent solves would overwrite each other's
+	if (parent.deterministic)
+		nrJobs = 1;
+
+	std::vector<std::thread> workers;
+	for (int w = 0; w < nrJobs; w++) {
+		workers.push_back(std::thread([&]() {
+
+			// with --default-stream per-thread each worker has its own stream
+			cudaEvent_t start, stop;
+			cudaEventCreate(&start);
+			cudaEventCreate(&stop);
+
+			int k;
+			while ((k = nextJob++) < (int) selected.size()) {
+
+				int c = selected[k];
+				int nrMembers = commPtr[c + 1] - commPtr[c];
+
+				GraphHOST subGraph;
+				input_graph.inducedSubgraph(&members[commPtr[c]], nrMembers, n2c, localId, subGraph);
+
+				subN2c[k].assign(nrMembers, 0);
+				if (!subGraph.nb_links)
+					continue;
+
+				Community subCommunity(subGraph, -1, threshold);
+				subCommunity.inheritSettings(parent);
+				subCommunity.keepDendrogram = true;
+
+				std::vector<clock_t> clkList_decision, clkList_contration;
+				subCommunity.run(threshold, binThreshold, szSmallComm, isGauss, 33, NULL, 0,
+						start, stop, clkList_decision, clkList_contration);
+
+				if (subCommunity.dendrogram.nrLevels())
+					subN2c[k] = subCommunity.dendrogram.flatten();
+			}
+
+			cudaEventDestroy(start);
+			cudaEventDestroy(stop);
+		}));
+	}
+	for (int w = 0; w < nrJobs; w++)
+		workers[w].join();
+
+	// Splice: unselected communities stay as they are, selected ones are
+	// replaced by their sub-communities
+	std::vector<int> jobOfComm(nrComm, -1);
+	for (unsigned int k = 0; k < selected.size(); k++)
+		jobOfComm[selected[k]] = k;
+
+	std::vector<int> firstRefined(nrComm + 1, 0);
+	for (int c = 0; c < nrComm; c++) {
+		int nrParts = 1;
+		if (jobOfComm[c] >= 0)
+			nrParts = *std::max_element(subN2c[jobOfComm[c]].begin(), subN2c[jobOfComm[c]].end()) + 1;
+		firstRefined[c + 1] = firstRefined[c] + nrParts;
+	}
+
+	Dendrogram refined;
+	std::vector<int> toRefined(n2c.size()), toCommunity(firstRefined[nrComm]);
+
+	for (unsigned int v = 0; v < n2c.size(); v++) {
+		int c = n2c[v];
+		toRefined[v] = firstRefined[c] + (jobOfComm[c] >= 0 ? subN2c[jobOfComm[c]][localId[v]] : 0);
+	}
+	for (int c = 0; c < nrComm; c++) {
+		for (int r = firstRefined[c]; r < firstRefined[c + 1]; r++)
+			toCommunity[r] = c;
+	}
+
+	refined.addLevel(toRefined);
+	refined.addLevel(toCommunity);
+	return refined;
+}
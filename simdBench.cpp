@@ -0,0 +1,249 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+
+// Times the lane-group primitives of simdHOST.h against their scalar
+// twins. The input is cut into groups of the size a kernel reduces over,
+// a warp (PHY_WRP_SZ) or a block (NR_THREAD_PER_BLOCK), and every
+// primitive is called once per group, as each warp or block calls its
+// device counterpart once. Both results are compared.
+//
+// usage: simdBench [--size=N] [--group=G] [--repeat=R]
+
+#include"simdHOST.h"
+#include"commonconstants.h"
+#include"logger.h"
+
+#include"iostream"
+#include"sstream"
+#include"fstream"
+#include"string"
+#include"vector"
+#include"algorithm"
+#include"random"
+#include"stdlib.h"
+#include"time.h"
+#include"math.h"
+
+struct BenchInput {
+    int size, group;
+    std::vector<int> ints, dests, primes;
+    std::vector<float> floats;
+    std::vector<int> thresholds;
+};
+
+struct BenchResult {
+    std::string primitive;
+    double scalarSeconds, simdSeconds;
+    bool same;
+};
+
+static double secondsOf(const struct timespec& t0, const struct timespec& t1) {
+
+    return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+// Runs fn(simd) nrRepeat times for each variant; fn returns a checksum
+template<typename Fn>
+static BenchResult timePrimitive(const char* primitive, int nrRepeat, Fn fn) {
+
+    BenchResult result;
+    result.primitive = primitive;
+    struct timespec t0, t1;
+    double check[2] = {0, 0};
+
+    for (int simd = 0; simd < 2; simd++) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int r = 0; r < nrRepeat; r++)
+            check[simd] = fn(simd != 0);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        (simd ? result.simdSeconds : result.scalarSeconds) = secondsOf(t0, t1);
+    }
+
+    // float sums are added in another order by the vector path
+    result.same = fabs(check[0] - check[1]) <= 1e-4 * std::max(1.0, fabs(check[0]));
+    return result;
+}
+
+static void makeInput(BenchInput& in, int size, int group) {
+
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<int> value(-1000, 1000);
+    std::uniform_int_distribution<int> dest(0, 255);
+    std::uniform_real_distribution<float> gain(-1.0, 1.0);
+
+    in.size = size;
+    in.group = group;
+    in.ints.resize(size);
+    in.dests.resize(size);
+    in.floats.resize(size);
+    for (int i = 0; i < size; i++) {
+        in.ints[i] = value(gen);
+        in.dests[i] = dest(gen);
+        // coarse gains so that ties (smaller destination wins) do occur
+        in.floats[i] = floorf(gain(gen) * 64) / 64;
+    }
+
+    // sorted table as the primes of findPrimebyWarp
+    for (int p = 2; (int) in.primes.size() < 4096; p++) {
+        bool isPrime = true;
+        for (int d = 2; d * d <= p && isPrime; d++)
+            isPrime = (p % d) != 0;
+        if (isPrime)
+            in.primes.push_back(p);
+    }
+    std::uniform_int_distribution<int> threshold(0, in.primes.back() + 10);
+    in.thresholds.resize(size / group + 1);
+    for (unsigned int t = 0; t < in.thresholds.size(); t++)
+        in.thresholds[t] = threshold(gen);
+}
+
+int main(int argc, char** argv) {
+
+    int size = 1 << 22, group = NR_THREAD_PER_BLOCK, nrRepeat = 10;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 7, "--size=") == 0) {
+            size = std::max(1, atoi(arg.c_str() + 7));
+        } else if (arg.compare(0, 8, "--group=") == 0) {
+            group = std::max(1, atoi(arg.c_str() + 8));
+        } else if (arg.compare(0, 9, "--repeat=") == 0) {
+            nrRepeat = std::max(1, atoi(arg.c_str() + 9));
+        } else {
+            LOG(LOG_ERROR, "usage: " << argv[0] << " [--size=N] [--group=G] [--repeat=R]");
+            return 1;
+        }
+    }
+
+    size -= size % group;
+    if (!size)
+        size = group;
+
+    BenchInput in;
+    makeInput(in, size, group);
+    std::vector<int> scanned(size);
+    int nrGroups = size / group;
+
+    LOG(LOG_SUMMARY, "#elements: " << size << " group: " << group << " lanes: " << HOST_LANES
+            << " repeat: " << nrRepeat);
+
+    std::vector<BenchResult> results;
+
+    results.push_back(timePrimitive("blockReduce", nrRepeat, [&](bool simd) {
+        double check = 0;
+        for (int g = 0; g < nrGroups; g++) {
+            const int* values = &in.ints[g * group];
+            check += simd ? laneReduce(values, group) : laneReduceScalar(values, group);
+        }
+        return check;
+    }));
+
+    results.push_back(timePrimitive("blockReduceFloat", nrRepeat, [&](bool simd) {
+        double check = 0;
+        for (int g = 0; g < nrGroups; g++) {
+            const float* values = &in.floats[g * group];
+            check += simd ? laneReduce(values, group) : laneReduceScalar(values, group);
+        }
+        return check;
+    }));
+
+    results.push_back(timePrimitive("findMaxPerWarp", nrRepeat, [&](bool simd) {
+        double check = 0;
+        for (int g = 0; g < nrGroups; g++) {
+            const float* values = &in.floats[g * group];
+            check += simd ? laneMax(values, group, -1.0f) : laneMaxScalar(values, group, -1.0f);
+        }
+        return check;
+    }));
+
+    results.push_back(timePrimitive("findTheBest", nrRepeat, [&](bool simd) {
+        double check = 0;
+        for (int g = 0; g < nrGroups; g++) {
+            const float* gains = &in.floats[g * group];
+            const int* dests = &in.dests[g * group];
+            float bestGain;
+            int dest = simd ? laneBest(gains, dests, group, &bestGain) : laneBestScalar(gains, dests, group, &bestGain);
+            check += dest + bestGain;
+        }
+        return check;
+    }));
+
+    results.push_back(timePrimitive("blockPrefix", nrRepeat, [&](bool simd) {
+        double check = 0;
+        for (int g = 0; g < nrGroups; g++) {
+            const int* values = &in.ints[g * group];
+            int* out = &scanned[g * group];
+            check += simd ? laneExclusiveScan(values, out, group) : laneExclusiveScanScalar(values, out, group);
+            check += out[group - 1];
+        }
+        return check;
+    }));
+
+    results.push_back(timePrimitive("ballot", nrRepeat, [&](bool simd) {
+        double check = 0;
+        for (int g = 0; g < nrGroups; g++)
+            for (int w = 0; w + PHY_WRP_SZ <= group; w += PHY_WRP_SZ) {
+                const int* values = &in.dests[g * group + w];
+                unsigned int mask = simd ? laneBallot(values, PHY_WRP_SZ, values[0]) : laneBallotScalar(values, PHY_WRP_SZ, values[0]);
+                check += mask;
+            }
+        return check;
+    }));
+
+    results.push_back(timePrimitive("findPrimebyWarp", nrRepeat, [&](bool simd) {
+        double check = 0;
+        int nrPrime = in.primes.size();
+        for (int g = 0; g < nrGroups; g++) {
+            int threshold = in.thresholds[g];
+            check += simd ? laneFirstAbove(&in.primes[0], nrPrime, threshold) :
+                    laneFirstAboveScalar(&in.primes[0], nrPrime, threshold);
+        }
+        return check;
+    }));
+
+    std::string logName = "Log/louvain_method_gpu_simd_bench.csv";
+    std::ifstream infile(logName.c_str());
+    bool existing = infile.good();
+    std::ofstream log(logName.c_str(), std::ios_base::out | std::ios_base::app);
+    if (!existing)
+        log << "Primitive,Lanes,Elements,Group,Scalar(ns/group),SIMD(ns/group),Speedup,Same" << std::endl;
+
+    bool allSame = true;
+    double calls = (double) nrGroups * nrRepeat;
+    for (unsigned int r = 0; r < results.size(); r++) {
+        const BenchResult& b = results[r];
+        double speedup = b.simdSeconds > 0 ? b.scalarSeconds / b.simdSeconds : 0.0;
+        allSame = allSame && b.same;
+
+        LOG(LOG_SUMMARY, b.primitive << ": scalar " << 1e9 * b.scalarSeconds / calls << " ns/group, "
+                << "simd " << 1e9 * b.simdSeconds / calls << " ns/group, speedup " << speedup
+                << (b.same ? "" : ", RESULTS DIFFER"));
+
+        log << b.primitive << "," << HOST_LANES << "," << size << "," << group << ","
+                << 1e9 * b.scalarSeconds / calls << "," << 1e9 * b.simdSeconds / calls << ","
+                << speedup << "," << (b.same ? 1 : 0) << std::endl;
+    }
+
+    return allSame ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+#ifndef SIMDHOST_H
+#define	SIMDHOST_H
+
+#include"stdint.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include<immintrin.h>
+#endif
+
+// Host counterparts of the warp- and block-cooperative helpers of
+// coreutility.cu. What the threads of a warp or block hold in registers is
+// an array here, one entry per thread, and a group of HOST_LANES entries
+// is one vector register (16 with AVX-512, 8 with AVX2 or in the scalar
+// fallback):
+//
+//   blockReduce / blockReduceFloat   laneReduce
+//   findMaxPerWarp                   laneMax
+//   intraWarpBest / findTheBest      laneBest
+//   blockPrefix                      laneExclusiveScan
+//   __ballot                         laneBallot
+//   findPrimebyWarp                  laneFirstAbove
+//
+// Each has a ...Scalar twin with the same result, the reference for
+// simdBench; float sums may differ from it in the last bits as the order
+// of the additions differs.
+//
+// Only simdBench uses these so far. The host move phase (LouvainHOST::sweep)
+// gathers neighbor weights in the dense neighWeight array; the SoA table of
+// hashTableHOST.h (NeighborTableHOST) is measured by hashBench alone.
+
+#if defined(__AVX512F__)
+#define HOST_LANES 16
+#else
+#define HOST_LANES 8
+#endif
+
+inline int laneReduceScalar(const int* values, int n) {
+
+    int sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += values[i];
+    return sum;
+}
+
+inline float laneReduceScalar(const float* values, int n) {
+
+    float sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += values[i];
+    return sum;
+}
+
+template<typename T>
+inline T laneMaxScalar(const T* values, int n, T lowest) {
+
+    T best = lowest;
+    for (int i = 0; i < n; i++)
+        if (values[i] > best)
+            best = values[i];
+    return best;
+}
+
+// Tie rule of intraWarpBest: the smaller destination wins
+inline void laneBetter(float gain, int dest, float& bestGain, int& bestDest) {
+
+    if (gain > bestGain || (gain == bestGain && dest < bestDest)) {
+        bestGain = gain;
+        bestDest = dest;
+    }
+}
+
+// Destination of the largest gain over n >= 1 lanes
+inline int laneBestScalar(const float* gains, const int* dests, int n, float* bestGain) {
+
+    float gain = gains[0];
+    int dest = dests[0];
+    for (int i = 1; i < n; i++)
+        laneBetter(gains[i], dests[i], gain, dest);
+    *bestGain = gain;
+    return dest;
+}
+
+// out[i] = values[0] + .. + values[i-1]; returns the total
+inline int laneExclusiveScanScalar(const int* values, int* out, int n) {
+
+    int sum = 0;
+    for (int i = 0; i < n; i++) {
+        out[i] = sum;
+        sum += values[i];
+    }
+    return sum;
+}
+
+// Bit i is set if values[i] == key, for the n <= 32 lanes of a warp
+inline unsigned int laneBallotScalar(const int* values, int n, int key) {
+
+    unsigned int mask = 0;
+    for (int i = 0; i < n; i++)
+        mask |= (unsigned int) (values[i] == key) << i;
+    return mask;
+}
+
+// First of the sorted values above threshold; the last one if none is,
+// -1 if threshold is above all of them
+inline int laneFirstAboveScalar(const int* sorted, int n, int threshold) {
+
+    if (threshold > sorted[n - 1])
+        return -1;
+    for (int i = 0; i < n; i++)
+        if (sorted[i] > threshold)
+            return sorted[i];
+    return sorted[n - 1];
+}
+
+inline int laneReduce(const int* values, int n) {
+
+    int sum = 0, i = 0;
+#if defined(__AVX512F__)
+    __m512i acc = _mm512_setzero_si512();
+    for (; i + 16 <= n; i += 16)
+        acc = _mm512_add_epi32(acc, _mm512_loadu_si512((const void*) (values + i)));
+    sum = _mm512_reduce_add_epi32(acc);
+#elif defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_add_epi32(acc, _mm256_loadu_si256((const __m256i*) (values + i)));
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    sum = _mm_cvtsi128_si32(half);
+#endif
+    return sum + laneReduceScalar(values + i, n - i);
+}
+
+inline float laneReduce(const float* values, int n) {
+
+    float sum = 0;
+    int i = 0;
+#if defined(__AVX512F__)
+    __m512 acc = _mm512_setzero_ps();
+    for (; i + 16 <= n; i += 16)
+        acc = _mm512_add_ps(acc, _mm512_loadu_ps(values + i));
+    sum = _mm512_reduce_add_ps(acc);
+#elif defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_add_ps(acc, _mm256_loadu_ps(values + i));
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 0x55));
+    sum = _mm_cvtss_f32(half);
+#endif
+    return sum + laneReduceScalar(values + i, n - i);
+}
+
+inline int laneMax(const int* values, int n, int lowest) {
+
+    int best = lowest, i = 0;
+#if defined(__AVX512F__)
+    __m512i acc = _mm512_set1_epi32(lowest);
+    for (; i + 16 <= n; i += 16)
+        acc = _mm512_max_epi32(acc, _mm512_loadu_si512((const void*) (values + i)));
+    best = _mm512_reduce_max_epi32(acc);
+#elif defined(__AVX2__)
+    __m256i acc = _mm256_set1_epi32(lowest);
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_max_epi32(acc, _mm256_loadu_si256((const __m256i*) (values + i)));
+    __m128i half = _mm_max_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_max_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_max_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    best = _mm_cvtsi128_si32(half);
+#endif
+    int rest = laneMaxScalar(values + i, n - i, lowest);
+    return rest > best ? rest : best;
+}
+
+inline float laneMax(const float* values, int n, float lowest) {
+
+    float best = lowest;
+    int i = 0;
+#if defined(__AVX512F__)
+    __m512 acc = _mm512_set1_ps(lowest);
+    for (; i + 16 <= n; i += 16)
+        acc = _mm512_max_ps(acc, _mm512_loadu_ps(values + i));
+    best = _mm512_reduce_max_ps(acc);
+#elif defined(__AVX2__)
+    __m256 acc = _mm256_set1_ps(lowest);
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_max_ps(acc, _mm256_loadu_ps(values + i));
+    __m128 half = _mm_max_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 0x55));
+    best = _mm_cvtss_f32(half);
+#endif
+    float rest = laneMaxScalar(values + i, n - i, lowest);
+    return rest > best ? rest : best;
+}
+
+inline int laneBest(const float* gains, const int* dests, int n, float* bestGain) {
+
+    if (n < HOST_LANES)
+        return laneBestScalar(gains, dests, n, bestGain);
+
+    // one candidate per vector lane, then the lanes among themselves
+    float laneGain[HOST_LANES];
+    int laneDest[HOST_LANES];
+    int i = HOST_LANES;
+#if defined(__AVX512F__)
+    __m512 vBest = _mm512_loadu_ps(gains);
+    __m512i vDest = _mm512_loadu_si512((const void*) dests);
+    for (; i + 16 <= n; i += 16) {
+        __m512 g = _mm512_loadu_ps(gains + i);
+        __m512i d = _mm512_loadu_si512((const void*) (dests + i));
+        __mmask16 better = _mm512_cmp_ps_mask(g, vBest, _CMP_GT_OQ)
+                | (_mm512_cmp_ps_mask(g, vBest, _CMP_EQ_OQ) & _mm512_cmplt_epi32_mask(d, vDest));
+        vBest = _mm512_mask_blend_ps(better, vBest, g);
+        vDest = _mm512_mask_blend_epi32(better, vDest, d);
+    }
+    _mm512_storeu_ps(laneGain, vBest);
+    _mm512_storeu_si512((void*) laneDest, vDest);
+#elif defined(__AVX2__)
+    __m256 vBest = _mm256_loadu_ps(gains);
+    __m256i vDest = _mm256_loadu_si256((const __m256i*) dests);
+    for (; i + 8 <= n; i += 8) {
+        __m256 g = _mm256_loadu_ps(gains + i);
+        __m256i d = _mm256_loadu_si256((const __m256i*) (dests + i));
+        __m256 tie = _mm256_and_ps(_mm256_cmp_ps(g, vBest, _CMP_EQ_OQ),
+                _mm256_castsi256_ps(_mm256_cmpgt_epi32(vDest, d)));
+        __m256 better = _mm256_or_ps(_mm256_cmp_ps(g, vBest, _CMP_GT_OQ), tie);
+        vBest = _mm256_blendv_ps(vBest, g, better);
+        vDest = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(vDest), _mm256_castsi256_ps(d), better));
+    }
+    _mm256_storeu_ps(laneGain, vBest);
+    _mm256_storeu_si256((__m256i*) laneDest, vDest);
+#else
+    for (int l = 0; l < HOST_LANES; l++) {
+        laneGain[l] = gains[l];
+        laneDest[l] = dests[l];
+    }
+    for (; i + HOST_LANES <= n; i += HOST_LANES)
+        for (int l = 0; l < HOST_LANES; l++)
+            laneBetter(gains[i + l], dests[i + l], laneGain[l], laneDest[l]);
+#endif
+    float gain = laneGain[0];
+    int dest = laneDest[0];
+    for (int l = 1; l < HOST_LANES; l++)
+        laneBetter(laneGain[l], laneDest[l], gain, dest);
+    for (; i < n; i++)
+        laneBetter(gains[i], dests[i], gain, dest);
+
+    *bestGain = gain;
+    return dest;
+}
+
+inline int laneExclusiveScan(const int* values, int* out, int n) {
+
+    int sum = 0, i = 0;
+#if defined(__AVX512F__)
+    const __m512i zero = _mm512_setzero_si512();
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void*) (values + i));
+        __m512i x = v;
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 15));
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 14));
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 12));
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 8));
+        x = _mm512_add_epi32(x, _mm512_set1_epi32(sum));
+        _mm512_storeu_si512((void*) (out + i), _mm512_sub_epi32(x, v));
+        sum = _mm_cvtsi128_si32(_mm512_extracti32x4_epi32(_mm512_alignr_epi32(x, x, 15), 0));
+    }
+#elif defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+        __m256i x = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        // the total of the lower half goes to every lane of the upper one
+        __m256i lower = _mm256_permute2x128_si256(x, x, 0x08);
+        x = _mm256_add_epi32(x, _mm256_shuffle_epi32(lower, 0xFF));
+        x = _mm256_add_epi32(x, _mm256_set1_epi32(sum));
+        _mm256_storeu_si256((__m256i*) (out + i), _mm256_sub_epi32(x, v));
+        sum = _mm256_extract_epi32(x, 7);
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = sum;
+        sum += values[i];
+    }
+    return sum;
+}
+
+inline unsigned int laneBallot(const int* values, int n, int key) {
+
+    unsigned int mask = 0;
+    int i = 0;
+#if defined(__AVX512F__)
+    for (; i + 16 <= n; i += 16)
+        mask |= (unsigned int) _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*) (values + i)),
+            _mm512_set1_epi32(key)) << i;
+#elif defined(__AVX2__)
+    for (; i + 8 <= n; i += 8)
+        mask |= (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(
+            _mm256_loadu_si256((const __m256i*) (values + i)), _mm256_set1_epi32(key)))) << i;
+#endif
+    return mask | (laneBallotScalar(values + i, n - i, key) << i);
+}
+
+inline int laneFirstAbove(const int* sorted, int n, int threshold) {
+
+    if (threshold > sorted[n - 1])
+        return -1;
+
+    int i = 0;
+#if defined(__AVX512F__)
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 above = _mm512_cmpgt_epi32_mask(_mm512_loadu_si512((const void*) (sorted + i)),
+                _mm512_set1_epi32(threshold));
+        if (above)
+            return sorted[i + __builtin_ctz(above)];
+    }
+#elif defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        int above = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(
+                _mm256_loadu_si256((const __m256i*) (sorted + i)), _mm256_set1_epi32(threshold))));
+        if (above)
+            return sorted[i + __builtin_ctz(above)];
+    }
+#endif
+    for (; i < n; i++)
+        if (sorted[i] > threshold)
+            return sorted[i];
+    return sorted[n - 1];
+}
+
+#endif	/* SIMDHOST_H */
@@ -0,0 +1,113 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#include"telemetryHOST.h"
+#include"fstream"
+#include"iostream"
+
+const char* binNames[NR_BINS] = {"BlkGMem", "BlkSMem", "Wrp", "leq32", "leq16", "leq8", "leq4", "None"};
+
+int Telemetry::movedInSweep(int level, int sweep) const {
+
+    int nrMoved = 0;
+    for (int i = (int) bins.size() - 1; i >= 0; i--) {
+        if (bins[i].level == level && bins[i].sweep == sweep)
+            nrMoved += bins[i].nrMoved;
+        else if (bins[i].level < level || (bins[i].level == level && bins[i].sweep < sweep))
+            break;
+    }
+    return nrMoved;
+}
+
+void Telemetry::writeCSV(const std::string& prefix) const {
+
+    std::ofstream levelFile((prefix + "_levels.csv").c_str());
+    levelFile << "Level,Nodes,Links";
+    for (int b = 0; b < NR_BINS; b++)
+        levelFile << "," << binNames[b];
+    levelFile << ",Threshold,EasyThreshold\n";
+
+    for (unsigned int i = 0; i < levels.size(); i++) {
+        const LevelRecord& r = levels[i];
+        levelFile << r.level << "," << r.nrNodes << "," << r.nrLinks;
+        for (int b = 0; b < NR_BINS; b++)
+            levelFile << "," << r.binSizes[b];
+        levelFile << "," << r.threshold << "," << r.easyThreshold << "\n";
+    }
+
+    std::ofstream sweepFile((prefix + "_sweeps.csv").c_str());
+    sweepFile << "Level,Sweep,ModBefore,ModAfter,Gain,Threshold,EasyThreshold,Fraction,Accepted,Moved,Seconds\n";
+    sweepFile.precision(10);
+
+    for (unsigned int i = 0; i < sweeps.size(); i++) {
+        const SweepRecord& r = sweeps[i];
+        sweepFile << r.level << "," << r.sweep << "," << r.modBefore << "," << r.modAfter << ","
+                << (r.modAfter - r.modBefore) << "," << r.threshold << "," << r.easyThreshold << ","
+                << r.fraction << "," << r.accepted << "," << r.nrMoved << "," << r.seconds << "\n";
+    }
+
+    std::ofstream binFile((prefix + "_bins.csv").c_str());
+    binFile << "Level,Sweep,Bin,Vertices,Moved,Milliseconds\n";
+
+    for (unsigned int i = 0; i < bins.size(); i++) {
+        const BinRecord& r = bins[i];
+        binFile << r.level << "," << r.sweep << "," << binNames[r.bin] << "," << r.nrVertices << ","
+                << r.nrMoved << "," << r.milliseconds << "\n";
+    }
+}
+
+void Telemetry::writeJSON(const std::string& fileName) const {
+
+    std::ofstream out(fileName.c_str());
+    out.precision(10);
+
+    out << "{\n  \"levels\": [";
+    for (unsigned int i = 0; i < levels.size(); i++) {
+        const LevelRecord& r = levels[i];
+        out << (i ? "," : "") << "\n    {\"level\": " << r.level << ", \"nodes\": " << r.nrNodes
+                << ", \"links\": " << r.nrLinks << ", \"bins\": {";
+        for (int b = 0; b < NR_BINS; b++)
+            out << (b ? ", " : "") << "\"" << binNames[b] << "\": " << r.binSizes[b];
+        out << "}, \"threshold\": " << r.threshold << ", \"easyThreshold\": "
+                << (r.easyThreshold ? "true" : "false") << "}";
+    }
+
+    out << "\n  ],\n  \"sweeps\": [";
+    for (unsigned int i = 0; i < sweeps.size(); i++) {
+        const SweepRecord& r = sweeps[i];
+        out << (i ? "," : "") << "\n    {\"level\": " << r.level << ", \"sweep\": " << r.sweep
+                << ", \"modBefore\": " << r.modBefore << ", \"modAfter\": " << r.modAfter
+                << ", \"threshold\": " << r.threshold << ", \"easyThreshold\": " << (r.easyThreshold ? "true" : "false")
+                << ", \"fraction\": " << r.fraction << ", \"accepted\": " << (r.accepted ? "true" : "false")
+                << ", \"moved\": " << r.nrMoved << ", \"seconds\": " << r.seconds << "}";
+    }
+
+    out << "\n  ],\n  \"bins\": [";
+    for (unsigned int i = 0; i < bins.size(); i++) {
+        const BinRecord& r = bins[i];
+        out << (i ? "," : "") << "\n    {\"level\": " << r.level << ", \"sweep\": " << r.sweep
+                << ", \"bin\": \"" << binNames[r.bin] << "\", \"vertices\": " << r.nrVertices
+                << ", \"moved\": " << r.nrMoved << ", \"milliseconds\": " << r.milliseconds << "}";
+    }
+    out << "\n  ]\n}\n";
+}
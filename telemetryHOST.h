@@ -0,0 +1,81 @@
+/*
+
+    Copyright (C) 2016, University of Bergen
+
+    This file is part of Rundemanen - CUDA C++ parallel program for
+    community detection
+
+    Rundemanen is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Rundemanen is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Rundemanen.  If not, see <http://www.gnu.org/licenses/>.
+
+    */
+
+
+#ifndef TELEMETRYHOST_H
+#define	TELEMETRYHOST_H
+
+#include"vector"
+#include"string"
+
+// Convergence time series of a run. Community holds a pointer to it which
+// is NULL unless telemetry is requested, so nothing is recorded otherwise.
+
+#define NR_BINS 8
+
+extern const char* binNames[NR_BINS]; // BlkGMem, BlkSMem, Wrp, leq32, leq16, leq8, leq4, None
+
+struct LevelRecord {
+    int level;
+    int nrNodes;
+    long nrLinks;
+    int binSizes[NR_BINS];
+    double threshold;
+    bool easyThreshold; // threshold is easyThreshold (binThreshold), not min_modularity
+};
+
+struct SweepRecord {
+    int level;
+    int sweep;
+    double modBefore;
+    double modAfter;
+    double threshold;
+    bool easyThreshold;
+    double fraction; // < 1 for sampled sweeps
+    bool accepted;
+    int nrMoved;
+    double seconds;
+};
+
+struct BinRecord {
+    int level;
+    int sweep;
+    int bin;
+    int nrVertices;
+    int nrMoved;
+    float milliseconds; // kernel time
+};
+
+struct Telemetry {
+    std::vector<LevelRecord> levels;
+    std::vector<SweepRecord> sweeps;
+    std::vector<BinRecord> bins;
+
+    // Moves of the bins recorded for (level, sweep)
+    int movedInSweep(int level, int sweep) const;
+
+    // prefix_levels.csv, prefix_sweeps.csv and prefix_bins.csv
+    void writeCSV(const std::string& prefix) const;
+    void writeJSON(const std::string& fileName) const;
+};
+
+#endif	/* TELEMETRYHOST_H */